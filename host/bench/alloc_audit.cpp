@@ -0,0 +1,185 @@
+// Heap allocation audit of the steady-state pipeline: simulated SEN55 →
+// bus → Ui, history and MQTT, plus ESP-NOW nodes through the bridge, on a
+// scaled clock (default 100x real time).
+//
+//   cyd_alloc_audit [--seconds <simulated s>] [--speedup <x>]
+//
+// Everything is started and run through one MQTT drop and reconnect
+// (backlog replay, discovery) before counting starts; from then on,
+// including a second drop and reconnect, nothing may touch the heap.
+// Exits 1 with the counts if anything did. The host stand-in for the
+// CONFIG_AQM_ZERO_HEAP audit on the device (heap_audit.hpp).
+
+#include "alloc_count.hpp"
+
+#include "device_id.hpp"
+#include "espnow_bridge.hpp"
+#include "espnow_loopback.hpp"
+#include "espnow_protocol.h"
+#include "ha_discovery.hpp"
+#include "history.hpp"
+#include "measurement_bus.hpp"
+#include "mqtt.hpp"
+#include "sen55.hpp"
+#include "sen55_mqtt.hpp"
+#include "sen55_sim.hpp"
+#include "ui.hpp"
+
+#include "esp_log.h"
+#include "host_rtos.hpp"
+#include "mqtt_mock.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+struct Args {
+    double seconds = 600;
+    double speedup = 100;
+};
+
+Args ParseArgs(int argc, char** argv)
+{
+    Args a;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* k = argv[i];
+        const char* v = argv[i + 1];
+        if (std::strcmp(k, "--seconds") == 0)      a.seconds = std::atof(v);
+        else if (std::strcmp(k, "--speedup") == 0) a.speedup = std::atof(v);
+    }
+    return a;
+}
+
+double g_speedup = 1;
+EspNowBridge* g_bridge{};
+
+void SleepSimulated(double seconds)
+{
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds / g_speedup));
+}
+
+void OnConnect()
+{
+    ha_discovery_on_connect(device_id_get());
+    g_bridge->OnMqttConnect();
+}
+
+void OnData(const char* topic, int topic_len, const char* data, int data_len,
+            int offset, int total_len)
+{
+    if (ha_discovery_on_data(topic, topic_len, data, data_len, offset, total_len)) return;
+    g_bridge->OnMqttData(topic, topic_len, data, data_len, offset, total_len);
+}
+
+/// Broker away for `seconds`, then back: readings queue in the outbox and
+/// are replayed after discovery.
+void DropBroker(double seconds)
+{
+    mqtt_mock_set_connected(false);
+    SleepSimulated(seconds);
+    mqtt_mock_set_connected(true);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto args = ParseArgs(argc, argv);
+    esp_log_level_set("*", ESP_LOG_NONE);
+    host_rtos_set_speedup(args.speedup);
+    g_speedup = args.speedup;
+
+    device_id_init();
+    auto air_owned = std::make_unique<EspNowLoopback>();
+    auto* air = air_owned.get();
+    EspNowBridge bridge(std::move(air_owned));
+    g_bridge = &bridge;
+    mqtt_init(device_id_get(), OnConnect, OnData);
+    mqtt_mock_set_connected(true);
+
+    MeasurementBus bus;
+    History history({.raw = 3600, .minute = 168 * 60, .hour = 56 * 24});
+    history.Start(bus);
+    sen55_mqtt_start(bus);
+
+    // The LVGL task's share: poll the latest reading and redraw
+    Ui ui;
+    ui.SetHistory(&history);
+    ui.ShowTrend(History::Channel::kPm2_5, Ui::TrendRange::kHour);
+    auto* ui_sub = bus.Subscribe("ui", MeasurementBus::Mode::kLatest);
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> redraws{0};
+    std::thread ui_thread([&] {
+        while (!stop.load()) {
+            Sen55::Measurement m;
+            if (ui_sub->Pop(m)) {
+                ui.UpdateMeasurements(m);
+                ui.UpdateTrend();
+                ++redraws;
+            }
+            std::this_thread::sleep_for(std::chrono::duration<double>(0.2 / g_speedup));
+        }
+    });
+
+    // Eight nodes, one frame each every 5 s, as the Wi-Fi task would deliver
+    std::thread nodes_thread([&] {
+        uint16_t seq = 0;
+        while (!stop.load()) {
+            for (uint8_t node = 0; node < 8; ++node) {
+                const uint8_t mac[6] = {0x02, 0xAE, 0, 0, 0, node};
+                uint8_t frame[espnow::kMaxFrame];
+                const size_t len = espnow::Encode(
+                    espnow::FromValues<espnow::Pms5003>({5, 8, 11, 900, 300, 80, 12, 3, 1}),
+                    seq, frame);
+                air->Deliver(mac, frame, len);
+            }
+            ++seq;
+            std::this_thread::sleep_for(std::chrono::duration<double>(5.0 / g_speedup));
+        }
+    });
+
+    Sen55 sensor(std::make_unique<Sen55Sim>(Sen55Sim::Config{}),
+                 [&](const Sen55::Measurement& m) { bus.Publish(m); });
+
+    // Warm-up: every path once, including a reconnect and a latency report
+    SleepSimulated(120);
+    DropBroker(30);
+    SleepSimulated(90);
+
+    const auto before = bench::Allocations();
+    const auto published_before = bus.Published();
+    const auto mqtt_before = mqtt_mock_stats().publishes;
+    const auto redraws_before = redraws.load();
+    const auto espnow_before = bridge.GetStats().received;
+
+    SleepSimulated(args.seconds / 2);
+    DropBroker(30);
+    SleepSimulated(args.seconds / 2);
+
+    const auto after = bench::Allocations();
+    const auto readings = bus.Published() - published_before;
+    const auto publishes = mqtt_mock_stats().publishes - mqtt_before;
+    const auto redrawn = redraws.load() - redraws_before;
+    const auto espnow_frames = bridge.GetStats().received - espnow_before;
+
+    stop = true;
+    ui_thread.join();
+    nodes_thread.join();
+
+    const auto count = after.count - before.count;
+    const auto bytes = after.bytes - before.bytes;
+    std::printf("steady state: %.0f s simulated, %u readings, %llu MQTT publishes, "
+                "%llu redraws, %u ESP-NOW frames, 1 reconnect\n",
+                args.seconds, static_cast<unsigned>(readings),
+                static_cast<unsigned long long>(publishes),
+                static_cast<unsigned long long>(redrawn), static_cast<unsigned>(espnow_frames));
+    std::printf("allocations:  %llu (%llu bytes)\n",
+                static_cast<unsigned long long>(count),
+                static_cast<unsigned long long>(bytes));
+    return count == 0 ? 0 : 1;
+}
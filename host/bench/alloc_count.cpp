@@ -0,0 +1,70 @@
+#include "alloc_count.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+}
+
+namespace {
+
+std::atomic<uint64_t> s_count{0};
+std::atomic<uint64_t> s_bytes{0};
+
+void Record(size_t size)
+{
+    s_count.fetch_add(1, std::memory_order_relaxed);
+    s_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void *CountedNew(size_t size)
+{
+    Record(size);
+    if (auto *p = __real_malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+namespace bench {
+
+AllocSnapshot Allocations()
+{
+    return {s_count.load(std::memory_order_relaxed),
+            s_bytes.load(std::memory_order_relaxed)};
+}
+
+} // namespace bench
+
+extern "C" {
+
+void *__wrap_malloc(size_t size)
+{
+    Record(size);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    Record(n * size);
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    Record(size);
+    return __real_realloc(ptr, size);
+}
+
+} // extern "C"
+
+void *operator new(size_t size) { return CountedNew(size); }
+void *operator new[](size_t size) { return CountedNew(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
@@ -0,0 +1,18 @@
+#pragma once
+
+// Process-wide heap allocation counters for the host benchmarks. Counts
+// operator new plus malloc/calloc/realloc calls made from firmware and mock
+// objects (linked with -Wl,--wrap=malloc etc.).
+
+#include <cstdint>
+
+namespace bench {
+
+struct AllocSnapshot {
+    uint64_t count;
+    uint64_t bytes;
+};
+
+AllocSnapshot Allocations();
+
+} // namespace bench
@@ -0,0 +1,85 @@
+#pragma once
+
+// Tiny self-contained microbenchmark runner: ns/op and heap allocations
+// per op, printed as one table row per stage.
+
+#include "alloc_count.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace bench {
+
+struct Options {
+    const char* filter = nullptr;  // substring match on stage name
+    double min_time_ms = 200.0;
+};
+
+struct Result {
+    double ns_per_op;
+    double allocs_per_op;
+    double bytes_per_op;
+    uint64_t iterations;
+};
+
+/** Prevents the compiler from discarding a value computed in a benchmark. */
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void PrintHeader()
+{
+    std::printf("%-40s %12s %12s %12s %12s\n",
+                "stage", "ns/op", "allocs/op", "bytes/op", "iterations");
+}
+
+inline void PrintRow(const char* name, const Result& r)
+{
+    std::printf("%-40s %12.1f %12.2f %12.1f %12llu\n", name, r.ns_per_op,
+                r.allocs_per_op, r.bytes_per_op,
+                static_cast<unsigned long long>(r.iterations));
+}
+
+/**
+ * Runs `fn` in growing batches until a batch takes at least
+ * `opts.min_time_ms`, then prints and returns the per-op figures of that
+ * batch. Skips (returns zeros) when the name does not match the filter.
+ */
+template <typename Fn>
+Result Run(const Options& opts, const char* name, Fn&& fn)
+{
+    if (opts.filter && !std::strstr(name, opts.filter)) {
+        return {};
+    }
+
+    using Clock = std::chrono::steady_clock;
+    fn();  // warm-up: first-touch allocations, lazy statics
+
+    for (uint64_t n = 1;; n *= 2) {
+        const auto a0 = Allocations();
+        const auto t0 = Clock::now();
+        for (uint64_t i = 0; i < n; ++i) {
+            fn();
+        }
+        const auto t1 = Clock::now();
+        const auto a1 = Allocations();
+
+        const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        if (ns >= opts.min_time_ms * 1e6 || n >= (uint64_t{1} << 40)) {
+            const Result r{
+                ns / static_cast<double>(n),
+                static_cast<double>(a1.count - a0.count) / static_cast<double>(n),
+                static_cast<double>(a1.bytes - a0.bytes) / static_cast<double>(n),
+                n,
+            };
+            PrintRow(name, r);
+            return r;
+        }
+    }
+}
+
+} // namespace bench
@@ -0,0 +1,306 @@
+// Host microbenchmarks for the per-reading work done at 1 Hz on the device:
+// SEN55 frame decode, MQTT publish, HA discovery and the UI update.
+//
+//   cyd_bench [--filter <substring>] [--min-time-ms <ms>]
+
+#include "bench.hpp"
+
+#include "device_id.hpp"
+#include "ha_discovery.hpp"
+#include "history.hpp"
+#include "measurement_bus.hpp"
+#include "mqtt.hpp"
+#include "outbox.hpp"
+#include "sen55_frame.hpp"
+#include "sen55_mqtt.hpp"
+#include "ui.hpp"
+
+#include "esp_log.h"
+#include "host_flash.hpp"
+#include "lvgl_mock.hpp"
+#include "mqtt_mock.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kFrameBytes = sen55_frame::kMeasuredWordCount * sen55_frame::kBytesPerWord;
+constexpr size_t kSequenceLen = 64;
+
+using Frame = std::array<uint8_t, kFrameBytes>;
+
+/// A minute of plausible readings that wander across severity boundaries.
+std::array<Frame, kSequenceLen> MakeFrames()
+{
+    std::array<Frame, kSequenceLen> frames{};
+    for (size_t i = 0; i < kSequenceLen; ++i) {
+        const auto k = static_cast<uint16_t>(i);
+        const sen55_frame::MeasuredWords words = {
+            static_cast<uint16_t>(50 + k * 7),           // PM1.0  x10
+            static_cast<uint16_t>(80 + k * 9),           // PM2.5  x10
+            static_cast<uint16_t>(95 + k * 11),          // PM4.0  x10
+            static_cast<uint16_t>(110 + k * 13),         // PM10   x10
+            static_cast<uint16_t>(4500 + k * 20),        // RH     x100
+            static_cast<uint16_t>(4300 + k * 15),        // T      x200
+            static_cast<uint16_t>(1000 + k * 50),        // VOC    x10
+            static_cast<uint16_t>(10 + k * 30),          // NOx    x10
+        };
+        sen55_frame::EncodeWords(words.data(), words.size(), frames[i].data());
+    }
+    return frames;
+}
+
+void OnData(const char* topic, int topic_len, const char* data, int data_len,
+            int offset, int total_len)
+{
+    ha_discovery_on_data(topic, topic_len, data, data_len, offset, total_len);
+}
+
+bench::Options ParseArgs(int argc, char** argv)
+{
+    bench::Options opts;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            opts.filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--min-time-ms") == 0 && i + 1 < argc) {
+            opts.min_time_ms = std::atof(argv[++i]);
+        }
+    }
+    return opts;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto opts = ParseArgs(argc, argv);
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    device_id_init();
+    mqtt_init(device_id_get(), nullptr, OnData);
+    mqtt_mock_set_connected(true);
+
+    const auto frames = MakeFrames();
+    std::array<Sen55::Measurement, kSequenceLen> readings{};
+    for (size_t i = 0; i < kSequenceLen; ++i) {
+        sen55_frame::MeasuredWords words{};
+        sen55_frame::DecodeWords(frames[i].data(), words.data(), words.size());
+        readings[i] = sen55_frame::DecodeMeasurement(words);
+    }
+
+    Ui ui;
+    size_t n = 0;
+
+    bench::PrintHeader();
+
+    bench::Run(opts, "sen55/crc8 (1 word)", [&] {
+        bench::DoNotOptimize(sen55_frame::Crc8(frames[n++ % kSequenceLen].data(), 2));
+    });
+
+    bench::Run(opts, "sen55/decode (8 words + scale)", [&] {
+        sen55_frame::MeasuredWords words{};
+        sen55_frame::DecodeWords(frames[n++ % kSequenceLen].data(), words.data(), words.size());
+        bench::DoNotOptimize(sen55_frame::DecodeMeasurement(words));
+    });
+
+    sen55_mqtt_set_format(Sen55MqttFormat::kPerTopic);
+    bench::Run(opts, "mqtt/publish_sen55 (per-topic)", [&] {
+        publish_sen55(readings[n++ % kSequenceLen]);
+    });
+
+    ha_discovery_set_mode(HaDiscoveryMode::kEntity);
+    bench::Run(opts, "ha_discovery/publish (per-entity, per-topic)", [&] {
+        ha_discovery_publish(device_id_get());
+    });
+
+    sen55_mqtt_set_format(Sen55MqttFormat::kJson);
+    bench::Run(opts, "mqtt/publish_sen55 (json)", [&] {
+        publish_sen55(readings[n++ % kSequenceLen]);
+    });
+
+    bench::Run(opts, "ha_discovery/publish (per-entity, json)", [&] {
+        ha_discovery_publish(device_id_get());
+    });
+
+    ha_discovery_set_mode(HaDiscoveryMode::kDevice);
+    bench::Run(opts, "ha_discovery/publish (device, json)", [&] {
+        ha_discovery_publish(device_id_get());
+    });
+
+    // The broker now retains it: read back, hashed, nothing republished
+    bench::Run(opts, "ha_discovery/on_connect (retained match)", [&] {
+        ha_discovery_on_connect(device_id_get());
+    });
+
+    bench::Run(opts, "ui/UpdateMeasurements", [&] {
+        ui.UpdateMeasurements(readings[n++ % kSequenceLen]);
+    });
+
+    bench::Run(opts, "ui/UpdateMeasurements (unchanged)", [&] {
+        ui.UpdateMeasurements(readings[0]);
+    });
+
+    MeasurementBus bus;
+    auto* latest = bus.Subscribe("ui", MeasurementBus::Mode::kLatest);
+    auto* queue = bus.Subscribe("mqtt", MeasurementBus::Mode::kQueue, 8);
+    bus.Subscribe("history", MeasurementBus::Mode::kQueue, 16);  // never drained: drops
+
+    bench::Run(opts, "bus/publish (3 subscribers)", [&] {
+        bus.Publish(readings[n++ % kSequenceLen]);
+    });
+
+    bench::Run(opts, "bus/publish+pop (latest, queue)", [&] {
+        Sen55::Measurement m;
+        bus.Publish(readings[n++ % kSequenceLen]);
+        latest->Pop(m);
+        queue->Pop(m);
+        bench::DoNotOptimize(m);
+    });
+
+    bench::Run(opts, "cycle/decode+ui+publish", [&] {
+        const auto& frame = frames[n++ % kSequenceLen];
+        sen55_frame::MeasuredWords words{};
+        sen55_frame::DecodeWords(frame.data(), words.data(), words.size());
+        const auto m = sen55_frame::DecodeMeasurement(words);
+        ui.UpdateMeasurements(m);
+        publish_sen55(m);
+    });
+
+    // Default tier sizes; time advances 1 s per append so every 60th
+    // closes a minute bucket and every 3600th an hour.
+    History history({.raw = 3600, .minute = 168 * 60, .hour = 56 * 24});
+    int64_t t_us = 0;
+    bench::Run(opts, "history/append (1 s cadence)", [&] {
+        history.Append(t_us += 1'000'000, readings[n++ % kSequenceLen]);
+    });
+
+    bench::Run(opts, "history/scan raw pm2_5 (3600, in place)", [&] {
+        const auto view = history.Read();
+        const auto col = view.Values(History::Tier::kRaw, History::Channel::kPm2_5);
+        float max = 0;
+        for (auto run : {col.Head(), col.Tail()}) {
+            for (float v : run) max = std::max(max, v);
+        }
+        bench::DoNotOptimize(max);
+    });
+
+    ui.SetHistory(&history);
+    bench::Run(opts, "ui/ShowTrend (24 h fill, 240 points)", [&] {
+        ui.ShowTrend(History::Channel::kPm2_5, Ui::TrendRange::kDay);
+    });
+
+    // Per reading on the trend screen: every 15th completes a point
+    ui.ShowTrend(History::Channel::kPm2_5, Ui::TrendRange::kHour);
+    bench::Run(opts, "ui/history.Append+UpdateTrend (hour)", [&] {
+        history.Append(t_us += 1'000'000, readings[n++ % kSequenceLen]);
+        ui.UpdateTrend();
+    });
+
+    lv_mock_reset_stats();
+    for (int i = 0; i < 15 * 4; ++i) {
+        history.Append(t_us += 1'000'000, readings[n++ % kSequenceLen]);
+        ui.UpdateTrend();
+    }
+    const auto& lt = lv_mock_stats();
+    std::printf("\ntrend, 60 readings: %llu points, %llu invalidations (chart only), "
+                "%llu range changes\n",
+                static_cast<unsigned long long>(lt.chart_points),
+                static_cast<unsigned long long>(lt.invalidations),
+                static_cast<unsigned long long>(lt.chart_range_changes));
+    ui.ShowCards();
+
+    // RAM-only: one push and one drain per op, depth stays at zero.
+    Outbox ram_outbox(64, nullptr);
+    bench::Run(opts, "outbox/push+peek+pop (ram)", [&] {
+        Outbox::Record r;
+        ram_outbox.Push(0, readings[n++ % kSequenceLen]);
+        ram_outbox.Peek(&r, 1);
+        ram_outbox.Pop(1);
+        bench::DoNotOptimize(r);
+    });
+
+    // Small RAM ring in front of flash: every 72 pushes spill one sector,
+    // and the drain reads it back. Approximates a long outage's replay.
+    const auto* part = host_flash_add_partition("outbox", 0x40, 0x100000);
+    {
+        Outbox outbox(128, "outbox");
+        for (int i = 0; i < 1024; ++i) outbox.Push(0, readings[i % kSequenceLen]);
+        bench::Run(opts, "outbox/push+peek+pop (spill)", [&] {
+            Outbox::Record r[10];
+            outbox.Push(0, readings[n++ % kSequenceLen]);
+            if (n % 10 == 0) {
+                bench::DoNotOptimize(outbox.Peek(r, 10));
+                outbox.Pop(10);
+            }
+        });
+        const auto s = outbox.GetStats();
+        const auto f = host_flash_stats(part);
+        std::printf("\noutbox: depth %u (flash %u), spilled %u, replayed %u; "
+                    "flash %llu B written, %llu erases, max %u per sector\n",
+                    s.depth, s.flash_depth, s.spilled, s.replayed,
+                    static_cast<unsigned long long>(f.bytes_written),
+                    static_cast<unsigned long long>(f.sector_erases),
+                    f.max_erases_per_sector);
+    }
+
+    // Side-effect counts per call — what the mocks saw, not what they cost.
+    // A repeated reading should touch nothing; a sweep through the sequence
+    // shows what a typical change costs.
+    const auto& lv = lv_mock_stats();
+    auto print_ui_calls = [&](const char* label, size_t calls, const Ui::UpdateStats& before) {
+        const auto after = ui.GetUpdateStats();
+        std::printf("per UpdateMeasurements (%s): %.1f label_set_text, %.1f image_set_src, "
+                    "%.1f style_add, %.1f style_remove, %.1f invalidations, "
+                    "%.0f px invalidated\n",
+                    label,
+                    double(lv.label_set_text) / calls, double(lv.image_set_src) / calls,
+                    double(lv.style_add) / calls,
+                    double(lv.style_remove) / calls, double(lv.invalidations) / calls,
+                    double(after.invalidated_px - before.invalidated_px) / calls);
+    };
+    std::printf("\n");
+    ui.UpdateMeasurements(readings[0]);
+    lv_mock_reset_stats();
+    auto before = ui.GetUpdateStats();
+    ui.UpdateMeasurements(readings[0]);
+    print_ui_calls("unchanged", 1, before);
+    lv_mock_reset_stats();
+    before = ui.GetUpdateStats();
+    for (size_t i = 1; i <= kSequenceLen; ++i) ui.UpdateMeasurements(readings[i % kSequenceLen]);
+    print_ui_calls("sequence", kSequenceLen, before);
+
+    const auto& mq = mqtt_mock_stats();
+    for (auto format : {Sen55MqttFormat::kPerTopic, Sen55MqttFormat::kJson}) {
+        const char* label = format == Sen55MqttFormat::kJson ? "json" : "per-topic";
+        sen55_mqtt_set_format(format);
+
+        mqtt_mock_reset_stats();
+        publish_sen55(readings[0]);
+        std::printf("per publish_sen55 (%s): %llu messages, %llu payload bytes\n", label,
+                    static_cast<unsigned long long>(mq.publishes),
+                    static_cast<unsigned long long>(mq.payload_bytes));
+
+        for (auto mode : {HaDiscoveryMode::kEntity, HaDiscoveryMode::kDevice}) {
+            ha_discovery_set_mode(mode);
+            mqtt_mock_clear_retained();
+            mqtt_mock_reset_stats();
+            ha_discovery_publish(device_id_get());
+            std::printf("per discovery (%s, %s): %llu messages, %llu payload bytes\n",
+                        mode == HaDiscoveryMode::kDevice ? "device" : "per-entity", label,
+                        static_cast<unsigned long long>(mq.publishes),
+                        static_cast<unsigned long long>(mq.payload_bytes));
+        }
+    }
+    // Device mode after a publish: a reconnect finds every config retained
+    mqtt_mock_reset_stats();
+    ha_discovery_on_connect(device_id_get());
+    std::printf("per reconnect (retained match): %llu messages\n",
+                static_cast<unsigned long long>(mq.publishes));
+
+    publish_sen55(readings[0]);
+    std::printf("\n%s %s\n", mqtt_mock_last().topic, mqtt_mock_last().data);
+    return 0;
+}
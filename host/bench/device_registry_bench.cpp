@@ -0,0 +1,266 @@
+// Device registry at fleet scale: MAC lookup cost against the linear scan
+// it replaces, then a heartbeat run on a simulated clock.
+//
+//   cyd_device_registry [--peers <n>] [--hours <simulated h>]
+//                       [--interval <s>] [--timeout <s>] [--silent <fraction>]
+//
+// In the heartbeat run every node reports each --interval seconds (±20 %
+// jitter). --silent of them stop a third of the way in and half of those
+// return at two thirds. The broker is unreachable while the silent ones
+// time out. Exits 1 unless every node went offline within a wheel tick of
+// its timeout, no transition was published twice, and the broker ends up
+// holding every node's current state.
+
+#include "bench.hpp"
+#include "device_registry.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct Args {
+    size_t peers = 1000;
+    double hours = 2;
+    uint32_t interval_s = 30;
+    uint32_t timeout_s = 90;
+    double silent = 0.1;
+};
+
+Args ParseArgs(int argc, char** argv)
+{
+    Args a;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* k = argv[i];
+        const char* v = argv[i + 1];
+        if (std::strcmp(k, "--peers") == 0)         a.peers = std::strtoul(v, nullptr, 10);
+        else if (std::strcmp(k, "--hours") == 0)    a.hours = std::atof(v);
+        else if (std::strcmp(k, "--interval") == 0) a.interval_s = std::strtoul(v, nullptr, 10);
+        else if (std::strcmp(k, "--timeout") == 0)  a.timeout_s = std::strtoul(v, nullptr, 10);
+        else if (std::strcmp(k, "--silent") == 0)   a.silent = std::atof(v);
+    }
+    a.peers = std::clamp<size_t>(a.peers, 1, 65534);
+    return a;
+}
+
+struct Mac {
+    uint8_t b[6];
+};
+
+/** One vendor's OUI, random NIC half: the realistic worst case for hashing. */
+std::vector<Mac> MakeFleet(size_t n, std::mt19937& rng)
+{
+    std::vector<Mac> macs(n);
+    for (auto& m : macs) {
+        const uint32_t nic = rng();
+        const uint8_t b[6] = {0x24, 0x6F, 0x28, static_cast<uint8_t>(nic >> 16),
+                              static_cast<uint8_t>(nic >> 8), static_cast<uint8_t>(nic)};
+        std::memcpy(m.b, b, sizeof(b));
+    }
+    return macs;
+}
+
+struct Changes {
+    bool broker_up = true;
+    uint64_t delivered = 0;
+    uint64_t refused = 0;
+    std::vector<uint8_t> retained;    // by id: 0 none, 1 online, 2 offline
+};
+
+bool OnChange(void* ctx, int id, const uint8_t*, bool online)
+{
+    auto* c = static_cast<Changes*>(ctx);
+    if (!c->broker_up) {
+        ++c->refused;
+        return false;
+    }
+    ++c->delivered;
+    c->retained[id] = online ? 1 : 2;
+    return true;
+}
+
+bool Ignore(void*, int, const uint8_t*, bool)
+{
+    return true;
+}
+
+/* ── Lookup ──────────────────────────────────────────────────────────── */
+
+void RunLookups(const Args& args)
+{
+    std::mt19937 rng(7);
+    const auto macs = MakeFleet(args.peers, rng);
+    std::vector<uint32_t> order(4096);
+    for (auto& i : order) i = rng() % macs.size();
+
+    DeviceRegistry reg({.max_devices = args.peers, .timeout_s = 3600, .tick_ms = 1000},
+                       Ignore, nullptr);
+    for (const auto& m : macs) reg.Touch(m.b, 0);
+
+    bench::Options opts;
+    bench::PrintHeader();
+    size_t k = 0;
+    int64_t now = 0;
+    char name[64];
+    std::snprintf(name, sizeof(name), "registry/Touch (%zu peers)", args.peers);
+    bench::Run(opts, name, [&] {
+        const auto& m = macs[order[k++ & 4095]];
+        bench::DoNotOptimize(reg.Touch(m.b, now += 1000));
+    });
+
+    // The bridge's table before the registry
+    std::snprintf(name, sizeof(name), "linear scan (%zu peers)", args.peers);
+    bench::Run(opts, name, [&] {
+        const auto& m = macs[order[k++ & 4095]];
+        size_t i = 0;
+        while (i < macs.size() && std::memcmp(macs[i].b, m.b, 6) != 0) ++i;
+        bench::DoNotOptimize(i);
+    });
+
+    std::snprintf(name, sizeof(name), "registry/Find miss (%zu peers)", args.peers);
+    const uint8_t stranger[6] = {0x02, 0, 0, 0, 0, 1};
+    bench::Run(opts, name, [&] { bench::DoNotOptimize(reg.Find(stranger)); });
+
+    const auto s = reg.GetStats();
+    std::printf("probes per lookup: %.2f mean, %u max\n\n",
+                static_cast<double>(s.probes) / static_cast<double>(s.lookups), s.max_probes);
+}
+
+/* ── Heartbeat ───────────────────────────────────────────────────────── */
+
+bool RunHeartbeat(const Args& args)
+{
+    std::mt19937 rng(11);
+    const auto macs = MakeFleet(args.peers, rng);
+    const int64_t end_us = static_cast<int64_t>(args.hours * 3600e6);
+    const int64_t step_us = 100'000;
+    const int64_t stop_us = end_us / 3;
+    const int64_t back_us = 2 * end_us / 3;
+    const int64_t interval_us = static_cast<int64_t>(args.interval_s) * 1'000'000;
+    const int64_t timeout_us = static_cast<int64_t>(args.timeout_s) * 1'000'000;
+    // Broker away while the silent nodes time out
+    const int64_t outage_from = stop_us;
+    const int64_t outage_to = stop_us + 2 * timeout_us;
+    std::uniform_int_distribution<int64_t> jitter(interval_us * 8 / 10, interval_us * 12 / 10);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+
+    struct Node {
+        int64_t next_us;
+        int64_t last_us = -1;
+        bool silent;    // stops at stop_us
+        bool returns;   // and starts again at back_us
+    };
+    std::vector<Node> nodes(args.peers);
+    for (auto& n : nodes) {
+        n.next_us = jitter(rng) % interval_us;
+        n.silent = coin(rng) < args.silent;
+        n.returns = n.silent && coin(rng) < 0.5;
+    }
+
+    Changes changes;
+    changes.retained.assign(args.peers, 0);
+    DeviceRegistry reg(
+        {.max_devices = args.peers, .timeout_s = args.timeout_s, .tick_ms = 1000}, OnChange,
+        &changes);
+    std::vector<int> id_of(args.peers, -1);
+    std::vector<int64_t> last_before_offline(args.peers, -1);
+
+    using Clock = std::chrono::steady_clock;
+    double advance_ns = 0;
+    uint64_t advances = 0, skipped = 0, packets = 0;
+    bool late = false;
+
+    for (int64_t t = 0; t < end_us; t += step_us) {
+        changes.broker_up = t < outage_from || t >= outage_to;
+        if (t == outage_to) reg.Retry();
+
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            auto& n = nodes[i];
+            if (n.next_us > t) continue;
+            n.next_us += jitter(rng);
+            if (n.silent && t >= stop_us && !(n.returns && t >= back_us)) continue;
+            const int id = reg.Touch(macs[i].b, t);
+            id_of[i] = id;
+            n.last_us = t;
+            ++packets;
+        }
+
+        // The bridge sleeps until NextDeadline(); count the wake-ups it saves
+        if (reg.NextDeadline() > t) {
+            ++skipped;
+            continue;
+        }
+        const auto t0 = Clock::now();
+        reg.Advance(t);
+        advance_ns += std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        ++advances;
+
+        // Detection latency: offline no earlier than the timeout, no later
+        // than a tick after it
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            const int id = id_of[i];
+            if (id < 0 || reg.IsOnline(id) || last_before_offline[i] == nodes[i].last_us) {
+                continue;
+            }
+            last_before_offline[i] = nodes[i].last_us;
+            const int64_t silence = t - nodes[i].last_us;
+            if (silence < timeout_us || silence > timeout_us + 2'000'000) {
+                std::printf("node %zu offline after %.1f s of silence\n", i, silence / 1e6);
+                late = true;
+            }
+        }
+    }
+
+    // Expected: every node online once; the silent ones offline, the
+    // returning ones online again. Each published once (refused ones on the
+    // retry), or not at all if it was undone before the retry.
+    size_t silent = 0, returned = 0;
+    for (const auto& n : nodes) {
+        silent += n.silent;
+        returned += n.returns;
+    }
+    const uint64_t expected = args.peers + silent + returned;
+
+    // After the outage the retained state must match the registry's
+    size_t stale = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const int id = id_of[i];
+        if (changes.retained[id] != (reg.IsOnline(id) ? 1 : 2)) ++stale;
+    }
+
+    const auto s = reg.GetStats();
+    std::printf("heartbeat: %zu peers, %.1f h simulated, %u s interval, %u s timeout\n",
+                args.peers, args.hours, args.interval_s, args.timeout_s);
+    std::printf("  packets:       %llu (%.1f/s)\n", static_cast<unsigned long long>(packets),
+                static_cast<double>(packets) / (static_cast<double>(end_us) / 1e6));
+    std::printf("  availability:  %llu transitions (%zu silent, %zu returned), "
+                "%llu published, %llu refused during the outage and retried\n",
+                static_cast<unsigned long long>(expected), silent, returned,
+                static_cast<unsigned long long>(changes.delivered),
+                static_cast<unsigned long long>(changes.refused));
+    std::printf("  retained:      %zu stale of %zu\n", stale, args.peers);
+    std::printf("  wheel:         %u rearms, %u cascades, %u expirations\n", s.rearms, s.cascades,
+                s.expirations);
+    std::printf("  Advance():     %llu calls, %.0f ns mean; %llu of %llu 100 ms steps "
+                "slept through\n",
+                static_cast<unsigned long long>(advances),
+                advances ? advance_ns / static_cast<double>(advances) : 0.0,
+                static_cast<unsigned long long>(skipped),
+                static_cast<unsigned long long>(skipped + advances));
+    std::printf("  online at end: %zu\n", reg.Online());
+
+    return !late && changes.delivered <= expected && stale == 0 && s.expirations == silent;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto args = ParseArgs(argc, argv);
+    RunLookups(args);
+    return RunHeartbeat(args) ? 0 : 1;
+}
@@ -0,0 +1,323 @@
+// Home Assistant discovery for a gateway's ESP-NOW fleet, on a simulated
+// clock: the esp-mqtt outbox drains at --link bytes/s while the configs go
+// out, all at once (as ha_discovery does for the monitor's own entities)
+// or through the DiscoveryScheduler.
+//
+//   cyd_discovery [--peers <n>] [--link <bytes/s>]
+//
+// Then, scheduled: a reconnect with every config retained, a reboot (the
+// nodes are heard again one by one after the retained check), a broker
+// that lost its retained messages with a new node arriving mid-backlog,
+// and a node that changes its message type. Exits 1 unless the outbox
+// stays within the limit plus one config, nothing retained is republished,
+// the new node goes out first, and the broker ends up with every config.
+
+#include "device_id.hpp"
+#include "discovery_scheduler.hpp"
+#include "espnow_protocol.h"
+#include "ha_discovery.hpp"
+#include "mqtt.hpp"
+
+#include "esp_log.h"
+#include "mqtt_mock.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Args {
+    size_t peers = 64;
+    uint32_t link = 16 * 1024;
+};
+
+Args ParseArgs(int argc, char** argv)
+{
+    Args a;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* k = argv[i];
+        const char* v = argv[i + 1];
+        if (std::strcmp(k, "--peers") == 0)     a.peers = std::strtoul(v, nullptr, 10);
+        else if (std::strcmp(k, "--link") == 0) a.link = std::strtoul(v, nullptr, 10);
+    }
+    // The broker stand-in retains 160 topics
+    a.peers = std::clamp<size_t>(a.peers, 2, 150);
+    a.link = std::max<uint32_t>(a.link, 1024);
+    return a;
+}
+
+struct Node {
+    char mac[13];
+    uint8_t type;
+    bool heard;  // registered with the gateway
+};
+
+std::vector<Node> g_nodes;
+DiscoveryScheduler* g_sched{};
+std::vector<std::string> g_published;  // topics, in the order they went out
+
+size_t Write(void*, int id, char* topic, size_t topic_size, char* config, size_t size)
+{
+    const Node& n = g_nodes[id];
+    return ha_discovery_write_node(device_id_get(), n.mac, n.type, topic, topic_size, config,
+                                   size);
+}
+
+bool Resolve(void*, const char* topic, int topic_len, int* id, uint64_t* key)
+{
+    char prefix[64];
+    const int prefix_len =
+        std::snprintf(prefix, sizeof(prefix), "homeassistant/device/%s/", device_id_get());
+    if (topic_len != prefix_len + 12 + 7 || std::memcmp(topic, prefix, prefix_len) != 0) {
+        return false;
+    }
+    *id = -1;
+    *key = 0;
+    for (size_t i = 0; i < g_nodes.size(); ++i) {
+        if (std::memcmp(g_nodes[i].mac, topic + prefix_len, 12) == 0) {
+            *key = i + 1;
+            if (g_nodes[i].heard) *id = static_cast<int>(i);
+        }
+    }
+    return true;
+}
+
+void OnData(const char* topic, int topic_len, const char* data, int data_len, int offset,
+            int total_len)
+{
+    if (g_sched && g_sched->OnData(topic, topic_len, data, data_len, offset, total_len)) return;
+    if (offset == 0) g_published.emplace_back(topic, topic_len);
+}
+
+struct Run {
+    double seconds;     // until the queue was empty
+    uint64_t published;
+    uint64_t bytes;
+    uint64_t outbox_peak;
+};
+
+/**
+ * Advances the clock in 10 ms steps, draining the outbox at the link
+ * rate, until the scheduler is idle and the outbox empty. `on_step` runs
+ * before each Pump().
+ */
+template <typename Fn>
+Run Simulate(DiscoveryScheduler& sched, int64_t* now, uint32_t link, Fn&& on_step)
+{
+    const int64_t step = 10'000;
+    mqtt_mock_reset_stats();
+    const int64_t start = *now;
+    int64_t next = *now;
+    int64_t done = -1;
+    for (int i = 0; i < 100'000; ++i) {
+        on_step(*now);
+        if (*now >= next) next = sched.Pump(*now);
+        if (next == INT64_MAX && mqtt_outbox_bytes() == 0) {
+            done = *now;
+            break;
+        }
+        *now += step;
+        mqtt_mock_drain_outbox(link / 100);
+    }
+    const auto s = mqtt_mock_stats();
+    return {(done < 0 ? *now - start : done - start) / 1e6, s.publishes, s.payload_bytes,
+            s.outbox_peak};
+}
+
+/** Every node's retained config on the broker matches what it would publish now. */
+bool BrokerCurrent()
+{
+    char topic[96];
+    char config[4096];
+    size_t missing = 0;
+    // Subscribing to a topic delivers its retained copy, piece by piece
+    struct Probe {
+        const char* want;
+        size_t len;
+        bool seen;
+        bool same;
+    };
+    static Probe probe;
+    mqtt_init(device_id_get(), nullptr, [](const char*, int, const char* data, int data_len,
+                                           int offset, int total_len) {
+        if (offset == 0) {
+            probe.seen = true;
+            probe.same = static_cast<size_t>(total_len) == probe.len;
+        }
+        probe.same = probe.same && std::memcmp(probe.want + offset, data, data_len) == 0;
+    });
+    for (size_t i = 0; i < g_nodes.size(); ++i) {
+        const size_t len = Write(nullptr, static_cast<int>(i), topic, sizeof(topic), config,
+                                 sizeof(config));
+        probe = {config, len, false, false};
+        mqtt_subscribe(topic, 0);
+        mqtt_unsubscribe(topic);
+        if (!probe.seen || !probe.same) ++missing;
+    }
+    mqtt_init(device_id_get(), nullptr, OnData);
+    return missing == 0;
+}
+
+void Print(const char* name, const Run& r, const DiscoveryScheduler::Stats* s)
+{
+    std::printf("%-30s %4llu configs %7llu bytes in %6.1f s, outbox peak %6llu B",
+                name, static_cast<unsigned long long>(r.published),
+                static_cast<unsigned long long>(r.bytes), r.seconds,
+                static_cast<unsigned long long>(r.outbox_peak));
+    if (s) {
+        std::printf(", %u retained, %u throttled, %u outbox waits", s->retained, s->throttled,
+                    s->outbox_waits);
+    }
+    std::printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto args = ParseArgs(argc, argv);
+    esp_log_level_set("*", ESP_LOG_NONE);
+    device_id_init();
+    mqtt_init(device_id_get(), nullptr, OnData);
+    mqtt_mock_set_connected(true);
+    mqtt_mock_track_outbox(true);
+    // Echoes every config published, for the order
+    mqtt_subscribe("homeassistant/device/#", 0);
+
+    // A mixed fleet: PMS5003s, SEN55s and a few PWM controllers
+    g_nodes.resize(args.peers + 1);
+    for (size_t i = 0; i < g_nodes.size(); ++i) {
+        auto& n = g_nodes[i];
+        std::snprintf(n.mac, sizeof(n.mac), "02ae%08x", static_cast<unsigned>(i));
+        n.type = static_cast<uint8_t>(i % 5 == 4 ? espnow::MsgType::kPwm12v
+                                      : i % 2    ? espnow::MsgType::kSen55
+                                                 : espnow::MsgType::kPms5003);
+    }
+    const int newcomer = static_cast<int>(args.peers);  // arrives in scenario 5
+
+    auto cfg = DiscoveryScheduler::Config::Default();
+    cfg.max_devices = g_nodes.size();
+    char filter[80];
+    std::snprintf(filter, sizeof(filter), "homeassistant/device/%s/+/config", device_id_get());
+
+    size_t largest = 0;
+    for (size_t i = 0; i < g_nodes.size(); ++i) {
+        char topic[96];
+        char config[8192];
+        largest = std::max(largest, Write(nullptr, static_cast<int>(i), topic, sizeof(topic),
+                                          config, sizeof(config)));
+    }
+    std::printf("fleet: %zu nodes, largest config %zu bytes (limit %zu), link %u B/s, "
+                "outbox limit %zu B\n\n",
+                args.peers, largest, cfg.max_config, args.link, cfg.outbox_bytes);
+    bool ok = largest > 0 && largest <= cfg.max_config;
+
+    int64_t now = 0;
+    auto hear_all = [&](DiscoveryScheduler& s) {
+        for (size_t i = 0; i < args.peers; ++i) {
+            g_nodes[i].heard = true;
+            s.Update(static_cast<int>(i), i + 1);
+        }
+    };
+
+    // 1. Everything at once, as on the first connect without a scheduler
+    {
+        auto burst = cfg;
+        burst.messages_per_s = 0;
+        burst.bytes_per_s = 0;
+        burst.outbox_bytes = 0;
+        DiscoveryScheduler sched(burst, filter, Write, Resolve, nullptr);
+        g_sched = &sched;
+        sched.OnConnect(now);
+        hear_all(sched);
+        const auto r = Simulate(sched, &now, args.link, [](int64_t) {});
+        Print("unpaced", r, nullptr);
+        mqtt_mock_clear_retained();
+        for (auto& n : g_nodes) n.heard = false;
+    }
+
+    // 2. The same through the scheduler, on a fresh broker
+    auto sched = std::make_unique<DiscoveryScheduler>(cfg, filter, Write, Resolve, nullptr);
+    g_sched = sched.get();
+    sched->OnConnect(now);
+    hear_all(*sched);
+    auto r = Simulate(*sched, &now, args.link, [](int64_t) {});
+    Print("scheduled, first connect", r, nullptr);
+    ok = ok && r.published == args.peers && r.outbox_peak <= cfg.outbox_bytes + largest;
+
+    // 3. Reconnect: the broker has them all
+    sched->OnConnect(now);
+    r = Simulate(*sched, &now, args.link, [](int64_t) {});
+    auto s = sched->GetStats();
+    Print("reconnect, all retained", r, &s);
+    ok = ok && r.published == 0;
+
+    // 4. Reboot: nothing registered yet; a node or two is heard during the
+    //    retained check, the rest after it
+    sched = std::make_unique<DiscoveryScheduler>(cfg, filter, Write, Resolve, nullptr);
+    g_sched = sched.get();
+    for (auto& n : g_nodes) n.heard = false;
+    sched->OnConnect(now);
+    size_t heard = 0;
+    const int64_t boot = now;
+    r = Simulate(*sched, &now, args.link, [&](int64_t t) {
+        const auto due = static_cast<size_t>((t - boot) / 1'000'000) + 1;
+        while (heard < std::min(due, args.peers)) {
+            g_nodes[heard].heard = true;
+            g_sched->Update(static_cast<int>(heard), heard + 1);
+            ++heard;
+        }
+    });
+    // The rest
+    while (heard < args.peers) {
+        g_nodes[heard].heard = true;
+        sched->Update(static_cast<int>(heard), heard + 1);
+        ++heard;
+    }
+    const auto r4 = Simulate(*sched, &now, args.link, [](int64_t) {});
+    r.published += r4.published;
+    s = sched->GetStats();
+    Print("reboot, nodes heard again", r, &s);
+    ok = ok && r.published == 0 && s.retained == args.peers;
+
+    // 5. The broker lost its retained messages; a new node turns up while
+    //    the backlog is going out and must not wait behind it
+    mqtt_mock_clear_retained();
+    sched->OnConnect(now);
+    g_published.clear();
+    size_t arrived_at = SIZE_MAX;
+    r = Simulate(*sched, &now, args.link, [&](int64_t) {
+        if (arrived_at == SIZE_MAX && g_published.size() >= 3) {
+            arrived_at = g_published.size();
+            g_nodes[newcomer].heard = true;
+            g_sched->Update(newcomer, newcomer + 1);
+        }
+    });
+    char newcomer_topic[96];
+    char config[4096];
+    Write(nullptr, newcomer, newcomer_topic, sizeof(newcomer_topic), config, sizeof(config));
+    const auto it = std::find(g_published.begin(), g_published.end(), newcomer_topic);
+    const size_t position = it - g_published.begin();
+    s = sched->GetStats();
+    Print("broker lost retained + newcomer", r, &s);
+    std::printf("%-30s newcomer arrived after %zu of %zu, went out as #%zu\n", "", arrived_at,
+                args.peers, position + 1);
+    ok = ok && r.published == args.peers + 1 && position == arrived_at &&
+         r.outbox_peak <= cfg.outbox_bytes + largest;
+
+    // 6. A node starts sending another message type
+    g_nodes[1].type = static_cast<uint8_t>(espnow::MsgType::kPms5003);
+    sched->Update(1, 2);
+    r = Simulate(*sched, &now, args.link, [](int64_t) {});
+    Print("node changed type", r, nullptr);
+    ok = ok && r.published == 1;
+
+    const bool current = BrokerCurrent();
+    std::printf("\nbroker holds every current config: %s\n", current ? "yes" : "NO");
+    return ok && current ? 0 : 1;
+}
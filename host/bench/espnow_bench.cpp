@@ -0,0 +1,288 @@
+// ESP-NOW bridge under a simulated fleet: SEN55, PMS5003 and PWM12V nodes
+// send numbered readings through the loopback transport at a fixed aggregate rate, with loss,
+// duplication and reordering injected on the "air".
+//
+//   cyd_espnow_bench [--peers <n>] [--frames <per peer>] [--rate <frames/s>]
+//                    [--loss <p>] [--dup <p>] [--reorder <p>]
+//
+// Reports the receive hook's cost per frame, ring overflows, frames per
+// MQTT batch, and the loss / duplicate counts the bridge derived from the
+// sequence numbers next to the ones injected, then checks three nodes whose
+// sequence misbehaves: one reboots before it gets past the reordering
+// window, one's first frames after a reboot are lost, and one has an old
+// frame replayed. Exits 1 if any count disagrees or the ring overflowed
+// (the counts are only exact without overflow).
+
+#include "device_id.hpp"
+#include "espnow_bridge.hpp"
+#include "espnow_loopback.hpp"
+#include "espnow_protocol.h"
+#include "mqtt.hpp"
+
+#include "esp_log.h"
+#include "mqtt_mock.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Args {
+    size_t peers = 32;
+    uint32_t frames = 100;
+    double rate = 1000;
+    double loss = 0.02;
+    double dup = 0.01;
+    double reorder = 0.01;
+};
+
+Args ParseArgs(int argc, char** argv)
+{
+    Args a;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* k = argv[i];
+        const char* v = argv[i + 1];
+        if (std::strcmp(k, "--peers") == 0)        a.peers = std::strtoul(v, nullptr, 10);
+        else if (std::strcmp(k, "--frames") == 0)  a.frames = std::strtoul(v, nullptr, 10);
+        else if (std::strcmp(k, "--rate") == 0)    a.rate = std::atof(v);
+        else if (std::strcmp(k, "--loss") == 0)    a.loss = std::atof(v);
+        else if (std::strcmp(k, "--dup") == 0)     a.dup = std::atof(v);
+        else if (std::strcmp(k, "--reorder") == 0) a.reorder = std::atof(v);
+    }
+    a.peers = std::max<size_t>(a.peers, 1);
+    return a;
+}
+
+EspNowBridge* g_bridge{};
+
+void OnConnect()
+{
+    g_bridge->OnMqttConnect();
+}
+
+void OnData(const char* topic, int topic_len, const char* data, int data_len,
+            int offset, int total_len)
+{
+    g_bridge->OnMqttData(topic, topic_len, data, data_len, offset, total_len);
+}
+
+// Nodes of the sequence cases, after the fleet
+constexpr size_t kSeqCases = 3;
+
+struct Node {
+    uint8_t mac[6];
+    uint16_t seq;
+    std::vector<uint8_t> held;  // reordered: goes out after the next frame
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto args = ParseArgs(argc, argv);
+    esp_log_level_set("*", ESP_LOG_NONE);
+    device_id_init();
+
+    auto cfg = EspNowBridge::Config::Default();
+    cfg.max_peers = std::max(cfg.max_peers, args.peers + kSeqCases);
+    cfg.stats_s = 0;
+    auto owned = std::make_unique<EspNowLoopback>();
+    auto* air = owned.get();
+    EspNowBridge bridge(std::move(owned), cfg);
+    g_bridge = &bridge;
+
+    mqtt_init(device_id_get(), OnConnect, OnData);
+    mqtt_mock_set_connected(true);
+    mqtt_mock_reset_stats();
+
+    std::vector<Node> nodes(args.peers);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const uint8_t mac[6] = {0x02, 0xAE, 0, 0, static_cast<uint8_t>(i >> 8),
+                                static_cast<uint8_t>(i)};
+        std::memcpy(nodes[i].mac, mac, sizeof(mac));
+    }
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    uint64_t injected_lost = 0, injected_dup = 0, injected_reorder = 0, delivered = 0;
+    double hook_ns_total = 0, hook_ns_max = 0;
+
+    auto deliver = [&](const Node& n, const std::vector<uint8_t>& frame) {
+        const auto t0 = std::chrono::steady_clock::now();
+        air->Deliver(n.mac, frame.data(), frame.size());
+        const double ns = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - t0).count();
+        hook_ns_total += ns;
+        hook_ns_max = std::max(hook_ns_max, ns);
+        ++delivered;
+    };
+
+    const auto period = std::chrono::duration<double>(args.rate > 0 ? 1.0 / args.rate : 0.0);
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t tick = 0;
+    for (uint32_t f = 0; f < args.frames; ++f) {
+        for (auto& n : nodes) {
+            std::vector<uint8_t> frame(espnow::kMaxFrame);
+            const float x = static_cast<float>(f % 50);
+            switch (&n - nodes.data()) {
+            case 0:
+                frame.resize(espnow::Encode(
+                    espnow::FromValues<espnow::Pwm12v>({40.5f, 1200, 12.1f, 0.35f, 31.2f}),
+                    n.seq++, frame.data()));
+                break;
+            default:
+                if ((&n - nodes.data()) % 2) {
+                    frame.resize(espnow::Encode(
+                        espnow::FromValues<espnow::Sen55>(
+                            {x / 10, x / 5, x / 4, x / 3, 45.5f, 22.25f, 100, NAN}),
+                        n.seq++, frame.data()));
+                } else {
+                    frame.resize(espnow::Encode(
+                        espnow::FromValues<espnow::Pms5003>(
+                            {x, 2 * x, 3 * x, 900, 300, 80, 12, 3, 1}),
+                        n.seq++, frame.data()));
+                }
+            }
+
+            if (args.rate > 0) {
+                std::this_thread::sleep_until(
+                    start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                period * static_cast<double>(tick)));
+            }
+            ++tick;
+
+            // A node's first and last frames always arrive: the bridge has
+            // no sequence to measure their loss against
+            const bool edge = f == 0 || f + 1 == args.frames;
+            if (!edge && coin(rng) < args.loss) {
+                ++injected_lost;
+                continue;
+            }
+            if (!edge && n.held.empty() && coin(rng) < args.reorder) {
+                n.held = std::move(frame);
+                ++injected_reorder;
+                continue;
+            }
+            deliver(n, frame);
+            if (coin(rng) < args.dup) {
+                deliver(n, frame);
+                ++injected_dup;
+            }
+            if (!n.held.empty()) {
+                deliver(n, n.held);
+                n.held.clear();
+            }
+        }
+    }
+    const double send_s =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const uint64_t fleet_delivered = delivered;
+
+    // Sequence cases, on their own nodes: {first, last} seq runs sent in turn
+    struct SeqCase {
+        const char* name;
+        std::vector<std::pair<uint16_t, uint16_t>> runs;
+        uint32_t restarts, stale;  // expected
+    };
+    const SeqCase cases[kSeqCases] = {
+        {"reboot", {{0, 9}, {0, 9}}, 1, 0},
+        {"reboot, seq 0 lost", {{0, 99}, {1, 9}}, 1, 1},
+        {"replay", {{0, 99}, {10, 10}, {100, 109}}, 0, 1},
+    };
+    for (size_t i = 0; i < kSeqCases; ++i) {
+        Node n{{0x02, 0xAE, 0xFF, 0, 0, static_cast<uint8_t>(i)}, 0, {}};
+        for (const auto& [first, last] : cases[i].runs) {
+            for (uint32_t seq = first; seq <= last; ++seq) {
+                std::vector<uint8_t> frame(espnow::kMaxFrame);
+                frame.resize(espnow::Encode(
+                    espnow::FromValues<espnow::Pwm12v>({40.5f, 1200, 12.1f, 0.35f, 31.2f}),
+                    static_cast<uint16_t>(seq), frame.data()));
+                if (args.rate > 0) std::this_thread::sleep_for(period);
+                deliver(n, frame);
+            }
+        }
+    }
+
+    // Let the task publish the last batch
+    std::this_thread::sleep_for(std::chrono::milliseconds(4 * cfg.batch_ms + 50));
+
+    // Downlink: one Identify command (op 1, tag 0x0102, 5 s) per node
+    // through the broker
+    for (const auto& n : nodes) {
+        char topic[96];
+        std::snprintf(topic, sizeof(topic), "aqm/%s/espnow/%02x%02x%02x%02x%02x%02x/cmd/command",
+                      device_id_get(), n.mac[0], n.mac[1], n.mac[2], n.mac[3], n.mac[4],
+                      n.mac[5]);
+        mqtt_publish(topic, "01020105000000");
+    }
+    const auto sent = air->TakeSent();
+    const bool downlink_ok =
+        sent.size() == nodes.size() &&
+        std::all_of(sent.begin(), sent.end(), [](const EspNowLoopback::Sent& s) {
+            espnow::Command cmd;
+            if (s.data.size() != sizeof(espnow::Header) + sizeof(cmd) ||
+                s.data[1] != static_cast<uint8_t>(espnow::MsgType::kCommand)) {
+                return false;
+            }
+            std::memcpy(&cmd, s.data.data() + sizeof(espnow::Header), sizeof(cmd));
+            return cmd.op == static_cast<uint8_t>(espnow::Op::kIdentify) && cmd.tag == 0x0102 &&
+                   cmd.value == 5;
+        });
+
+    const auto s = bridge.GetStats();
+    const auto mq = mqtt_mock_stats();
+    const uint64_t accepted =
+        s.received - s.duplicates - s.stale - s.malformed - s.unknown_peer;
+
+    std::vector<EspNowBridge::PeerStats> peers(args.peers + kSeqCases);
+    peers.resize(bridge.GetPeers(peers.data(), peers.size()));
+    bool seq_ok = true;
+
+    std::printf("fleet:        %zu peers x %u frames, %.0f frames/s offered\n",
+                args.peers, args.frames, fleet_delivered / send_s);
+    std::printf("receive hook: %.0f ns/frame mean, %.0f ns max\n",
+                hook_ns_total / static_cast<double>(delivered), hook_ns_max);
+    std::printf("ring:         %llu delivered, %u dropped full\n",
+                static_cast<unsigned long long>(delivered), s.ring_full);
+    std::printf("uplink:       %u frames in %u batches (%.1f frames/batch), %llu bytes, "
+                "%u unsent\n",
+                s.published, s.batches,
+                s.batches ? static_cast<double>(s.published) / s.batches : 0.0,
+                static_cast<unsigned long long>(mq.payload_bytes), s.unsent);
+    std::printf("loss:         injected %llu, detected %u\n",
+                static_cast<unsigned long long>(injected_lost), s.lost);
+    std::printf("duplicates:   injected %llu, detected %u\n",
+                static_cast<unsigned long long>(injected_dup), s.duplicates);
+    std::printf("reordered:    injected %llu, accepted late\n",
+                static_cast<unsigned long long>(injected_reorder));
+    for (size_t i = 0; i < kSeqCases; ++i) {
+        const auto& c = cases[i];
+        const auto it = std::find_if(peers.begin(), peers.end(), [&](const auto& p) {
+            return p.mac[2] == 0xFF && p.mac[5] == i;
+        });
+        const bool ok = it != peers.end() && it->restarts == c.restarts && it->stale == c.stale &&
+                        it->lost == 0 && it->duplicates == 0;
+        seq_ok = seq_ok && ok;
+        std::printf("sequence:     %-20s %u restarts, %u stale%s\n", c.name,
+                    it != peers.end() ? it->restarts : 0, it != peers.end() ? it->stale : 0,
+                    ok ? "" : " (WRONG)");
+    }
+    std::printf("registry:     %u peers, %u online\n", s.peers, s.online);
+    std::printf("discovery:    %u node configs announced, %u queued\n", s.announced,
+                s.announce_queue);
+    std::printf("downlink:     %zu/%zu commands sent%s\n", sent.size(), nodes.size(),
+                downlink_ok ? "" : " (WRONG FRAMES)");
+
+    // Exact only if the ring never overflowed
+    const bool ok = downlink_ok && seq_ok && s.ring_full == 0 && s.lost == injected_lost &&
+                    s.duplicates == injected_dup && s.published == accepted;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+// ESP-NOW wire format: round trip of every message in espnow_protocol.h,
+// then encode / decode throughput.
+//
+//   cyd_espnow_protocol [--samples <n per message>] [--filter <substring>]
+//
+// Round trip, per message: every raw value (random, plus each field's
+// extremes) must survive decode → encode unchanged, and every value in
+// range must come back within half a step of fixed point, NaN as NaN.
+// Exits 1 on any mismatch.
+
+#include "bench.hpp"
+#include "espnow_protocol.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <tuple>
+
+namespace {
+
+struct Args {
+    uint32_t samples = 100'000;
+    const char* filter = nullptr;
+};
+
+Args ParseArgs(int argc, char** argv)
+{
+    Args a;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* k = argv[i];
+        const char* v = argv[i + 1];
+        if (std::strcmp(k, "--samples") == 0)     a.samples = std::strtoul(v, nullptr, 10);
+        else if (std::strcmp(k, "--filter") == 0) a.filter = v;
+    }
+    return a;
+}
+
+/** Range of a field's raw type, without the "not available" value. */
+void RawRange(espnow::Wire w, double* lo, double* hi)
+{
+    switch (w) {
+    case espnow::Wire::kU8:  *lo = 0;      *hi = UINT8_MAX - 1;  break;
+    case espnow::Wire::kU16: *lo = 0;      *hi = UINT16_MAX - 1; break;
+    case espnow::Wire::kI16: *lo = INT16_MIN; *hi = INT16_MAX - 1; break;
+    case espnow::Wire::kU32: *lo = 0;      *hi = UINT32_MAX - 1.0; break;
+    case espnow::Wire::kI32: *lo = INT32_MIN; *hi = INT32_MAX - 1.0; break;
+    }
+}
+
+template <typename M>
+bool RoundTrip(uint32_t samples, std::mt19937& rng)
+{
+    using S = espnow::Schema<M>;
+    constexpr size_t n = espnow::kFieldCount<M>;
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    uint64_t raw_checked = 0, value_checked = 0, failures = 0;
+
+    for (uint32_t i = 0; i < samples; ++i) {
+        // Raw → values → raw: exact. The first samples pin each field to
+        // its minimum, maximum and "not available".
+        float values[n];
+        for (size_t k = 0; k < n; ++k) {
+            const auto& f = S::kFields[k];
+            double lo = 0, hi = 0;
+            RawRange(f.wire, &lo, &hi);
+            // 32-bit raws beyond float's 24-bit mantissa do not survive a
+            // float; readings never need them
+            if (espnow::WireSize(f.wire) == 4) {
+                lo = std::max(lo, -16'777'216.0);
+                hi = std::min(hi, 16'777'216.0);
+            }
+            double raw = std::floor(lo + unit(rng) * (hi - lo + 1));
+            if (i == 0) raw = lo;
+            if (i == 1) raw = hi;
+            values[k] = (i == 2) ? NAN : static_cast<float>(raw / f.scale);
+        }
+        uint8_t frame[espnow::kMaxFrame];
+        const size_t len = espnow::Encode(espnow::FromValues<M>(values), 0, frame);
+
+        size_t k = 0;
+        const char* name = espnow::Decode(
+            static_cast<uint8_t>(S::kType), frame + sizeof(espnow::Header),
+            len - sizeof(espnow::Header), [&](const espnow::Field& f, float v) {
+                const float want = values[k++];
+                const bool ok = std::isnan(want) ? std::isnan(v)
+                                                 : std::fabs(v - want) <= 0.5 / f.scale +
+                                                                              std::fabs(want) * 1e-6;
+                if (!ok && failures++ < 5) {
+                    std::printf("  %s.%s: %g → %g\n", S::kName, f.key, want, v);
+                }
+                ++raw_checked;
+            });
+        if (name != S::kName || k != n) ++failures;
+
+        // Values → raw → values, anywhere in range: within half a step;
+        // beyond the range: saturated
+        for (size_t j = 0; j < n; ++j) {
+            const auto& f = S::kFields[j];
+            double lo = 0, hi = 0;
+            RawRange(f.wire, &lo, &hi);
+            values[j] = static_cast<float>((lo + unit(rng) * (hi - lo)) / f.scale);
+        }
+        const M msg = espnow::FromValues<M>(values);
+        k = 0;
+        espnow::DecodeAs<M>(reinterpret_cast<const uint8_t*>(&msg), sizeof(msg),
+                            [&](const espnow::Field& f, float v) {
+            const float want = values[k++];
+            if (std::fabs(v - want) > 0.5 / f.scale + std::fabs(want) * 1e-6) {
+                if (failures++ < 5) std::printf("  %s.%s: %g → %g\n", S::kName, f.key, want, v);
+            }
+            ++value_checked;
+        });
+    }
+
+    // Short payloads are refused; longer ones (a newer node) decode
+    uint8_t big[sizeof(M) + 8]{};
+    const bool short_refused = !espnow::DecodeAs<M>(big, sizeof(M) - 1, [](auto&, float) {});
+    const bool long_accepted = espnow::DecodeAs<M>(big, sizeof(big), [](auto&, float) {});
+    if (!short_refused || !long_accepted) ++failures;
+
+    std::printf("%-8s %2zu fields, %3zu-byte frame: %llu raw + %llu value checks, %llu failures\n",
+                S::kName, n, sizeof(espnow::Header) + sizeof(M),
+                static_cast<unsigned long long>(raw_checked),
+                static_cast<unsigned long long>(value_checked),
+                static_cast<unsigned long long>(failures));
+    return failures == 0;
+}
+
+template <typename M>
+void Throughput(const bench::Options& opts, std::mt19937& rng)
+{
+    using S = espnow::Schema<M>;
+    float values[espnow::kFieldCount<M>];
+    for (auto& v : values) v = static_cast<float>(rng() % 1000) / 10;
+    uint8_t frame[espnow::kMaxFrame];
+    const size_t len = espnow::Encode(espnow::FromValues<M>(values), 0, frame);
+    const uint8_t* payload = frame + sizeof(espnow::Header);
+    const size_t payload_len = len - sizeof(espnow::Header);
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "espnow/encode %s", S::kName);
+    uint16_t seq = 0;
+    bench::Run(opts, name, [&] {
+        bench::DoNotOptimize(espnow::Encode(espnow::FromValues<M>(values), seq++, frame));
+    });
+
+    std::snprintf(name, sizeof(name), "espnow/decode %s (by type)", S::kName);
+    bench::Run(opts, name, [&] {
+        float sum = 0;
+        espnow::Decode(static_cast<uint8_t>(S::kType), payload, payload_len,
+                       [&](const espnow::Field&, float v) { sum += v; });
+        bench::DoNotOptimize(sum);
+    });
+
+    // As the bridge does it: each field formatted into the JSON record
+    std::snprintf(name, sizeof(name), "espnow/decode %s + json", S::kName);
+    bench::Run(opts, name, [&] {
+        char json[256];
+        size_t n = 0;
+        espnow::Decode(static_cast<uint8_t>(S::kType), payload, payload_len,
+                       [&](const espnow::Field& f, float v) {
+            n += std::snprintf(json + n, sizeof(json) - n,
+                               std::isnan(v) ? "%s\"%s\":null" : "%s\"%s\":%.*f", n ? "," : "",
+                               f.key, f.decimals, static_cast<double>(v));
+        });
+        bench::DoNotOptimize(json);
+    });
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto args = ParseArgs(argc, argv);
+    std::mt19937 rng(5);
+
+    bool ok = true;
+    std::apply([&](auto... m) { ((ok &= RoundTrip<decltype(m)>(args.samples, rng)), ...); },
+               espnow::Messages{});
+    std::printf("\n");
+
+    bench::Options opts;
+    opts.filter = args.filter;
+    bench::PrintHeader();
+    std::apply([&](auto... m) { (Throughput<decltype(m)>(opts, rng), ...); },
+               espnow::Messages{});
+    return ok ? 0 : 1;
+}
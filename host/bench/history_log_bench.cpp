@@ -0,0 +1,161 @@
+// Size and start-up cost of the flash history log.
+//
+//   cyd_history_log [--days <simulated days>] [--noise <LSB>]
+//
+// Feeds `days` of 1 Hz readings (the simulator's waveform plus +/- noise
+// LSB of sensor noise per word) through History into the minute and hour
+// logs, then "reboots": reopens both logs on the same flash image, replays
+// them into a fresh History and checks it against the live one.
+
+#include "history.hpp"
+#include "history_log.hpp"
+#include "sen55_frame.hpp"
+#include "sen55_sim.hpp"
+
+#include "esp_log.h"
+#include "host_flash.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+namespace {
+
+constexpr History::Capacity kCapacity{.raw = 3600, .minute = 168 * 60, .hour = 56 * 24};
+constexpr uint32_t kRowBytes = sizeof(uint32_t) + 3 * History::kChannelCount * sizeof(float);
+
+struct Args {
+    double days = 14;
+    int noise = 2;
+};
+
+Args ParseArgs(int argc, char** argv)
+{
+    Args a;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* k = argv[i];
+        const char* v = argv[i + 1];
+        if (std::strcmp(k, "--days") == 0)       a.days = std::atof(v);
+        else if (std::strcmp(k, "--noise") == 0) a.noise = std::atoi(v);
+    }
+    return a;
+}
+
+double Ms(std::chrono::steady_clock::duration d)
+{
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+void PrintLog(const char* name, const HistoryLog& log, const esp_partition_t* part)
+{
+    const auto s = log.GetStats();
+    const auto f = host_flash_stats(part);
+    const double per_row = s.rows_written ? double(s.bytes_written) / s.rows_written : 0;
+    std::printf("%-9s %7u rows  %6.1f B/row (%.2f bits/value, %.1fx vs %u B)  "
+                "%u erases, max %u per sector of %u\n",
+                name, s.rows_written, per_row,
+                per_row * 8 / (3 * History::kChannelCount),
+                per_row ? kRowBytes / per_row : 0, kRowBytes,
+                s.erases, f.max_erases_per_sector, s.sectors);
+}
+
+/** Whether `a` and `b` hold the same rows for `tier`, to within half a storage step. */
+bool SameTier(const History::View& a, const History::View& b, History::Tier tier)
+{
+    const auto ta = a.Times(tier);
+    const auto tb = b.Times(tier);
+    if (ta.size() != tb.size()) return false;
+    for (size_t i = 0; i < ta.size(); ++i) {
+        if (ta[i] != tb[i]) return false;
+    }
+    for (size_t c = 0; c < History::kChannelCount; ++c) {
+        for (auto stat : {History::Stat::kMin, History::Stat::kAvg, History::Stat::kMax}) {
+            const auto va = a.Values(tier, History::Channel(c), stat);
+            const auto vb = b.Values(tier, History::Channel(c), stat);
+            const float tolerance = HistoryLog::Step(History::Channel(c)) * 0.501f;
+            for (size_t i = 0; i < va.size(); ++i) {
+                if (std::isnan(va[i]) != std::isnan(vb[i]) ||
+                    std::fabs(va[i] - vb[i]) > tolerance) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto args = ParseArgs(argc, argv);
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    // Same sizes as partitions.csv
+    const auto* min_part = host_flash_add_partition("hist_min", 0x41, 0x1C0000);
+    const auto* hour_part = host_flash_add_partition("hist_hour", 0x41, 0x40000);
+
+    History history(kCapacity);
+    {
+        HistoryLog minute_log("hist_min", 60);
+        HistoryLog hour_log("hist_hour", 3600);
+        history.OnRow([&](History::Tier tier, const History::Row& row) {
+            (tier == History::Tier::kMinute ? minute_log : hour_log).Append(row);
+        });
+
+        std::minstd_rand rng(1);
+        std::uniform_int_distribution<int> noise(-args.noise, args.noise);
+        const auto samples = static_cast<uint32_t>(args.days * 86400);
+
+        const auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < samples; ++i) {
+            auto words = Sen55Sim::DefaultValues(i);
+            for (auto& w : words) w = static_cast<uint16_t>(w + noise(rng));
+            history.Append(int64_t{i} * 1'000'000, sen55_frame::DecodeMeasurement(words));
+        }
+        const auto t1 = std::chrono::steady_clock::now();
+
+        std::printf("%.1f days, %u readings, %.0f ns/reading incl. log appends\n\n",
+                    args.days, samples, Ms(t1 - t0) * 1e6 / samples);
+        PrintLog("minute", minute_log, min_part);
+        PrintLog("hour", hour_log, hour_part);
+        history.OnRow(nullptr);
+    }
+
+    // Reboot: index both logs from flash and restore a fresh History
+    const auto t0 = std::chrono::steady_clock::now();
+    HistoryLog minute_log("hist_min", 60);
+    HistoryLog hour_log("hist_hour", 3600);
+    const auto t1 = std::chrono::steady_clock::now();
+    const auto mo = minute_log.GetStats();
+    const auto ho = hour_log.GetStats();
+
+    History restored(kCapacity);
+    const size_t minutes = minute_log.Replay(kCapacity.minute, [&](const History::Row& row) {
+        restored.Restore(History::Tier::kMinute, row);
+    });
+    const size_t hours = hour_log.Replay(kCapacity.hour, [&](const History::Row& row) {
+        restored.Restore(History::Tier::kHour, row);
+    });
+    const auto t2 = std::chrono::steady_clock::now();
+
+    const auto ms = minute_log.GetStats();
+    const auto hs = hour_log.GetStats();
+    std::printf("\nreboot: open %.3f ms (%u header + %u sector reads), "
+                "replay %zu + %zu rows %.1f ms (%u header + %u sector reads)\n",
+                Ms(t1 - t0),
+                mo.header_reads + ho.header_reads, mo.sector_reads + ho.sector_reads,
+                minutes, hours, Ms(t2 - t1),
+                ms.header_reads + hs.header_reads - mo.header_reads - ho.header_reads,
+                ms.sector_reads + hs.sector_reads - mo.sector_reads - ho.sector_reads);
+
+    const auto a = history.Read();
+    const auto b = restored.Read();
+    const bool ok = SameTier(a, b, History::Tier::kMinute) &&
+                    SameTier(a, b, History::Tier::kHour);
+    std::printf("restored tiers %s the live ones\n", ok ? "match" : "DIFFER from");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+// Soak test for the SEN55 polling task against the simulated sensor, run
+// on a scaled clock (default 100x real time).
+//
+//   cyd_sen55_soak [--seconds <simulated s>] [--speedup <x>]
+//                  [--nack-rate <p>] [--crc-rate <p>] [--drift-ppm <ppm>]
+//
+// Sample numbers are encoded in the PM1.0 word so missed and duplicate
+// deliveries can be told apart from sensor-side skips.
+
+#include "sen55.hpp"
+#include "sen55_sim.hpp"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "host_rtos.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+
+namespace {
+
+struct Args {
+    double seconds = 600;
+    double speedup = 100;
+    double nack_rate = 0.0;
+    double crc_rate = 0.0;
+    int32_t drift_ppm = 0;
+};
+
+Args ParseArgs(int argc, char** argv)
+{
+    Args a;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* k = argv[i];
+        const char* v = argv[i + 1];
+        if (std::strcmp(k, "--seconds") == 0)        a.seconds = std::atof(v);
+        else if (std::strcmp(k, "--speedup") == 0)   a.speedup = std::atof(v);
+        else if (std::strcmp(k, "--nack-rate") == 0) a.nack_rate = std::atof(v);
+        else if (std::strcmp(k, "--crc-rate") == 0)  a.crc_rate = std::atof(v);
+        else if (std::strcmp(k, "--drift-ppm") == 0) a.drift_ppm = std::atoi(v);
+    }
+    return a;
+}
+
+struct Delivery {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> duplicates{0};
+    std::atomic<uint64_t> gaps{0};
+    std::atomic<int64_t> age_sum_us{0};
+    std::atomic<int64_t> age_max_us{0};
+    int64_t last_index{-1};
+};
+
+double CpuSeconds()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto args = ParseArgs(argc, argv);
+    esp_log_level_set("*", ESP_LOG_NONE);
+    host_rtos_set_speedup(args.speedup);
+
+    Sen55Sim::Config cfg;
+    cfg.nack_rate = args.nack_rate;
+    cfg.crc_error_rate = args.crc_rate;
+    cfg.clock_error_ppm = args.drift_ppm;
+    cfg.values = [](uint32_t index) {
+        auto words = Sen55Sim::DefaultValues(index);
+        words[0] = static_cast<uint16_t>(index % 60'000);
+        return words;
+    };
+
+    auto sim_owned = std::make_unique<Sen55Sim>(cfg);
+    auto* sim = sim_owned.get();
+    Delivery d;
+    Sen55::Stats own{};
+
+    const auto wall0 = std::chrono::steady_clock::now();
+    const double cpu0 = CpuSeconds();
+    {
+        Sen55 sensor(std::move(sim_owned), [&](const Sen55::Measurement& m) {
+            const auto index = static_cast<int64_t>(m.pm1_0 * 10.0f + 0.5f);
+            const auto age = esp_timer_get_time() - sim->SampleTimeUs(static_cast<uint32_t>(index));
+            if (index == d.last_index) {
+                ++d.duplicates;
+            } else if (d.last_index >= 0 && index > d.last_index + 1) {
+                d.gaps += static_cast<uint64_t>(index - d.last_index - 1);
+            }
+            d.last_index = index;
+            ++d.count;
+            d.age_sum_us += age;
+            d.age_max_us = std::max<int64_t>(d.age_max_us, age);
+        });
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(args.seconds / args.speedup));
+        own = sensor.GetStats();
+    }
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall0).count();
+    const double cpu = CpuSeconds() - cpu0;
+
+    const auto s = sim->GetStats();
+    const auto delivered = d.count.load();
+    std::printf("simulated %.0f s in %.2f s wall (%.0fx), cpu %.3f s\n",
+                args.seconds, wall, args.seconds / wall, cpu);
+    std::printf("sensor:    %llu samples produced, %llu read, %llu skipped, %llu stale reads\n",
+                static_cast<unsigned long long>(s.samples_produced),
+                static_cast<unsigned long long>(s.samples_read),
+                static_cast<unsigned long long>(s.samples_skipped),
+                static_cast<unsigned long long>(s.stale_reads));
+    std::printf("faults:    %llu NACKs injected, %llu busy NACKs, %llu CRC errors injected\n",
+                static_cast<unsigned long long>(s.nacks_injected),
+                static_cast<unsigned long long>(s.nacks_busy),
+                static_cast<unsigned long long>(s.crc_errors_injected));
+    std::printf("delivered: %llu callbacks, %llu missed, %llu duplicates\n",
+                static_cast<unsigned long long>(delivered),
+                static_cast<unsigned long long>(d.gaps.load()),
+                static_cast<unsigned long long>(d.duplicates.load()));
+    std::printf("Sen55:     %u samples, %u missed, %u duplicates, %u not-ready probes, "
+                "%u I2C errors, %u CRC errors, max latency %.1f ms\n",
+                own.samples, own.missed, own.duplicates, own.not_ready,
+                own.i2c_errors, own.crc_errors, static_cast<double>(own.max_latency_us) / 1000.0);
+    if (delivered > 0) {
+        std::printf("age:       mean %.1f ms, max %.1f ms (sample ready -> callback)\n",
+                    static_cast<double>(d.age_sum_us) / static_cast<double>(delivered) / 1000.0,
+                    static_cast<double>(d.age_max_us) / 1000.0);
+        std::printf("cost:      %.1f us cpu per delivered sample (host)\n",
+                    cpu * 1e6 / static_cast<double>(delivered));
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+// Host implementations of the ESP-IDF error, logging and MAC helpers.
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+esp_log_level_t s_level = ESP_LOG_INFO;
+
+constexpr char kLevelChar[] = {'N', 'E', 'W', 'I', 'D', 'V'};
+
+} // namespace
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:                   return "ESP_OK";
+    case ESP_FAIL:                 return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:           return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:      return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:    return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:     return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:    return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:          return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE: return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC:      return "ESP_ERR_INVALID_CRC";
+    default:                       return "UNKNOWN ERROR";
+    }
+}
+
+void esp_host_check_failed(esp_err_t rc, const char *file, int line, const char *expr)
+{
+    std::fprintf(stderr, "ESP_ERROR_CHECK failed: %s (0x%x) at %s:%d\n  expression: %s\n",
+                 esp_err_to_name(rc), rc, file, line, expr);
+    std::abort();
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    if (std::strcmp(tag, "*") == 0) {
+        s_level = level;
+    }
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    if (level > s_level) return;
+
+    std::fprintf(stderr, "%c (%s) ", kLevelChar[level], tag);
+    va_list args;
+    va_start(args, format);
+    std::vfprintf(stderr, format, args);
+    va_end(args);
+    std::fputc('\n', stderr);
+}
+
+esp_err_t esp_efuse_mac_get_default(uint8_t *mac)
+{
+    constexpr uint8_t kHostMac[6] = {0x02, 0x00, 0x00, 0xa1, 0xb2, 0xc3};
+    std::memcpy(mac, kHostMac, sizeof(kHostMac));
+    return ESP_OK;
+}
@@ -0,0 +1,124 @@
+// RAM-backed esp_partition implementation plus the esp_heap_caps and
+// esp_random stand-ins.
+
+#include "host_flash.hpp"
+#include "esp_heap_caps.h"
+#include "esp_random.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kSectorSize = 4096;
+
+struct HostPartition {
+    esp_partition_t part;
+    std::vector<uint8_t> data;
+    std::vector<uint32_t> erases;  // per sector
+    HostFlashStats stats;
+};
+
+std::vector<std::unique_ptr<HostPartition>> &Partitions()
+{
+    static std::vector<std::unique_ptr<HostPartition>> parts;
+    return parts;
+}
+
+HostPartition *Find(const esp_partition_t *p)
+{
+    for (auto &hp : Partitions()) {
+        if (&hp->part == p) return hp.get();
+    }
+    return nullptr;
+}
+
+} // namespace
+
+const esp_partition_t *host_flash_add_partition(const char *label, int subtype, uint32_t size)
+{
+    auto hp = std::make_unique<HostPartition>();
+    hp->part.type = ESP_PARTITION_TYPE_DATA;
+    hp->part.subtype = subtype;
+    hp->part.address = 0x400000 + static_cast<uint32_t>(Partitions().size()) * 0x400000;
+    hp->part.size = size;
+    hp->part.erase_size = kSectorSize;
+    std::strncpy(hp->part.label, label, sizeof(hp->part.label) - 1);
+    hp->data.assign(size, 0xFF);
+    hp->erases.assign(size / kSectorSize, 0);
+    Partitions().push_back(std::move(hp));
+    return &Partitions().back()->part;
+}
+
+HostFlashStats host_flash_stats(const esp_partition_t *partition)
+{
+    auto *hp = Find(partition);
+    return hp ? hp->stats : HostFlashStats{};
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                int subtype, const char *label)
+{
+    for (auto &hp : Partitions()) {
+        if (type != ESP_PARTITION_TYPE_ANY && hp->part.type != type) continue;
+        if (subtype != ESP_PARTITION_SUBTYPE_ANY && hp->part.subtype != subtype) continue;
+        if (label && std::strcmp(label, hp->part.label) != 0) continue;
+        return &hp->part;
+    }
+    return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset,
+                             void *dst, size_t size)
+{
+    auto *hp = Find(partition);
+    if (!hp || src_offset + size > hp->data.size()) return ESP_ERR_INVALID_SIZE;
+    std::memcpy(dst, hp->data.data() + src_offset, size);
+    hp->stats.bytes_read += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset,
+                              const void *src, size_t size)
+{
+    auto *hp = Find(partition);
+    if (!hp || dst_offset + size > hp->data.size()) return ESP_ERR_INVALID_SIZE;
+    const auto *in = static_cast<const uint8_t *>(src);
+    for (size_t i = 0; i < size; ++i) {
+        hp->data[dst_offset + i] &= in[i];  // NOR: programming only clears bits
+    }
+    hp->stats.bytes_written += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    auto *hp = Find(partition);
+    if (!hp || offset % kSectorSize || size % kSectorSize || offset + size > hp->data.size()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::memset(hp->data.data() + offset, 0xFF, size);
+    for (size_t s = offset / kSectorSize; s < (offset + size) / kSectorSize; ++s) {
+        ++hp->erases[s];
+        ++hp->stats.sector_erases;
+        hp->stats.max_erases_per_sector = std::max(hp->stats.max_erases_per_sector, hp->erases[s]);
+    }
+    return ESP_OK;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t) { return std::malloc(size); }
+void *heap_caps_calloc(size_t n, size_t size, uint32_t) { return std::calloc(n, size); }
+void heap_caps_free(void *ptr) { std::free(ptr); }
+size_t heap_caps_get_free_size(uint32_t) { return 0; }
+size_t heap_caps_get_largest_free_block(uint32_t) { return 0; }
+size_t heap_caps_get_minimum_free_size(uint32_t) { return 0; }
+
+uint32_t esp_random()
+{
+    static std::minstd_rand rng(12345);
+    return static_cast<uint32_t>(rng());
+}
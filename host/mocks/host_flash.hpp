@@ -0,0 +1,22 @@
+#pragma once
+
+// RAM-backed flash partitions for host builds.
+
+#include "esp_partition.h"
+
+#include <cstdint>
+
+/// Registers a partition of `size` bytes (erased, all 0xFF). Call before
+/// the firmware code looks it up. Returns the partition.
+const esp_partition_t *host_flash_add_partition(const char *label, int subtype,
+                                                uint32_t size);
+
+/// Wear and traffic counters for a registered partition.
+struct HostFlashStats {
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint64_t sector_erases;
+    uint32_t max_erases_per_sector;
+};
+
+HostFlashStats host_flash_stats(const esp_partition_t *partition);
@@ -0,0 +1,342 @@
+// Host FreeRTOS tasks and semaphores on std::thread, plus esp_timer, all
+// on one scalable clock shared by vTaskDelay(), xTaskGetTickCount() and
+// esp_timer_get_time().
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "host_rtos.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct HostTask {
+    TaskFunction_t fn;
+    void *arg;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool deleted{false};
+    uint32_t notify_count{0};
+};
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const Clock::time_point s_epoch = Clock::now();
+std::atomic<double> s_speedup{1.0};
+thread_local HostTask *t_current = nullptr;
+
+/// Thrown inside a task to unwind it when it is deleted.
+struct TaskDeleted {};
+
+/// Wall-clock instant at which the scaled clock reads `us`.
+Clock::time_point WallAt(int64_t us)
+{
+    return s_epoch + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::micro>(static_cast<double>(us) / s_speedup));
+}
+
+void TaskEntry(HostTask *task)
+{
+    t_current = task;
+    try {
+        task->fn(task->arg);
+    } catch (const TaskDeleted &) {
+    }
+}
+
+} // namespace
+
+void host_rtos_set_speedup(double factor) { s_speedup = factor; }
+double host_rtos_speedup() { return s_speedup; }
+
+int64_t esp_timer_get_time()
+{
+    const auto wall = std::chrono::duration<double, std::micro>(Clock::now() - s_epoch);
+    return static_cast<int64_t>(wall.count() * s_speedup);
+}
+
+TickType_t xTaskGetTickCount()
+{
+    return static_cast<TickType_t>(esp_timer_get_time() * configTICK_RATE_HZ / 1'000'000);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char * /*name*/,
+                                   uint32_t /*stack_depth*/, void *arg,
+                                   UBaseType_t /*priority*/, TaskHandle_t *out_handle,
+                                   BaseType_t /*core_id*/)
+{
+    auto *task = new HostTask{fn, arg, {}, {}, {}};
+    if (out_handle) *out_handle = task;
+    task->thread = std::thread(TaskEntry, task);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (!task || task == t_current) {
+        throw TaskDeleted{};
+    }
+    {
+        std::lock_guard lock(task->mutex);
+        task->deleted = true;
+    }
+    task->wake.notify_all();
+    task->thread.join();
+    delete task;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    auto *self = t_current;
+    const auto wall = std::chrono::duration<double, std::micro>(
+        static_cast<double>(ticks) * 1e6 / configTICK_RATE_HZ / s_speedup);
+    if (!self) {
+        std::this_thread::sleep_for(wall);
+        return;
+    }
+    std::unique_lock lock(self->mutex);
+    self->wake.wait_for(lock, wall, [self] { return self->deleted; });
+    if (self->deleted) {
+        throw TaskDeleted{};
+    }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return t_current;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    {
+        std::lock_guard lock(task->mutex);
+        ++task->notify_count;
+    }
+    task->wake.notify_all();
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    auto *self = t_current;
+    const auto wall = std::chrono::duration<double, std::micro>(
+        static_cast<double>(ticks) * 1e6 / configTICK_RATE_HZ / s_speedup);
+    std::unique_lock lock(self->mutex);
+    const auto ready = [self] { return self->notify_count > 0 || self->deleted; };
+    if (ticks == portMAX_DELAY) {
+        self->wake.wait(lock, ready);
+    } else {
+        self->wake.wait_for(lock, wall, ready);
+    }
+    if (self->deleted) {
+        throw TaskDeleted{};
+    }
+    const auto count = self->notify_count;
+    self->notify_count = clear_on_exit ? 0 : (count ? count - 1 : 0);
+    return count;
+}
+
+/* ── Semaphores ──────────────────────────────────────────────────────── */
+
+struct HostSemaphore {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool given{false};
+};
+
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return new HostSemaphore;
+}
+
+// No priority inheritance: a mutex is a binary semaphore that starts given.
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    auto *sem = new HostSemaphore;
+    sem->given = true;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t * /*buffer*/)
+{
+    return xSemaphoreCreateBinary();
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t * /*buffer*/)
+{
+    return xSemaphoreCreateMutex();
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    {
+        std::lock_guard lock(sem->mutex);
+        if (sem->given) return pdFALSE;
+        sem->given = true;
+    }
+    sem->cv.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    // Wait in short wall-clock slices so a vTaskDelete() of the waiting
+    // task is noticed without the semaphore knowing about tasks.
+    constexpr auto kSlice = std::chrono::milliseconds(1);
+    const bool forever = ticks == portMAX_DELAY;
+    const int64_t deadline_us =
+        esp_timer_get_time() + static_cast<int64_t>(ticks) * 1'000'000 / configTICK_RATE_HZ;
+
+    std::unique_lock lock(sem->mutex);
+    for (;;) {
+        if (sem->given) {
+            sem->given = false;
+            return pdTRUE;
+        }
+        if (!forever && esp_timer_get_time() >= deadline_us) {
+            return pdFALSE;
+        }
+        if (t_current && t_current->deleted) {
+            throw TaskDeleted{};
+        }
+        sem->cv.wait_for(lock, kSlice);
+    }
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    delete sem;
+}
+
+/* ── esp_timer ───────────────────────────────────────────────────────── */
+
+struct esp_timer {
+    esp_timer_create_args_t args;
+    bool armed{false};
+    int64_t deadline_us{};
+    uint64_t period_us{};  // 0 = one-shot
+};
+
+namespace {
+
+/// One dispatch thread for all timers, like the IDF esp_timer task.
+/// Heap-allocated and never destroyed so it outlives static teardown.
+struct TimerService {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<esp_timer *> timers;
+    esp_timer *running{};
+
+    TimerService() { std::thread([this] { Loop(); }).detach(); }
+
+    void Loop()
+    {
+        std::unique_lock lock(mutex);
+        for (;;) {
+            esp_timer *next = nullptr;
+            for (auto *t : timers) {
+                if (t->armed && (!next || t->deadline_us < next->deadline_us)) next = t;
+            }
+            if (!next) {
+                cv.wait(lock);
+                continue;
+            }
+            if (esp_timer_get_time() < next->deadline_us) {
+                cv.wait_until(lock, WallAt(next->deadline_us));
+                continue;
+            }
+            if (next->period_us) {
+                next->deadline_us += static_cast<int64_t>(next->period_us);
+            } else {
+                next->armed = false;
+            }
+            running = next;
+            const auto args = next->args;
+            lock.unlock();
+            args.callback(args.arg);
+            lock.lock();
+            running = nullptr;
+            cv.notify_all();
+        }
+    }
+};
+
+TimerService &Timers()
+{
+    static auto *service = new TimerService;
+    return *service;
+}
+
+esp_err_t Start(esp_timer_handle_t timer, uint64_t us, uint64_t period_us)
+{
+    auto &svc = Timers();
+    {
+        std::lock_guard lock(svc.mutex);
+        if (timer->armed) return ESP_ERR_INVALID_STATE;
+        timer->armed = true;
+        timer->deadline_us = esp_timer_get_time() + static_cast<int64_t>(us);
+        timer->period_us = period_us;
+    }
+    svc.cv.notify_all();
+    return ESP_OK;
+}
+
+} // namespace
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle)
+{
+    if (!args || !args->callback || !out_handle) return ESP_ERR_INVALID_ARG;
+    auto &svc = Timers();
+    auto *timer = new esp_timer{*args};
+    std::lock_guard lock(svc.mutex);
+    svc.timers.push_back(timer);
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return Start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    return Start(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    auto &svc = Timers();
+    std::lock_guard lock(svc.mutex);
+    if (!timer->armed) return ESP_ERR_INVALID_STATE;
+    timer->armed = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (!timer) return ESP_ERR_INVALID_ARG;
+    auto &svc = Timers();
+    std::unique_lock lock(svc.mutex);
+    if (timer->armed) return ESP_ERR_INVALID_STATE;
+    svc.cv.wait(lock, [&] { return svc.running != timer; });
+    svc.timers.erase(std::find(svc.timers.begin(), svc.timers.end(), timer));
+    delete timer;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    auto &svc = Timers();
+    std::lock_guard lock(svc.mutex);
+    return timer->armed;
+}
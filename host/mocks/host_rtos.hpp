@@ -0,0 +1,8 @@
+#pragma once
+
+// Controls for the host FreeRTOS / esp_timer stand-ins.
+
+/// Run simulated time `factor` times faster than wall clock (default 1).
+/// Set before creating any task; changing it mid-run makes time jump.
+void host_rtos_set_speedup(double factor);
+double host_rtos_speedup();
@@ -0,0 +1,9 @@
+#pragma once
+
+// Host stand-in for ESP-IDF esp_mac.h. Returns a fixed, locally administered MAC.
+
+#include "esp_err.h"
+
+#include <cstdint>
+
+esp_err_t esp_efuse_mac_get_default(uint8_t *mac);
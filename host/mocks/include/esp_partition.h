@@ -0,0 +1,37 @@
+#pragma once
+
+// Host stand-in for the esp_partition API, backed by RAM images registered
+// through host_flash.hpp. Writes behave like NOR flash (bits only clear).
+
+#include "esp_err.h"
+
+#include <cstddef>
+#include <cstdint>
+
+enum esp_partition_type_t {
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01,
+    ESP_PARTITION_TYPE_ANY = 0xff,
+};
+
+enum esp_partition_subtype_t {
+    ESP_PARTITION_SUBTYPE_ANY = 0xff,
+};
+
+struct esp_partition_t {
+    esp_partition_type_t type;
+    int subtype;
+    uint32_t address;
+    uint32_t size;
+    uint32_t erase_size;
+    char label[17];
+};
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                int subtype, const char *label);
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset,
+                             void *dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset,
+                              const void *src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset,
+                                    size_t size);
@@ -0,0 +1,7 @@
+#pragma once
+
+// Host stand-in for esp_random.h.
+
+#include <cstdint>
+
+uint32_t esp_random();
@@ -0,0 +1,35 @@
+#pragma once
+
+// Host stand-in for esp_timer. Time is microseconds since start-up on the
+// scaled host clock (see host_rtos.hpp); callbacks run on one service
+// thread, like ESP_TIMER_TASK dispatch.
+
+#include "esp_err.h"
+
+#include <cstdint>
+
+using esp_timer_cb_t = void (*)(void *arg);
+
+enum esp_timer_dispatch_t {
+    ESP_TIMER_TASK,
+    ESP_TIMER_ISR,
+};
+
+struct esp_timer_create_args_t {
+    esp_timer_cb_t callback;
+    void *arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char *name;
+    bool skip_unhandled_events;
+};
+
+struct esp_timer;
+using esp_timer_handle_t = esp_timer *;
+
+int64_t esp_timer_get_time();
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out_handle);
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us);
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+esp_err_t esp_timer_delete(esp_timer_handle_t timer);
+bool esp_timer_is_active(esp_timer_handle_t timer);
@@ -0,0 +1,21 @@
+#pragma once
+
+// Host stand-in for the FreeRTOS kernel types and tick conversion used by
+// the firmware. Time runs `host_rtos_speedup()` times faster than wall
+// clock; see host_rtos.hpp.
+
+#include <cstdint>
+
+using BaseType_t = int;
+using UBaseType_t = unsigned int;
+using TickType_t = uint32_t;
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+
+#define configTICK_RATE_HZ 1000
+#define portMAX_DELAY      static_cast<TickType_t>(0xFFFFFFFFu)
+#define pdMS_TO_TICKS(ms)  static_cast<TickType_t>((static_cast<uint64_t>(ms) * configTICK_RATE_HZ) / 1000)
+#define pdTICKS_TO_MS(t)   static_cast<uint32_t>((static_cast<uint64_t>(t) * 1000) / configTICK_RATE_HZ)
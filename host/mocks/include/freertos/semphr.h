@@ -0,0 +1,21 @@
+#pragma once
+
+// Host stand-in for FreeRTOS binary semaphores and mutexes.
+
+#include "freertos/FreeRTOS.h"
+
+struct HostSemaphore;
+using SemaphoreHandle_t = HostSemaphore *;
+
+/// Storage for the *Static variants. The host versions still allocate.
+struct StaticSemaphore_t {
+    void *reserved;
+};
+
+SemaphoreHandle_t xSemaphoreCreateBinary();
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buffer);
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
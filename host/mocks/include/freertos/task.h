@@ -0,0 +1,25 @@
+#pragma once
+
+// Host stand-in for FreeRTOS tasks, backed by std::thread.
+//
+// vTaskDelete() on another task takes effect at that task's next
+// vTaskDelay() and waits for it to exit — real FreeRTOS stops it at once.
+
+#include "freertos/FreeRTOS.h"
+
+struct HostTask;
+using TaskHandle_t = HostTask *;
+using TaskFunction_t = void (*)(void *);
+
+#define tskNO_AFFINITY 0x7FFFFFFF
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name,
+                                   uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *out_handle,
+                                   BaseType_t core_id);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
@@ -0,0 +1,33 @@
+#pragma once
+
+// Host stand-in for the generated sdkconfig.h: the defaults from
+// main/Kconfig.projbuild that the host-built sources read.
+
+#define CONFIG_AQM_MQTT_STATE_JSON 1
+#define CONFIG_AQM_MQTT_STATE_QOS 0
+#define CONFIG_AQM_LATENCY_REPORT_S 60
+#define CONFIG_AQM_HA_DEVICE_DISCOVERY 1
+#define CONFIG_AQM_HA_DISCOVERY_CHECK_MS 1500
+#define CONFIG_AQM_TELEMETRY 1
+#define CONFIG_AQM_ESPNOW 1
+#define CONFIG_AQM_ESPNOW_RX_RING 64
+#define CONFIG_AQM_ESPNOW_BATCH_MS 20
+#define CONFIG_AQM_ESPNOW_BATCH_BYTES 2048
+#define CONFIG_AQM_ESPNOW_MAX_PEERS 64
+#define CONFIG_AQM_ESPNOW_HEARTBEAT_S 180
+#define CONFIG_AQM_ESPNOW_STATS_S 60
+#define CONFIG_AQM_ESPNOW_DISCOVERY 1
+#define CONFIG_AQM_ESPNOW_DISCOVERY_MSGS_S 4
+#define CONFIG_AQM_ESPNOW_DISCOVERY_BYTES_S 8192
+#define CONFIG_AQM_ESPNOW_DISCOVERY_BURST 4
+#define CONFIG_AQM_ESPNOW_DISCOVERY_OUTBOX 8192
+#define CONFIG_AQM_UI_TREND_DWELL_S 10
+#ifndef CONFIG_AQM_UI_GLYPH_CACHE
+#define CONFIG_AQM_UI_GLYPH_CACHE 1
+#endif
+#define CONFIG_AQM_HISTORY_RAW_SECONDS 3600
+#define CONFIG_AQM_HISTORY_MINUTE_HOURS 168
+#define CONFIG_AQM_HISTORY_HOUR_DAYS 56
+#define CONFIG_AQM_OUTBOX_RAM_RECORDS 3600
+#define CONFIG_AQM_OUTBOX_REPLAY_BATCH 10
+#define CONFIG_AQM_OUTBOX_REPLAY_INTERVAL_MS 200
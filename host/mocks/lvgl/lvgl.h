@@ -0,0 +1,287 @@
+#pragma once
+
+// Host stand-in for the subset of the LVGL 9 API used by ui.cpp. Objects
+// keep just enough state (label text, style list) to be inspected through
+// lvgl_mock.hpp; there is no layout or rendering.
+
+#include <cstddef>
+#include <cstdint>
+
+/* ── Basic types ─────────────────────────────────────────────────────── */
+
+struct lv_color_t {
+    uint8_t blue;
+    uint8_t green;
+    uint8_t red;
+};
+
+inline lv_color_t lv_color_hex(uint32_t c)
+{
+    return {static_cast<uint8_t>(c & 0xFF),
+            static_cast<uint8_t>((c >> 8) & 0xFF),
+            static_cast<uint8_t>((c >> 16) & 0xFF)};
+}
+
+struct lv_area_t {
+    int32_t x1;
+    int32_t y1;
+    int32_t x2;
+    int32_t y2;
+};
+
+inline uint32_t lv_area_get_size(const lv_area_t *area)
+{
+    return static_cast<uint32_t>((area->x2 - area->x1 + 1) * (area->y2 - area->y1 + 1));
+}
+
+using lv_opa_t = uint8_t;
+constexpr lv_opa_t LV_OPA_TRANSP = 0;
+constexpr lv_opa_t LV_OPA_COVER = 255;
+
+struct lv_font_t {
+    int32_t line_height;
+};
+
+/// Glyphs are 0.6 em wide on the host.
+int32_t lv_font_get_line_height(const lv_font_t *font);
+uint16_t lv_font_get_glyph_width(const lv_font_t *font, uint32_t letter, uint32_t letter_next);
+
+extern const lv_font_t lv_font_montserrat_14;
+extern const lv_font_t lv_font_montserrat_20;
+extern const lv_font_t lv_font_montserrat_24;
+extern const lv_font_t lv_font_montserrat_36;
+extern const lv_font_t lv_font_montserrat_48;
+
+using lv_style_selector_t = uint32_t;
+
+constexpr lv_style_selector_t LV_PART_MAIN = 0x000000;
+constexpr lv_style_selector_t LV_PART_INDICATOR = 0x020000;
+constexpr lv_style_selector_t LV_PART_ITEMS = 0x050000;
+
+#define LV_PCT(x) ((x) | (1 << 29))
+#define LV_SIZE_CONTENT (LV_COORD_MAX | (1 << 29))
+
+/* ── Images and draw buffers ─────────────────────────────────────────── */
+
+enum lv_color_format_t : uint8_t {
+    LV_COLOR_FORMAT_UNKNOWN = 0,
+    LV_COLOR_FORMAT_RGB565 = 0x12,
+};
+
+#define LV_IMAGE_HEADER_MAGIC 0x19
+#define LV_DRAW_BUF_ALIGN 4
+
+struct lv_image_header_t {
+    uint32_t magic : 8;
+    uint32_t cf : 8;
+    uint32_t flags : 16;
+    uint32_t w : 16;
+    uint32_t h : 16;
+    uint32_t stride : 16;
+    uint32_t reserved_2 : 16;
+};
+
+struct lv_image_dsc_t {
+    lv_image_header_t header;
+    uint32_t data_size;
+    const uint8_t *data;
+    const void *reserved;
+};
+
+uint32_t lv_draw_buf_width_to_stride(uint32_t w, lv_color_format_t color_format);
+
+/* ── Styles ──────────────────────────────────────────────────────────── */
+
+struct lv_style_t {
+    uint32_t set_props;
+    lv_color_t bg_color;
+    lv_opa_t bg_opa;
+    int32_t radius;
+    int32_t pad_all;
+    int32_t pad_row;
+    int32_t border_width;
+    const lv_font_t *text_font;
+    lv_color_t text_color;
+};
+
+void lv_style_init(lv_style_t *style);
+void lv_style_set_bg_color(lv_style_t *style, lv_color_t value);
+void lv_style_set_bg_opa(lv_style_t *style, lv_opa_t value);
+void lv_style_set_radius(lv_style_t *style, int32_t value);
+void lv_style_set_pad_all(lv_style_t *style, int32_t value);
+void lv_style_set_pad_row(lv_style_t *style, int32_t value);
+void lv_style_set_border_width(lv_style_t *style, int32_t value);
+void lv_style_set_text_font(lv_style_t *style, const lv_font_t *value);
+void lv_style_set_text_color(lv_style_t *style, lv_color_t value);
+
+/* ── Objects ─────────────────────────────────────────────────────────── */
+
+struct lv_obj_t;
+
+enum lv_obj_flag_t : uint32_t {
+    LV_OBJ_FLAG_HIDDEN = 1u << 0,
+    LV_OBJ_FLAG_CLICKABLE = 1u << 1,
+    LV_OBJ_FLAG_SCROLLABLE = 1u << 4,
+};
+
+enum lv_flex_flow_t {
+    LV_FLEX_FLOW_ROW = 0,
+    LV_FLEX_FLOW_COLUMN = 1,
+};
+
+enum lv_flex_align_t {
+    LV_FLEX_ALIGN_START,
+    LV_FLEX_ALIGN_END,
+    LV_FLEX_ALIGN_CENTER,
+    LV_FLEX_ALIGN_SPACE_EVENLY,
+    LV_FLEX_ALIGN_SPACE_AROUND,
+    LV_FLEX_ALIGN_SPACE_BETWEEN,
+};
+
+enum lv_grid_align_t {
+    LV_GRID_ALIGN_START,
+    LV_GRID_ALIGN_CENTER,
+    LV_GRID_ALIGN_END,
+    LV_GRID_ALIGN_STRETCH,
+};
+
+constexpr uint32_t LV_LAYOUT_NONE = 0;
+constexpr uint32_t LV_LAYOUT_FLEX = 1;
+constexpr uint32_t LV_LAYOUT_GRID = 2;
+
+#define LV_COORD_MAX          ((1 << 29) - 1)
+#define LV_GRID_FR(x)         (LV_COORD_MAX - 100 + (x))
+#define LV_GRID_CONTENT       (LV_COORD_MAX - 101)
+#define LV_GRID_TEMPLATE_LAST (LV_COORD_MAX)
+
+lv_obj_t *lv_screen_active();
+lv_obj_t *lv_obj_create(lv_obj_t *parent);
+void lv_obj_delete(lv_obj_t *obj);
+void lv_obj_remove_style_all(lv_obj_t *obj);
+void lv_obj_add_style(lv_obj_t *obj, const lv_style_t *style, lv_style_selector_t selector);
+void lv_obj_remove_style(lv_obj_t *obj, const lv_style_t *style, lv_style_selector_t selector);
+void lv_obj_add_flag(lv_obj_t *obj, lv_obj_flag_t f);
+void lv_obj_remove_flag(lv_obj_t *obj, lv_obj_flag_t f);
+#define lv_obj_clear_flag lv_obj_remove_flag
+void lv_obj_set_flex_flow(lv_obj_t *obj, lv_flex_flow_t flow);
+void lv_obj_set_flex_align(lv_obj_t *obj, lv_flex_align_t main_place,
+                           lv_flex_align_t cross_place, lv_flex_align_t track_cross_place);
+void lv_obj_set_layout(lv_obj_t *obj, uint32_t layout);
+void lv_obj_set_grid_dsc_array(lv_obj_t *obj, const int32_t col_dsc[], const int32_t row_dsc[]);
+void lv_obj_set_grid_cell(lv_obj_t *obj, lv_grid_align_t column_align, int32_t col_pos,
+                          int32_t col_span, lv_grid_align_t row_align, int32_t row_pos,
+                          int32_t row_span);
+void lv_obj_set_style_bg_color(lv_obj_t *obj, lv_color_t value, lv_style_selector_t selector);
+void lv_obj_set_style_bg_opa(lv_obj_t *obj, lv_opa_t value, lv_style_selector_t selector);
+void lv_obj_set_style_pad_all(lv_obj_t *obj, int32_t value, lv_style_selector_t selector);
+void lv_obj_set_style_pad_row(lv_obj_t *obj, int32_t value, lv_style_selector_t selector);
+void lv_obj_set_style_pad_column(lv_obj_t *obj, int32_t value, lv_style_selector_t selector);
+void lv_obj_set_style_line_color(lv_obj_t *obj, lv_color_t value, lv_style_selector_t selector);
+void lv_obj_set_style_line_width(lv_obj_t *obj, int32_t value, lv_style_selector_t selector);
+void lv_obj_set_style_size(lv_obj_t *obj, int32_t width, int32_t height,
+                           lv_style_selector_t selector);
+void lv_obj_set_size(lv_obj_t *obj, int32_t w, int32_t h);
+/// No layout on the host: bounds are the size passed to lv_obj_set_size()
+/// (absolute values only), else roughly a card cell of the 800x480 grid for
+/// objects and one line of 48 px text for labels.
+void lv_obj_get_coords(const lv_obj_t *obj, lv_area_t *coords);
+void lv_obj_set_flex_grow(lv_obj_t *obj, uint8_t grow);
+void lv_obj_invalidate(const lv_obj_t *obj);
+
+/* ── Screens ─────────────────────────────────────────────────────────── */
+
+/// lv_obj_create(nullptr) makes a screen; this makes it the active one.
+void lv_screen_load(lv_obj_t *scr);
+
+/* ── Label ───────────────────────────────────────────────────────────── */
+
+lv_obj_t *lv_label_create(lv_obj_t *parent);
+void lv_label_set_text(lv_obj_t *obj, const char *text);
+const char *lv_label_get_text(const lv_obj_t *obj);
+
+/* ── Image ───────────────────────────────────────────────────────────── */
+
+lv_obj_t *lv_image_create(lv_obj_t *parent);
+void lv_image_set_src(lv_obj_t *obj, const void *src);
+
+/* ── Canvas and drawing ──────────────────────────────────────────────── */
+
+// Canvas fills are real (RGB565); text is not rasterised.
+
+struct lv_layer_t {
+    lv_obj_t *canvas;
+};
+
+struct lv_draw_label_dsc_t {
+    const lv_font_t *font;
+    lv_color_t color;
+    const char *text;
+    lv_opa_t opa;
+};
+
+lv_obj_t *lv_canvas_create(lv_obj_t *parent);
+void lv_canvas_set_buffer(lv_obj_t *obj, void *buf, int32_t w, int32_t h, lv_color_format_t cf);
+void lv_canvas_fill_bg(lv_obj_t *obj, lv_color_t color, lv_opa_t opa);
+void lv_canvas_init_layer(lv_obj_t *canvas, lv_layer_t *layer);
+void lv_canvas_finish_layer(lv_obj_t *canvas, lv_layer_t *layer);
+void lv_draw_label_dsc_init(lv_draw_label_dsc_t *dsc);
+void lv_draw_label(lv_layer_t *layer, const lv_draw_label_dsc_t *dsc, const lv_area_t *coords);
+
+/* ── Chart ───────────────────────────────────────────────────────────── */
+
+enum lv_chart_type_t {
+    LV_CHART_TYPE_NONE,
+    LV_CHART_TYPE_LINE,
+    LV_CHART_TYPE_BAR,
+    LV_CHART_TYPE_SCATTER,
+};
+
+enum lv_chart_update_mode_t {
+    LV_CHART_UPDATE_MODE_SHIFT,
+    LV_CHART_UPDATE_MODE_CIRCULAR,
+};
+
+enum lv_chart_axis_t {
+    LV_CHART_AXIS_PRIMARY_Y = 0x00,
+    LV_CHART_AXIS_SECONDARY_Y = 0x01,
+    LV_CHART_AXIS_PRIMARY_X = 0x02,
+    LV_CHART_AXIS_SECONDARY_X = 0x04,
+};
+
+constexpr int32_t LV_CHART_POINT_NONE = INT32_MAX;
+
+struct lv_chart_series_t;
+
+lv_obj_t *lv_chart_create(lv_obj_t *parent);
+void lv_chart_set_type(lv_obj_t *obj, lv_chart_type_t type);
+void lv_chart_set_point_count(lv_obj_t *obj, uint32_t cnt);
+void lv_chart_set_update_mode(lv_obj_t *obj, lv_chart_update_mode_t update_mode);
+void lv_chart_set_range(lv_obj_t *obj, lv_chart_axis_t axis, int32_t min, int32_t max);
+void lv_chart_set_div_line_count(lv_obj_t *obj, uint8_t hdiv, uint8_t vdiv);
+lv_chart_series_t *lv_chart_add_series(lv_obj_t *obj, lv_color_t color, lv_chart_axis_t axis);
+void lv_chart_set_next_value(lv_obj_t *obj, lv_chart_series_t *ser, int32_t value);
+void lv_chart_set_all_value(lv_obj_t *obj, lv_chart_series_t *ser, int32_t value);
+void lv_chart_set_ext_y_array(lv_obj_t *obj, lv_chart_series_t *ser, int32_t array[]);
+int32_t *lv_chart_get_y_array(const lv_obj_t *obj, lv_chart_series_t *ser);
+void lv_chart_set_x_start_point(lv_obj_t *obj, lv_chart_series_t *ser, uint32_t id);
+void lv_chart_refresh(lv_obj_t *obj);
+
+/* ── Display events ──────────────────────────────────────────────────── */
+
+// Registered but never fired: there is no rendering on the host.
+
+struct lv_display_t;
+struct lv_event_t;
+using lv_event_cb_t = void (*)(lv_event_t *e);
+
+enum lv_event_code_t {
+    LV_EVENT_ALL = 0,
+    LV_EVENT_REFR_START = 45,
+    LV_EVENT_REFR_READY = 46,
+};
+
+lv_display_t *lv_display_get_default();
+void lv_display_add_event_cb(lv_display_t *disp, lv_event_cb_t event_cb,
+                             lv_event_code_t filter, void *user_data);
+lv_event_code_t lv_event_get_code(lv_event_t *e);
+void *lv_event_get_user_data(lv_event_t *e);
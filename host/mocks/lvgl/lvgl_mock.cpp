@@ -0,0 +1,308 @@
+// Host LVGL stand-in: tracks object state and counts the calls that would
+// restyle or invalidate on the real library.
+
+#include "lvgl_mock.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+const lv_font_t lv_font_montserrat_14 = {16};
+const lv_font_t lv_font_montserrat_20 = {22};
+const lv_font_t lv_font_montserrat_24 = {27};
+const lv_font_t lv_font_montserrat_36 = {40};
+const lv_font_t lv_font_montserrat_48 = {53};
+
+int32_t lv_font_get_line_height(const lv_font_t *font)
+{
+    return font->line_height;
+}
+
+uint16_t lv_font_get_glyph_width(const lv_font_t *font, uint32_t, uint32_t)
+{
+    return static_cast<uint16_t>(font->line_height * 6 / 10);
+}
+
+struct lv_obj_t {
+    static constexpr size_t kMaxStyles = 8;
+    static constexpr size_t kMaxText = 128;
+
+    lv_obj_t *parent{};
+    int32_t w{190};
+    int32_t h{180};
+    uint32_t flags{};
+    const lv_style_t *styles[kMaxStyles]{};
+    size_t style_count{};
+    char text[kMaxText]{};
+    const void *src{};
+
+    // Canvas
+    uint16_t *buf{};
+    int32_t buf_w{};
+    int32_t buf_h{};
+};
+
+namespace {
+
+LvMockStats s_stats{};
+lv_obj_t s_screen{};
+lv_obj_t *s_active = &s_screen;
+
+} // namespace
+
+const LvMockStats &lv_mock_stats() { return s_stats; }
+void lv_mock_reset_stats() { s_stats = {}; }
+
+size_t lv_mock_style_count(const lv_obj_t *obj) { return obj->style_count; }
+
+bool lv_mock_has_style(const lv_obj_t *obj, const lv_style_t *style)
+{
+    return std::find(obj->styles, obj->styles + obj->style_count, style) !=
+           obj->styles + obj->style_count;
+}
+
+/* ── Styles ──────────────────────────────────────────────────────────── */
+
+void lv_style_init(lv_style_t *style) { *style = {}; }
+void lv_style_set_bg_color(lv_style_t *style, lv_color_t value) { style->bg_color = value; }
+void lv_style_set_bg_opa(lv_style_t *style, lv_opa_t value) { style->bg_opa = value; }
+void lv_style_set_radius(lv_style_t *style, int32_t value) { style->radius = value; }
+void lv_style_set_pad_all(lv_style_t *style, int32_t value) { style->pad_all = value; }
+void lv_style_set_pad_row(lv_style_t *style, int32_t value) { style->pad_row = value; }
+void lv_style_set_border_width(lv_style_t *style, int32_t value) { style->border_width = value; }
+void lv_style_set_text_font(lv_style_t *style, const lv_font_t *value) { style->text_font = value; }
+void lv_style_set_text_color(lv_style_t *style, lv_color_t value) { style->text_color = value; }
+
+/* ── Objects ─────────────────────────────────────────────────────────── */
+
+lv_obj_t *lv_screen_active() { return s_active; }
+
+void lv_screen_load(lv_obj_t *scr)
+{
+    s_active = scr;
+    lv_obj_invalidate(scr);
+}
+
+lv_obj_t *lv_obj_create(lv_obj_t *parent)
+{
+    auto *obj = new lv_obj_t;
+    obj->parent = parent;
+    ++s_stats.objects_created;
+    return obj;
+}
+
+void lv_obj_delete(lv_obj_t *obj)
+{
+    if (obj != &s_screen) delete obj;
+}
+
+void lv_obj_remove_style_all(lv_obj_t *obj)
+{
+    obj->style_count = 0;
+    lv_obj_invalidate(obj);
+}
+
+void lv_obj_add_style(lv_obj_t *obj, const lv_style_t *style, lv_style_selector_t)
+{
+    if (obj->style_count < lv_obj_t::kMaxStyles) {
+        obj->styles[obj->style_count++] = style;
+    }
+    ++s_stats.style_add;
+    lv_obj_invalidate(obj);
+}
+
+void lv_obj_remove_style(lv_obj_t *obj, const lv_style_t *style, lv_style_selector_t)
+{
+    ++s_stats.style_remove;
+    auto *end = std::remove(obj->styles, obj->styles + obj->style_count, style);
+    const auto removed = static_cast<size_t>((obj->styles + obj->style_count) - end);
+    if (removed > 0) {
+        obj->style_count -= removed;
+        lv_obj_invalidate(obj);
+    }
+}
+
+void lv_obj_add_flag(lv_obj_t *obj, lv_obj_flag_t f) { obj->flags |= f; }
+void lv_obj_remove_flag(lv_obj_t *obj, lv_obj_flag_t f) { obj->flags &= ~f; }
+void lv_obj_set_flex_flow(lv_obj_t *, lv_flex_flow_t) {}
+void lv_obj_set_flex_align(lv_obj_t *, lv_flex_align_t, lv_flex_align_t, lv_flex_align_t) {}
+void lv_obj_set_layout(lv_obj_t *, uint32_t) {}
+void lv_obj_set_grid_dsc_array(lv_obj_t *, const int32_t[], const int32_t[]) {}
+void lv_obj_set_grid_cell(lv_obj_t *, lv_grid_align_t, int32_t, int32_t,
+                          lv_grid_align_t, int32_t, int32_t) {}
+void lv_obj_set_style_bg_color(lv_obj_t *, lv_color_t, lv_style_selector_t) {}
+void lv_obj_set_style_bg_opa(lv_obj_t *, lv_opa_t, lv_style_selector_t) {}
+void lv_obj_set_style_pad_all(lv_obj_t *, int32_t, lv_style_selector_t) {}
+void lv_obj_set_style_pad_row(lv_obj_t *, int32_t, lv_style_selector_t) {}
+void lv_obj_set_style_pad_column(lv_obj_t *, int32_t, lv_style_selector_t) {}
+void lv_obj_set_style_line_color(lv_obj_t *, lv_color_t, lv_style_selector_t) {}
+void lv_obj_set_style_line_width(lv_obj_t *, int32_t, lv_style_selector_t) {}
+void lv_obj_set_style_size(lv_obj_t *, int32_t, int32_t, lv_style_selector_t) {}
+void lv_obj_set_size(lv_obj_t *obj, int32_t w, int32_t h)
+{
+    if (w > 0 && w < LV_COORD_MAX / 2) obj->w = w;
+    if (h > 0 && h < LV_COORD_MAX / 2) obj->h = h;
+}
+
+void lv_obj_get_coords(const lv_obj_t *obj, lv_area_t *coords)
+{
+    *coords = {0, 0, obj->w - 1, obj->h - 1};
+}
+void lv_obj_set_flex_grow(lv_obj_t *, uint8_t) {}
+
+void lv_obj_invalidate(const lv_obj_t *)
+{
+    ++s_stats.invalidations;
+}
+
+/* ── Label ───────────────────────────────────────────────────────────── */
+
+lv_obj_t *lv_label_create(lv_obj_t *parent)
+{
+    auto *obj = lv_obj_create(parent);
+    obj->w = 120;
+    obj->h = 53;
+    return obj;
+}
+
+void lv_label_set_text(lv_obj_t *obj, const char *text)
+{
+    std::strncpy(obj->text, text, lv_obj_t::kMaxText - 1);
+    ++s_stats.label_set_text;
+    lv_obj_invalidate(obj);
+}
+
+const char *lv_label_get_text(const lv_obj_t *obj)
+{
+    return obj->text;
+}
+
+/* ── Image ───────────────────────────────────────────────────────────── */
+
+uint32_t lv_draw_buf_width_to_stride(uint32_t w, lv_color_format_t)
+{
+    return (w * 2 + LV_DRAW_BUF_ALIGN - 1) / LV_DRAW_BUF_ALIGN * LV_DRAW_BUF_ALIGN;
+}
+
+lv_obj_t *lv_image_create(lv_obj_t *parent)
+{
+    return lv_obj_create(parent);
+}
+
+void lv_image_set_src(lv_obj_t *obj, const void *src)
+{
+    if (src) {
+        const auto &h = static_cast<const lv_image_dsc_t *>(src)->header;
+        obj->w = h.w;
+        obj->h = h.h;
+    }
+    obj->src = src;
+    ++s_stats.image_set_src;
+    lv_obj_invalidate(obj);
+}
+
+/* ── Canvas and drawing ──────────────────────────────────────────────── */
+
+lv_obj_t *lv_canvas_create(lv_obj_t *parent)
+{
+    return lv_obj_create(parent);
+}
+
+void lv_canvas_set_buffer(lv_obj_t *obj, void *buf, int32_t w, int32_t h, lv_color_format_t)
+{
+    obj->buf = static_cast<uint16_t *>(buf);
+    obj->buf_w = w;
+    obj->buf_h = h;
+}
+
+void lv_canvas_fill_bg(lv_obj_t *obj, lv_color_t color, lv_opa_t)
+{
+    const auto px = static_cast<uint16_t>(((color.red & 0xF8) << 8) |
+                                          ((color.green & 0xFC) << 3) | (color.blue >> 3));
+    const auto stride = lv_draw_buf_width_to_stride(obj->buf_w, LV_COLOR_FORMAT_RGB565) / 2;
+    for (int32_t y = 0; y < obj->buf_h; ++y) {
+        std::fill_n(obj->buf + y * stride, obj->buf_w, px);
+    }
+}
+
+void lv_canvas_init_layer(lv_obj_t *canvas, lv_layer_t *layer) { layer->canvas = canvas; }
+void lv_canvas_finish_layer(lv_obj_t *, lv_layer_t *) {}
+void lv_draw_label_dsc_init(lv_draw_label_dsc_t *dsc) { *dsc = {}; dsc->opa = LV_OPA_COVER; }
+void lv_draw_label(lv_layer_t *, const lv_draw_label_dsc_t *, const lv_area_t *) {}
+
+/* ── Chart ───────────────────────────────────────────────────────────── */
+
+struct lv_chart_series_t {
+    int32_t last;
+    int32_t *y;   // external array, if set
+};
+
+lv_obj_t *lv_chart_create(lv_obj_t *parent)
+{
+    return lv_obj_create(parent);
+}
+
+void lv_chart_set_type(lv_obj_t *, lv_chart_type_t) {}
+void lv_chart_set_point_count(lv_obj_t *obj, uint32_t) { lv_obj_invalidate(obj); }
+void lv_chart_set_update_mode(lv_obj_t *, lv_chart_update_mode_t) {}
+void lv_chart_set_div_line_count(lv_obj_t *, uint8_t, uint8_t) {}
+
+void lv_chart_set_range(lv_obj_t *obj, lv_chart_axis_t, int32_t, int32_t)
+{
+    ++s_stats.chart_range_changes;
+    lv_obj_invalidate(obj);
+}
+
+lv_chart_series_t *lv_chart_add_series(lv_obj_t *, lv_color_t, lv_chart_axis_t)
+{
+    return new lv_chart_series_t{LV_CHART_POINT_NONE, nullptr};
+}
+
+void lv_chart_set_next_value(lv_obj_t *obj, lv_chart_series_t *ser, int32_t value)
+{
+    ser->last = value;
+    ++s_stats.chart_points;
+    lv_obj_invalidate(obj);
+}
+
+void lv_chart_set_all_value(lv_obj_t *obj, lv_chart_series_t *ser, int32_t value)
+{
+    ser->last = value;
+    lv_obj_invalidate(obj);
+}
+
+void lv_chart_set_ext_y_array(lv_obj_t *obj, lv_chart_series_t *ser, int32_t array[])
+{
+    ser->y = array;
+    lv_obj_invalidate(obj);
+}
+
+int32_t *lv_chart_get_y_array(const lv_obj_t *, lv_chart_series_t *ser)
+{
+    return ser->y;
+}
+
+void lv_chart_set_x_start_point(lv_obj_t *, lv_chart_series_t *, uint32_t) {}
+
+void lv_chart_refresh(lv_obj_t *obj)
+{
+    ++s_stats.chart_refreshes;
+    lv_obj_invalidate(obj);
+}
+
+/* ── Display events ──────────────────────────────────────────────────── */
+
+struct lv_display_t {};
+struct lv_event_t {
+    lv_event_code_t code;
+    void *user_data;
+};
+
+lv_display_t *lv_display_get_default()
+{
+    static lv_display_t disp;
+    return &disp;
+}
+
+void lv_display_add_event_cb(lv_display_t *, lv_event_cb_t, lv_event_code_t, void *) {}
+lv_event_code_t lv_event_get_code(lv_event_t *e) { return e->code; }
+void *lv_event_get_user_data(lv_event_t *e) { return e->user_data; }
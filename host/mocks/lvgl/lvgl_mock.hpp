@@ -0,0 +1,27 @@
+#pragma once
+
+// Inspection hooks for the host LVGL stand-in.
+
+#include "lvgl.h"
+
+#include <cstdint>
+
+/// Counts of the operations that make real LVGL restyle or redraw.
+struct LvMockStats {
+    uint64_t objects_created;
+    uint64_t label_set_text;
+    uint64_t image_set_src;
+    uint64_t style_add;
+    uint64_t style_remove;
+    uint64_t invalidations;
+    uint64_t chart_points;         // lv_chart_set_next_value
+    uint64_t chart_range_changes;  // lv_chart_set_range
+    uint64_t chart_refreshes;      // lv_chart_refresh
+};
+
+const LvMockStats &lv_mock_stats();
+void lv_mock_reset_stats();
+
+/// Number of styles currently attached to `obj`.
+size_t lv_mock_style_count(const lv_obj_t *obj);
+bool lv_mock_has_style(const lv_obj_t *obj, const lv_style_t *style);
@@ -0,0 +1,212 @@
+// Host replacement for mqtt.cpp: no network, publishes are copied into a
+// single message slot (standing in for the esp-mqtt outbox) and counted.
+// Retained messages are kept, as a broker would, and delivered to matching
+// subscriptions in esp-mqtt sized pieces.
+
+#include "mqtt.hpp"
+#include "mqtt_mock.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+MqttMockStats s_stats{};
+MqttMockMessage s_last{};
+bool s_initialised{false};
+bool s_connected{false};
+mqtt_connect_cb_t s_on_connect{};
+mqtt_data_cb_t s_on_data{};
+mqtt_published_cb_t s_on_published{};
+bool s_track_outbox{false};
+size_t s_outbox_bytes{};
+
+// Fixed tables, so the broker side adds no heap traffic to the benches
+constexpr size_t kMaxRetained = 160;  // a gateway's fleet of node configs
+constexpr size_t kMaxSubscriptions = 8;
+constexpr size_t kFragment = 1024;  // esp-mqtt default buffer size
+
+struct Retained {
+    char topic[128];
+    char data[8192];
+    size_t len;
+};
+
+Retained s_retained[kMaxRetained]{};
+char s_subscriptions[kMaxSubscriptions][128]{};
+
+/// MQTT topic filter match, with + and # wildcards.
+bool Matches(const char *filter, const char *topic)
+{
+    while (*filter && *topic) {
+        if (*filter == '#') return true;
+        if (*filter == '+') {
+            while (*topic && *topic != '/') ++topic;
+            ++filter;
+            continue;
+        }
+        if (*filter != *topic) return false;
+        ++filter;
+        ++topic;
+    }
+    return (*filter == '\0' || std::strcmp(filter, "/#") == 0) && *topic == '\0';
+}
+
+void Deliver(const char *topic, const char *data, size_t len)
+{
+    if (!s_on_data) return;
+    const int topic_len = static_cast<int>(std::strlen(topic));
+    size_t offset = 0;
+    do {
+        const size_t n = std::min(kFragment, len - offset);
+        s_on_data(offset == 0 ? topic : nullptr, offset == 0 ? topic_len : 0,
+                  data + offset, static_cast<int>(n),
+                  static_cast<int>(offset), static_cast<int>(len));
+        offset += n;
+    } while (offset < len);
+}
+
+void Retain(const char *topic, const char *data, size_t len)
+{
+    Retained *slot = nullptr;
+    for (auto &r : s_retained) {
+        if (r.topic[0] != '\0' && std::strcmp(r.topic, topic) == 0) {
+            slot = &r;
+            break;
+        }
+        if (!slot && r.topic[0] == '\0') slot = &r;
+    }
+    if (!slot) return;
+    if (len == 0) {  // an empty retained message clears the topic
+        slot->topic[0] = '\0';
+        return;
+    }
+    std::strncpy(slot->topic, topic, sizeof(slot->topic) - 1);
+    slot->len = std::min(len, sizeof(slot->data));
+    std::memcpy(slot->data, data, slot->len);
+}
+
+} // namespace
+
+esp_err_t mqtt_init(const char * /*device_id*/,
+                    mqtt_connect_cb_t on_connect,
+                    mqtt_data_cb_t on_data)
+{
+    s_on_connect = on_connect;
+    s_on_data = on_data;
+    s_initialised = true;
+    return ESP_OK;
+}
+
+void mqtt_set_published_cb(mqtt_published_cb_t cb)
+{
+    s_on_published = cb;
+}
+
+bool mqtt_is_connected()
+{
+    return s_connected;
+}
+
+int mqtt_outbox_bytes()
+{
+    return static_cast<int>(s_outbox_bytes);
+}
+
+int mqtt_publish(const char *topic, const char *data, int qos, bool retain)
+{
+    if (!s_initialised) return -1;
+
+    const size_t len = std::strlen(data);
+    std::strncpy(s_last.topic, topic, sizeof(s_last.topic) - 1);
+    s_last.len = std::min(len, sizeof(s_last.data) - 1);
+    std::memcpy(s_last.data, data, s_last.len);
+    s_last.data[s_last.len] = '\0';
+    s_last.qos = qos;
+    s_last.retain = retain;
+
+    ++s_stats.publishes;
+    s_stats.payload_bytes += len;
+    if (s_track_outbox && qos > 0) {
+        s_outbox_bytes += len;
+        s_stats.outbox_peak = std::max<uint64_t>(s_stats.outbox_peak, s_outbox_bytes);
+    }
+    const int msg_id = static_cast<int>(s_stats.publishes);
+
+    if (retain) Retain(topic, data, len);
+    for (const auto &filter : s_subscriptions) {
+        if (filter[0] != '\0' && Matches(filter, topic)) {
+            Deliver(topic, data, len);
+            break;
+        }
+    }
+    return msg_id;
+}
+
+int mqtt_subscribe(const char *topic, int /*qos*/)
+{
+    if (!s_initialised) return -1;
+    ++s_stats.subscribes;
+    for (auto &filter : s_subscriptions) {
+        if (filter[0] == '\0') {
+            std::strncpy(filter, topic, sizeof(filter) - 1);
+            break;
+        }
+    }
+    for (const auto &r : s_retained) {
+        if (r.topic[0] != '\0' && Matches(topic, r.topic)) Deliver(r.topic, r.data, r.len);
+    }
+    return static_cast<int>(s_stats.subscribes);
+}
+
+int mqtt_unsubscribe(const char *topic)
+{
+    if (!s_initialised) return -1;
+    for (auto &filter : s_subscriptions) {
+        if (std::strcmp(filter, topic) == 0) filter[0] = '\0';
+    }
+    return static_cast<int>(s_stats.subscribes);
+}
+
+const MqttMockStats &mqtt_mock_stats() { return s_stats; }
+void mqtt_mock_reset_stats() { s_stats = {}; }
+const MqttMockMessage &mqtt_mock_last() { return s_last; }
+
+void mqtt_mock_clear_retained()
+{
+    for (auto &r : s_retained) r.topic[0] = '\0';
+}
+
+size_t mqtt_mock_retained_count()
+{
+    size_t n = 0;
+    for (const auto &r : s_retained) n += r.topic[0] != '\0';
+    return n;
+}
+
+void mqtt_mock_track_outbox(bool on)
+{
+    s_track_outbox = on;
+    s_outbox_bytes = 0;
+}
+
+void mqtt_mock_drain_outbox(size_t bytes)
+{
+    s_outbox_bytes -= std::min(bytes, s_outbox_bytes);
+}
+
+void mqtt_mock_ack(int msg_id)
+{
+    if (s_on_published) {
+        s_on_published(msg_id);
+    }
+}
+
+void mqtt_mock_set_connected(bool connected)
+{
+    const bool was = s_connected;
+    s_connected = connected;
+    if (connected && !was && s_on_connect) {
+        s_on_connect();
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+// Inspection hooks for the host replacement of mqtt.cpp.
+
+#include <cstddef>
+#include <cstdint>
+
+struct MqttMockStats {
+    uint64_t publishes;
+    uint64_t payload_bytes;
+    uint64_t subscribes;
+    uint64_t outbox_peak;  // bytes, while tracked
+};
+
+struct MqttMockMessage {
+    char topic[128];
+    char data[2048];
+    size_t len;
+    int qos;
+    bool retain;
+};
+
+const MqttMockStats &mqtt_mock_stats();
+void mqtt_mock_reset_stats();
+
+/// Most recently published message (topic and payload copied, like the outbox).
+const MqttMockMessage &mqtt_mock_last();
+
+/// Forget every retained message, like a fresh broker.
+void mqtt_mock_clear_retained();
+
+/// Topics with a retained message.
+size_t mqtt_mock_retained_count();
+
+/// Model the esp-mqtt outbox: QoS 1/2 payloads count towards
+/// mqtt_outbox_bytes() until mqtt_mock_drain_outbox() sends them. Off by
+/// default, when the outbox always reads 0.
+void mqtt_mock_track_outbox(bool on);
+
+/// The network takes `bytes` off the outbox.
+void mqtt_mock_drain_outbox(size_t bytes);
+
+/// Simulate the broker's PUBACK for `msg_id` (fires the published callback).
+void mqtt_mock_ack(int msg_id);
+
+/// Simulate broker (dis)connection. Connecting fires the on_connect callback.
+void mqtt_mock_set_connected(bool connected);
@@ -0,0 +1,41 @@
+// LVGL configuration for the host render harness (cyd_ui_render): the
+// firmware's colour depth, fonts and widgets, single-threaded, with
+// LVGL's own heap so its usage can be read back with lv_mem_monitor().
+// Anything not set here takes LVGL's default.
+
+#ifndef LV_CONF_H
+#define LV_CONF_H
+
+#define LV_COLOR_DEPTH 16
+
+#define LV_USE_STDLIB_MALLOC    LV_STDLIB_BUILTIN
+#define LV_USE_STDLIB_STRING    LV_STDLIB_CLIB
+#define LV_USE_STDLIB_SPRINTF   LV_STDLIB_CLIB
+#define LV_MEM_SIZE             (512 * 1024U)
+
+#define LV_USE_OS               LV_OS_NONE
+#define LV_USE_DRAW_SW          1
+#define LV_DRAW_SW_DRAW_UNIT_CNT 1
+
+#define LV_USE_LOG              0
+#define LV_USE_ASSERT_NULL      1
+#define LV_USE_ASSERT_MALLOC    1
+
+#define LV_FONT_MONTSERRAT_14   1
+#define LV_FONT_MONTSERRAT_20   1
+#define LV_FONT_MONTSERRAT_24   1
+#define LV_FONT_MONTSERRAT_36   1
+#define LV_FONT_MONTSERRAT_48   1
+#define LV_FONT_DEFAULT         &lv_font_montserrat_14
+
+#define LV_USE_LABEL            1
+#define LV_USE_IMAGE            1
+#define LV_USE_CANVAS           1
+#define LV_USE_CHART            1
+#define LV_USE_FLEX             1
+#define LV_USE_GRID             1
+#define LV_USE_THEME_DEFAULT    1
+
+#define LV_BUILD_EXAMPLES       0
+
+#endif // LV_CONF_H
@@ -0,0 +1,281 @@
+// Renders the Ui with real LVGL into a memory-backed 800x480 RGB565
+// display and reports what each frame costs.
+//
+//   cyd_ui_render [--frames <per sequence>] [--dump <dir>] [--dump-every <n>]
+//
+// Replays measurement sequences through UpdateMeasurements() and
+// SetStatus(), one reading per frame, rendering each with lv_refr_now():
+//
+//   steady    readings that move within one display step: few frames draw
+//   jittery   every value moves a few display steps each frame
+//   crossing  values straddle severity thresholds: card colours flip
+//   trend     the last-hour trend screen, a reading per frame, a point
+//             every 15
+//
+// For each: render time per frame (mean, p50, p99, max), dirty pixels and
+// flushes per frame, and LVGL heap (in use after, peak). With --dump,
+// frames are written as binary PPM to <dir>/<sequence>_<frame>.ppm; the
+// first frame of every sequence is always dumped.
+//
+// cyd_ui_render_labels is the same with the glyph sprite cache disabled.
+
+#include "history.hpp"
+#include "ui.hpp"
+
+#include "esp_log.h"
+#include "lvgl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr int32_t kHRes = 800;
+constexpr int32_t kVRes = 480;
+constexpr int32_t kDrawBufLines = 20;  // CONFIG_AQM_DISPLAY_DRAW_BUF_LINES default
+
+struct Args {
+    int frames = 300;
+    const char* dump_dir = nullptr;
+    int dump_every = 0;
+};
+
+Args ParseArgs(int argc, char** argv)
+{
+    Args a;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* k = argv[i];
+        const char* v = argv[i + 1];
+        if (std::strcmp(k, "--frames") == 0)          a.frames = std::max(1, std::atoi(v));
+        else if (std::strcmp(k, "--dump") == 0)       a.dump_dir = v;
+        else if (std::strcmp(k, "--dump-every") == 0) a.dump_every = std::atoi(v);
+    }
+    return a;
+}
+
+/* ── Memory-backed display ───────────────────────────────────────────── */
+
+// What the panel would show, and what the last frame flushed into it
+std::vector<uint16_t> s_panel(kHRes * kVRes);
+uint64_t s_frame_px;
+uint32_t s_frame_flushes;
+
+void Flush(lv_display_t* disp, const lv_area_t* area, uint8_t* px_map)
+{
+    const int32_t w = lv_area_get_width(area);
+    const auto* src = reinterpret_cast<const uint16_t*>(px_map);
+    for (int32_t y = area->y1; y <= area->y2; ++y, src += w) {
+        std::memcpy(&s_panel[y * kHRes + area->x1], src, w * sizeof(uint16_t));
+    }
+    s_frame_px += lv_area_get_size(area);
+    ++s_frame_flushes;
+    lv_display_flush_ready(disp);
+}
+
+uint32_t TickMs()
+{
+    using namespace std::chrono;
+    static const auto t0 = steady_clock::now();
+    return static_cast<uint32_t>(
+        duration_cast<milliseconds>(steady_clock::now() - t0).count());
+}
+
+lv_display_t* MakeDisplay()
+{
+    static std::vector<uint8_t> buf1(kHRes * kDrawBufLines * 2);
+    static std::vector<uint8_t> buf2(kHRes * kDrawBufLines * 2);
+    auto* disp = lv_display_create(kHRes, kVRes);
+    lv_display_set_color_format(disp, LV_COLOR_FORMAT_RGB565);
+    lv_display_set_buffers(disp, buf1.data(), buf2.data(), buf1.size(),
+                           LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_display_set_flush_cb(disp, Flush);
+    return disp;
+}
+
+void DumpPpm(const char* dir, const char* name, int frame)
+{
+    char path[256];
+    std::snprintf(path, sizeof(path), "%s/%s_%04d.ppm", dir, name, frame);
+    FILE* f = std::fopen(path, "wb");
+    if (!f) {
+        std::perror(path);
+        return;
+    }
+    std::fprintf(f, "P6\n%d %d\n255\n", kHRes, kVRes);
+    std::vector<uint8_t> row(kHRes * 3);
+    for (int32_t y = 0; y < kVRes; ++y) {
+        for (int32_t x = 0; x < kHRes; ++x) {
+            const uint16_t px = s_panel[y * kHRes + x];
+            row[x * 3 + 0] = static_cast<uint8_t>((px >> 11) << 3);
+            row[x * 3 + 1] = static_cast<uint8_t>(((px >> 5) & 0x3F) << 2);
+            row[x * 3 + 2] = static_cast<uint8_t>((px & 0x1F) << 3);
+        }
+        std::fwrite(row.data(), 1, row.size(), f);
+    }
+    std::fclose(f);
+}
+
+/* ── Measurement sequences ───────────────────────────────────────────── */
+
+// A clean-air baseline, in the "good" band for every card
+constexpr Sen55::Measurement kBase = {
+    .pm1_0 = 4.2f, .pm2_5 = 6.8f, .pm4_0 = 8.1f, .pm10 = 9.0f,
+    .humidity = 45.0f, .temperature = 21.5f, .voc_index = 100, .nox_index = 1,
+};
+
+Sen55::Measurement Steady(int i, std::minstd_rand& rng)
+{
+    // Sensor noise below the 0.1 display step, and an occasional real move
+    std::uniform_real_distribution<float> noise(-0.02f, 0.02f);
+    auto m = kBase;
+    m.pm2_5 += noise(rng) + (i / 60) * 0.1f;
+    m.temperature += noise(rng);
+    return m;
+}
+
+Sen55::Measurement Jittery(int, std::minstd_rand& rng)
+{
+    std::uniform_real_distribution<float> step(-0.5f, 0.5f);
+    std::uniform_int_distribution<int> index(-5, 5);
+    auto m = kBase;
+    for (float* v : {&m.pm1_0, &m.pm2_5, &m.pm4_0, &m.pm10, &m.humidity, &m.temperature}) {
+        *v += step(rng);
+    }
+    m.voc_index += index(rng);
+    m.nox_index += std::abs(index(rng));
+    return m;
+}
+
+Sen55::Measurement Crossing(int i, std::minstd_rand&)
+{
+    // Alternate just either side of each card's first threshold
+    const float s = i % 2 ? 1.f : -1.f;
+    Sen55::Measurement m;
+    m.pm1_0 = 12.f + 0.5f * s;
+    m.pm2_5 = 12.f + 0.5f * s;
+    m.pm4_0 = 25.f + 0.5f * s;
+    m.pm10 = 54.f + 0.5f * s;
+    m.temperature = 24.f + 0.5f * s;
+    m.humidity = 60.f + 0.5f * s;
+    m.voc_index = 150.f + 5 * s;
+    m.nox_index = 20.f + 5 * s;
+    return m;
+}
+
+/* ── Reporting ───────────────────────────────────────────────────────── */
+
+struct Frames {
+    std::vector<double> us;
+    uint64_t px = 0;
+    uint64_t flushes = 0;
+    uint32_t drawn = 0;   // frames that flushed anything
+};
+
+Frames s_frames;
+
+/** Renders one frame and records its cost. */
+void Render(const Args& args, const char* name, int frame)
+{
+    s_frame_px = 0;
+    s_frame_flushes = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    lv_refr_now(nullptr);
+    const auto t1 = std::chrono::steady_clock::now();
+
+    s_frames.us.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+    s_frames.px += s_frame_px;
+    s_frames.flushes += s_frame_flushes;
+    s_frames.drawn += s_frame_flushes != 0;
+
+    if (args.dump_dir &&
+        (frame == 0 || (args.dump_every > 0 && frame % args.dump_every == 0))) {
+        DumpPpm(args.dump_dir, name, frame);
+    }
+}
+
+void Report(const char* name)
+{
+    auto& f = s_frames;
+    std::vector<double> sorted = f.us;
+    std::sort(sorted.begin(), sorted.end());
+    const size_t n = sorted.size();
+    double sum = 0;
+    for (double us : sorted) sum += us;
+
+    lv_mem_monitor_t mem;
+    lv_mem_monitor(&mem);
+    std::printf("%-9s %5zu %5u %9.1f %9.1f %9.1f %9.1f %10.0f %7.1f %8u %8u\n",
+                name, n, f.drawn, sum / n, sorted[n / 2], sorted[n * 99 / 100],
+                sorted[n - 1], double(f.px) / n, double(f.flushes) / n,
+                static_cast<unsigned>((mem.total_size - mem.free_size) / 1024),
+                static_cast<unsigned>(mem.max_used / 1024));
+    f = {};
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto args = ParseArgs(argc, argv);
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    lv_init();
+    lv_tick_set_cb(TickMs);
+    MakeDisplay();
+
+    History history({.raw = 3600, .minute = 60, .hour = 24});
+    Ui ui;
+    ui.SetHistory(&history);
+
+    std::printf("glyph cache: %s\n\n", ui.UsesGlyphCache() ? "on" : "off");
+    std::printf("%-9s %5s %5s %9s %9s %9s %9s %10s %7s %8s %8s\n",
+                "sequence", "frames", "drawn", "mean us", "p50 us", "p99 us", "max us",
+                "dirty px", "flushes", "heap KiB", "peak KiB");
+
+    // Bring the screen up once so the first sequence starts from a drawn frame
+    ui.UpdateMeasurements(kBase);
+    lv_refr_now(nullptr);
+
+    struct Sequence {
+        const char* name;
+        Sen55::Measurement (*next)(int, std::minstd_rand&);
+    };
+    const Sequence sequences[] = {
+        {"steady", Steady}, {"jittery", Jittery}, {"crossing", Crossing},
+    };
+
+    std::minstd_rand rng(1);
+    int64_t t_us = 0;
+    for (const auto& seq : sequences) {
+        for (int i = 0; i < args.frames; ++i) {
+            const auto m = seq.next(i, rng);
+            history.Append(t_us += 1'000'000, m);
+            char status[32];
+            std::snprintf(status, sizeof(status), "Updated 12:%02d:%02d",
+                          (i / 60) % 60, i % 60);
+            ui.UpdateMeasurements(m);
+            ui.SetStatus(status);
+            Render(args, seq.name, i);
+        }
+        Report(seq.name);
+    }
+
+    // An hour of readings behind the trend, then one per frame
+    for (int i = 0; i < 3600; ++i) {
+        history.Append(t_us += 1'000'000, Jittery(i, rng));
+    }
+    ui.ShowTrend(History::Channel::kPm2_5, Ui::TrendRange::kHour);
+    for (int i = 0; i < args.frames; ++i) {
+        history.Append(t_us += 1'000'000, Jittery(i, rng));
+        ui.UpdateTrend();
+        Render(args, "trend", i);
+    }
+    Report("trend");
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include "espnow_loopback.hpp"
+
+#include <cstring>
+#include <utility>
+
+esp_err_t EspNowLoopback::Start(RecvFn fn, void* ctx)
+{
+    ctx_ = ctx;
+    fn_.store(fn, std::memory_order_release);
+    return ESP_OK;
+}
+
+esp_err_t EspNowLoopback::Send(const uint8_t* mac, const uint8_t* data, size_t len)
+{
+    Sent s;
+    std::memcpy(s.mac, mac, sizeof(s.mac));
+    s.data.assign(data, data + len);
+    std::lock_guard lock(mu_);
+    sent_.push_back(std::move(s));
+    return ESP_OK;
+}
+
+bool EspNowLoopback::Deliver(const uint8_t* mac, const uint8_t* data, size_t len, int8_t rssi)
+{
+    const RecvFn fn = fn_.load(std::memory_order_acquire);
+    if (!fn) return false;
+    fn(ctx_, mac, data, len, rssi);
+    return true;
+}
+
+std::vector<EspNowLoopback::Sent> EspNowLoopback::TakeSent()
+{
+    std::lock_guard lock(mu_);
+    return std::exchange(sent_, {});
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "espnow_transport.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * In-process EspNowTransport: frames handed to Deliver() reach the receive
+ * hook synchronously on the caller's thread, the way the Wi-Fi task calls
+ * it on the device, and frames the bridge sends are recorded.
+ */
+class EspNowLoopback final : public EspNowTransport {
+public:
+    struct Sent {
+        uint8_t mac[6];
+        std::vector<uint8_t> data;
+    };
+
+    esp_err_t Start(RecvFn fn, void* ctx) override;
+    esp_err_t Send(const uint8_t* mac, const uint8_t* data, size_t len) override;
+
+    /** One frame "over the air" from `mac`. False before Start(). */
+    bool Deliver(const uint8_t* mac, const uint8_t* data, size_t len, int8_t rssi = -60);
+
+    /** Frames the bridge has sent so far. */
+    std::vector<Sent> TakeSent();
+
+private:
+    std::atomic<RecvFn> fn_{};
+    void* ctx_{};
+    std::mutex mu_;
+    std::vector<Sent> sent_;
+};
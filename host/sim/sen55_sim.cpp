@@ -0,0 +1,204 @@
+#include "sen55_sim.hpp"
+
+#include "esp_timer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr uint16_t kCmdStartMeasurement = 0x0021;
+constexpr uint16_t kCmdStopMeasurement = 0x0104;
+constexpr uint16_t kCmdReadDataReady = 0x0202;
+constexpr uint16_t kCmdReadMeasuredValues = 0x03C4;
+
+// Matches the IDF I2C master driver's result for an unacknowledged transfer.
+constexpr esp_err_t kNack = ESP_ERR_INVALID_STATE;
+
+// "Unknown" markers the SEN55 reports before its first sample
+constexpr uint16_t kUnknownUnsigned = 0xFFFF;
+constexpr uint16_t kUnknownSigned = 0x7FFF;
+
+} // namespace
+
+Sen55Sim::Sen55Sim() : Sen55Sim(Config{}) {}
+
+Sen55Sim::Sen55Sim(Config cfg)
+    : cfg_(std::move(cfg)), rng_(cfg_.seed)
+{
+}
+
+sen55_frame::MeasuredWords Sen55Sim::DefaultValues(uint32_t index)
+{
+    const double t = static_cast<double>(index);
+    const double pm = 8.0 + 30.0 * (1.0 + std::sin(t / 600.0));      // µg/m³
+    const double rh = 45.0 + 10.0 * std::sin(t / 1800.0);            // %RH
+    const double temp = 22.0 + 3.0 * std::sin(t / 3600.0);           // °C
+    const double voc = 100.0 + 80.0 * (1.0 + std::sin(t / 900.0));   // index
+    const double nox = 1.0 + 20.0 * (1.0 + std::sin(t / 1200.0));    // index
+
+    return {
+        static_cast<uint16_t>(pm * 0.6 * 10),
+        static_cast<uint16_t>(pm * 10),
+        static_cast<uint16_t>(pm * 1.2 * 10),
+        static_cast<uint16_t>(pm * 1.4 * 10),
+        static_cast<uint16_t>(static_cast<int16_t>(rh * 100)),
+        static_cast<uint16_t>(static_cast<int16_t>(temp * 200)),
+        static_cast<uint16_t>(static_cast<int16_t>(voc * 10)),
+        static_cast<uint16_t>(static_cast<int16_t>(nox * 10)),
+    };
+}
+
+int64_t Sen55Sim::SampleTimeUs(uint32_t index) const
+{
+    std::lock_guard lock(mutex_);
+    const double period_us =
+        cfg_.sample_interval_ms * 1000.0 * (1.0 + cfg_.clock_error_ppm / 1e6);
+    return start_us_ + int64_t{cfg_.first_sample_ms} * 1000 +
+           static_cast<int64_t>(index * period_us);
+}
+
+uint64_t Sen55Sim::SamplesAt(int64_t now_us) const
+{
+    if (!measuring_) return 0;
+    const int64_t first_us = start_us_ + int64_t{cfg_.first_sample_ms} * 1000;
+    if (now_us < first_us) return 0;
+    const double period_us =
+        cfg_.sample_interval_ms * 1000.0 * (1.0 + cfg_.clock_error_ppm / 1e6);
+    return 1 + static_cast<uint64_t>(static_cast<double>(now_us - first_us) / period_us);
+}
+
+bool Sen55Sim::Roll(double rate)
+{
+    return rate > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < rate;
+}
+
+esp_err_t Sen55Sim::Transmit(const uint8_t* data, size_t len)
+{
+    std::lock_guard lock(mutex_);
+    const auto now = esp_timer_get_time();
+
+    if (pending_nacks_ > 0) {
+        --pending_nacks_;
+        ++stats_.nacks_injected;
+        return kNack;
+    }
+    if (Roll(cfg_.nack_rate)) {
+        ++stats_.nacks_injected;
+        return kNack;
+    }
+    if (len < 2) {
+        return kNack;
+    }
+
+    const auto cmd = static_cast<uint16_t>((data[0] << 8) | data[1]);
+    ++stats_.commands;
+    stats_.samples_produced = SamplesAt(now);
+
+    switch (cmd) {
+    case kCmdStartMeasurement:
+        if (!measuring_) {
+            measuring_ = true;
+            start_us_ = now;
+            last_read_sample_ = 0;
+        }
+        have_pending_cmd_ = false;
+        return ESP_OK;
+    case kCmdStopMeasurement:
+        measuring_ = false;
+        have_pending_cmd_ = false;
+        return ESP_OK;
+    case kCmdReadDataReady:
+    case kCmdReadMeasuredValues:
+        pending_cmd_ = cmd;
+        have_pending_cmd_ = true;
+        cmd_us_ = now;
+        return ESP_OK;
+    default:
+        have_pending_cmd_ = false;
+        return kNack;
+    }
+}
+
+esp_err_t Sen55Sim::Receive(uint8_t* data, size_t len)
+{
+    std::lock_guard lock(mutex_);
+    const auto now = esp_timer_get_time();
+
+    if (pending_nacks_ > 0) {
+        --pending_nacks_;
+        ++stats_.nacks_injected;
+        return kNack;
+    }
+    if (Roll(cfg_.nack_rate)) {
+        ++stats_.nacks_injected;
+        return kNack;
+    }
+    if (!have_pending_cmd_) {
+        return kNack;
+    }
+    if (now - cmd_us_ < int64_t{cfg_.exec_time_ms} * 1000) {
+        ++stats_.nacks_busy;
+        return kNack;
+    }
+
+    const auto produced = SamplesAt(now);
+    stats_.samples_produced = produced;
+
+    uint16_t words[sen55_frame::kMeasuredWordCount]{};
+    size_t count = 0;
+
+    if (pending_cmd_ == kCmdReadDataReady) {
+        words[0] = produced > last_read_sample_ ? 0x0001 : 0x0000;
+        count = 1;
+    } else {
+        if (produced == 0) {
+            for (size_t i = 0; i < 4; ++i) words[i] = kUnknownUnsigned;
+            for (size_t i = 4; i < 8; ++i) words[i] = kUnknownSigned;
+        } else {
+            const auto index = static_cast<uint32_t>(produced - 1);
+            const auto values = cfg_.values ? cfg_.values(index) : DefaultValues(index);
+            std::copy(values.begin(), values.end(), words);
+        }
+        if (produced > last_read_sample_) {
+            ++stats_.samples_read;
+            stats_.samples_skipped += produced - last_read_sample_ - 1;
+        } else {
+            ++stats_.stale_reads;
+        }
+        last_read_sample_ = produced;
+        count = sen55_frame::kMeasuredWordCount;
+    }
+
+    // The master may read fewer words than the response holds, never more.
+    if (len > count * sen55_frame::kBytesPerWord || len % sen55_frame::kBytesPerWord != 0) {
+        return kNack;
+    }
+    sen55_frame::EncodeWords(words, len / sen55_frame::kBytesPerWord, data);
+
+    bool corrupt = false;
+    if (pending_crc_errors_ > 0) {
+        --pending_crc_errors_;
+        corrupt = true;
+    } else {
+        corrupt = Roll(cfg_.crc_error_rate);
+    }
+    if (corrupt) {
+        data[2] ^= 0x5A;
+        ++stats_.crc_errors_injected;
+    }
+
+    have_pending_cmd_ = false;
+    ++stats_.responses;
+    return ESP_OK;
+}
+
+Sen55Sim::Stats Sen55Sim::GetStats() const
+{
+    std::lock_guard lock(mutex_);
+    auto s = stats_;
+    if (measuring_) {
+        s.samples_produced = SamplesAt(esp_timer_get_time());
+    }
+    return s;
+}
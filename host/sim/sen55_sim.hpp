@@ -0,0 +1,90 @@
+#pragma once
+
+#include "sen55_frame.hpp"
+#include "sen55_transport.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <random>
+
+/**
+ * Software SEN55 behind the Sen55Transport interface.
+ *
+ * Answers Start (0x0021), Stop (0x0104), Read-Data-Ready (0x0202) and
+ * Read-Measured-Values (0x03C4) with CRC-correct frames. New samples appear
+ * on the sensor's own clock (esp_timer_get_time(), so they follow the host
+ * speed-up), reads issued before the command's execution time are NACKed
+ * like the real part, and CRC errors / NACKs can be injected at a rate or
+ * one-shot.
+ */
+class Sen55Sim final : public Sen55Transport {
+public:
+    /** Raw Read-Measured-Values words for sample number `index`. */
+    using Generator = std::function<sen55_frame::MeasuredWords(uint32_t index)>;
+
+    struct Config {
+        uint32_t first_sample_ms = 1'000;   // start → first data-ready
+        uint32_t sample_interval_ms = 1'000; // nominal 1 Hz update
+        int32_t clock_error_ppm = 0;         // sensor clock vs. host clock
+        uint32_t exec_time_ms = 20;          // command → response available
+        double nack_rate = 0.0;              // per transfer
+        double crc_error_rate = 0.0;         // per response
+        uint32_t seed = 1;
+        Generator values;                    // default: slow indoor waveform
+    };
+
+    struct Stats {
+        uint64_t commands;
+        uint64_t responses;
+        uint64_t nacks_injected;
+        uint64_t nacks_busy;          // read before exec_time elapsed
+        uint64_t crc_errors_injected;
+        uint64_t samples_produced;    // data-ready edges so far
+        uint64_t samples_read;        // fresh samples returned by 0x03C4
+        uint64_t samples_skipped;     // overwritten before they were read
+        uint64_t stale_reads;         // 0x03C4 with no new sample since last read
+    };
+
+    Sen55Sim();
+    explicit Sen55Sim(Config cfg);
+
+    esp_err_t Transmit(const uint8_t* data, size_t len) override;
+    esp_err_t Receive(uint8_t* data, size_t len) override;
+
+    /** NACK the next `n` transfers regardless of the configured rate. */
+    void InjectNacks(uint32_t n) { pending_nacks_ += n; }
+
+    /** Corrupt one CRC in each of the next `n` responses. */
+    void InjectCrcErrors(uint32_t n) { pending_crc_errors_ += n; }
+
+    Stats GetStats() const;
+
+    /** esp_timer time at which sample `index` became ready. */
+    int64_t SampleTimeUs(uint32_t index) const;
+
+    /** Default waveform: values drift slowly and cross severity bands. */
+    static sen55_frame::MeasuredWords DefaultValues(uint32_t index);
+
+private:
+    /** Number of samples the sensor has produced by `now_us`. */
+    uint64_t SamplesAt(int64_t now_us) const;
+
+    bool Roll(double rate);
+
+    const Config cfg_;
+    mutable std::mutex mutex_;
+    std::minstd_rand rng_;
+
+    bool measuring_{false};
+    int64_t start_us_{};
+    uint16_t pending_cmd_{};
+    bool have_pending_cmd_{false};
+    int64_t cmd_us_{};
+    uint64_t last_read_sample_{};  // samples produced at the previous 0x03C4
+    Stats stats_{};
+
+    std::atomic<uint32_t> pending_nacks_{0};
+    std::atomic<uint32_t> pending_crc_errors_{0};
+};
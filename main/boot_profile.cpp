@@ -0,0 +1,107 @@
+#include "boot_profile.hpp"
+#include "device_id.hpp"
+#include "mqtt.hpp"
+
+#include <atomic>
+#include <cstdio>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+namespace {
+
+const char *TAG = "boot";
+
+constexpr size_t kPhaseCount = static_cast<size_t>(BootPhase::kCount);
+
+constexpr const char *kNames[kPhaseCount] = {
+    "app_main", "wifi_started", "sensor_started", "history_restored",
+    "display_ready", "ui_ready", "wifi_ip", "mqtt_connected",
+    "first_reading", "first_publish",
+};
+
+// 0 until marked (esp_timer runs from early startup, so no mark is 0);
+// written once, by whichever task gets there first
+std::atomic<int64_t> s_mark_us[kPhaseCount]{};
+
+char s_topic[48]{};
+
+void log_timeline()
+{
+    // Completion order, with the gap since the previous milestone
+    bool done[kPhaseCount]{};
+    int64_t prev = 0;
+    for (size_t n = 0; n < kPhaseCount; ++n) {
+        size_t next = kPhaseCount;
+        for (size_t i = 0; i < kPhaseCount; ++i) {
+            const int64_t t = s_mark_us[i].load();
+            if (done[i] || t == 0) continue;
+            if (next == kPhaseCount || t < s_mark_us[next].load()) next = i;
+        }
+        if (next == kPhaseCount) break;
+        done[next] = true;
+        const int64_t t = s_mark_us[next].load();
+        ESP_LOGI(TAG, "%6lld ms  +%5lld ms  %s",
+                 static_cast<long long>(t / 1000),
+                 static_cast<long long>((t - prev) / 1000), kNames[next]);
+        prev = t;
+    }
+}
+
+} // namespace
+
+void boot_profile_mark(BootPhase phase)
+{
+    const auto i = static_cast<size_t>(phase);
+    if (i >= kPhaseCount) return;
+
+    int64_t unset = 0;
+    if (!s_mark_us[i].compare_exchange_strong(unset, esp_timer_get_time())) return;
+
+    if (phase == BootPhase::kFirstPublish) {
+        log_timeline();
+        char json[320];
+        boot_profile_json(json, sizeof(json));
+        mqtt_publish(boot_profile_topic(), json, 1, true);
+    }
+}
+
+int64_t boot_profile_us(BootPhase phase)
+{
+    const auto i = static_cast<size_t>(phase);
+    const int64_t t = i < kPhaseCount ? s_mark_us[i].load() : 0;
+    return t != 0 ? t : -1;
+}
+
+const char *boot_profile_name(BootPhase phase)
+{
+    const auto i = static_cast<size_t>(phase);
+    return i < kPhaseCount ? kNames[i] : "?";
+}
+
+size_t boot_profile_json(char *buf, size_t size)
+{
+    if (size == 0) return 0;
+    const int64_t total = boot_profile_us(BootPhase::kFirstPublish);
+    size_t len = std::snprintf(buf, size, "{\"total_ms\":%lld",
+                               static_cast<long long>(total < 0 ? -1 : total / 1000));
+    for (size_t i = 0; i < kPhaseCount && len < size; ++i) {
+        const int64_t t = boot_profile_us(static_cast<BootPhase>(i));
+        if (t < 0) continue;
+        len += std::snprintf(buf + len, size - len, ",\"%s\":%lld",
+                             kNames[i], static_cast<long long>(t / 1000));
+    }
+    if (len + 1 < size) {
+        buf[len++] = '}';
+        buf[len] = '\0';
+    }
+    return len < size ? len : size - 1;
+}
+
+const char *boot_profile_topic()
+{
+    if (s_topic[0] == '\0') {
+        std::snprintf(s_topic, sizeof(s_topic), "aqm/%s/boot", device_id_get());
+    }
+    return s_topic;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// Startup milestones, in the order they usually complete. Several of
+/// them run concurrently (see app_main), so the order is not fixed.
+enum class BootPhase : uint8_t {
+    kAppMain,          // app_main entered (ROM + bootloader + IDF startup before it)
+    kWifiStarted,      // STA started, association under way
+    kSensorStarted,    // SEN55 measuring
+    kHistoryRestored,  // history tiers refilled from flash
+    kDisplayReady,     // panel and LVGL up
+    kUiReady,          // first screen built
+    kWifiIp,           // got an IP
+    kMqttConnected,    // broker session up
+    kFirstReading,     // first SEN55 reading on the bus
+    kFirstPublish,     // first reading published: boot is over
+    kCount,
+};
+
+/// Records that `phase` has completed, now. Only the first call per phase
+/// counts; safe from any task. Marking kFirstPublish logs the timeline and
+/// publishes it to aqm/<device_id>/boot (retained).
+void boot_profile_mark(BootPhase phase);
+
+/// esp_timer time at which `phase` completed, -1 if it has not yet.
+int64_t boot_profile_us(BootPhase phase);
+
+/// Short snake_case name, as used in the published JSON.
+const char *boot_profile_name(BootPhase phase);
+
+/// Milliseconds since esp_timer start per completed phase, plus the total:
+///   {"total_ms":1834,"app_main":296,"wifi_started":341,...}
+/// Returns the length written (truncated to fit `size`).
+size_t boot_profile_json(char *buf, size_t size);
+
+/// aqm/<device_id>/boot
+const char *boot_profile_topic();
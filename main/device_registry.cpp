@@ -0,0 +1,330 @@
+#include "device_registry.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kMacLen = 6;
+constexpr uint16_t kNone = UINT16_MAX;
+
+// Wheel geometry: level n slots are 64^n ticks wide, so three levels
+// cover 262143 ticks (three days at one second)
+constexpr int kLevels = 3;
+constexpr int kSlotBits = 6;
+constexpr uint64_t kSlots = 1u << kSlotBits;
+constexpr uint64_t kSlotMask = kSlots - 1;
+constexpr uint64_t kMaxDelta = (1u << (kLevels * kSlotBits)) - 1;
+
+uint64_t MacKey(const uint8_t* mac)
+{
+    uint64_t key = 0;
+    std::memcpy(&key, mac, kMacLen);
+    return key;
+}
+
+// Fibonacci hashing: nodes from one vendor share the OUI half of the MAC,
+// the multiply spreads the rest over every bit
+uint32_t Hash(uint64_t key)
+{
+    return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+} // namespace
+
+/* ── Implementation ──────────────────────────────────────────────────── */
+
+struct DeviceRegistry::Impl {
+    struct Device {
+        uint64_t key{};
+        uint8_t mac[kMacLen]{};
+        std::atomic<bool> online{false};
+        std::atomic<int64_t> last_us{0};
+        bool pending{};        // a change the ChangeFn refused
+        uint16_t next{kNone};  // wheel slot list
+        uint64_t expires{};    // tick
+    };
+
+    Config cfg;
+    ChangeFn on_change;
+    void* ctx;
+    int64_t tick_us;
+    uint64_t timeout_ticks;
+
+    std::unique_ptr<uint16_t[]> slots;  // MAC hash → id, kNone if free
+    uint32_t slot_mask;
+    std::unique_ptr<Device[]> devices;
+    std::atomic<size_t> size{0};
+    std::atomic<size_t> online{0};
+    size_t pending{};
+
+    uint16_t wheel[kLevels][kSlots];
+    uint64_t occupied[kLevels]{};  // bit n: wheel[level][n] is not empty
+    uint64_t now_tick{};
+    bool started{};
+
+    Stats stats{};
+
+    Impl(const Config& c, ChangeFn fn, void* context)
+        : cfg(c), on_change(fn), ctx(context)
+    {
+        cfg.max_devices = std::clamp<size_t>(cfg.max_devices, 1, kNone - 1);
+        tick_us = std::max<int64_t>(cfg.tick_ms, 1) * 1000;
+        timeout_ticks = std::max<uint64_t>(
+            (static_cast<uint64_t>(cfg.timeout_s) * 1'000'000 + tick_us - 1) / tick_us, 1);
+
+        // At most half full: a miss ends at a free slot within a probe or two
+        const size_t capacity = std::bit_ceil(cfg.max_devices * 2);
+        slot_mask = static_cast<uint32_t>(capacity - 1);
+        slots = std::make_unique<uint16_t[]>(capacity);
+        std::fill_n(slots.get(), capacity, kNone);
+        devices = std::make_unique<Device[]>(cfg.max_devices);
+        for (auto& level : wheel) std::fill(std::begin(level), std::end(level), kNone);
+    }
+
+    uint64_t TickOf(int64_t us) const { return static_cast<uint64_t>(us / tick_us); }
+
+    /** First tick at least timeout_s after `us`. */
+    uint64_t DeadlineOf(int64_t us) const
+    {
+        return static_cast<uint64_t>((us + tick_us - 1) / tick_us) + timeout_ticks;
+    }
+
+    /** Slot holding `key`, or the free slot where it would go. */
+    uint32_t Probe(uint64_t key, uint32_t* probes) const
+    {
+        uint32_t i = Hash(key) & slot_mask;
+        uint32_t n = 1;
+        while (slots[i] != kNone && devices[slots[i]].key != key) {
+            i = (i + 1) & slot_mask;
+            ++n;
+        }
+        *probes = n;
+        return i;
+    }
+
+    /* ── Wheel ───────────────────────────────────────────────────────── */
+
+    void Link(uint16_t id, int level, uint64_t slot)
+    {
+        devices[id].next = wheel[level][slot];
+        wheel[level][slot] = id;
+        occupied[level] |= 1ull << slot;
+    }
+
+    /** Detaches the whole list of one slot; returns its head. */
+    uint16_t Take(int level, uint64_t slot)
+    {
+        const uint16_t head = wheel[level][slot];
+        wheel[level][slot] = kNone;
+        occupied[level] &= ~(1ull << slot);
+        return head;
+    }
+
+    /** Files `id` under tick `expires`, on the level its distance needs. */
+    void Arm(uint16_t id, uint64_t expires)
+    {
+        const uint64_t delta = std::min(expires > now_tick ? expires - now_tick : 0, kMaxDelta);
+        expires = now_tick + delta;
+        devices[id].expires = expires;
+        int level = 0;
+        while (delta >> ((level + 1) * kSlotBits) != 0) ++level;
+        Link(id, level, (expires >> (level * kSlotBits)) & kSlotMask);
+    }
+
+    /** Re-files a coarse slot's entries now that they are closer. */
+    void Cascade(int level, uint64_t slot)
+    {
+        for (uint16_t id = Take(level, slot); id != kNone;) {
+            const uint16_t next = devices[id].next;
+            ++stats.cascades;
+            Arm(id, devices[id].expires);
+            id = next;
+        }
+    }
+
+    /** The current tick's entries: re-armed if heard since, else offline. */
+    void Expire(uint64_t slot)
+    {
+        for (uint16_t id = Take(0, slot); id != kNone;) {
+            Device& d = devices[id];
+            const uint16_t next = d.next;
+            const uint64_t deadline = DeadlineOf(d.last_us.load(std::memory_order_relaxed));
+            if (deadline > now_tick) {
+                ++stats.rearms;
+                Arm(id, deadline);
+            } else {
+                ++stats.expirations;
+                SetOnline(id, false);
+            }
+            id = next;
+        }
+    }
+
+    void Step()
+    {
+        ++now_tick;
+        const uint64_t slot = now_tick & kSlotMask;
+        if (slot == 0) {
+            const uint64_t slot1 = (now_tick >> kSlotBits) & kSlotMask;
+            if (slot1 == 0) Cascade(2, (now_tick >> (2 * kSlotBits)) & kSlotMask);
+            Cascade(1, slot1);
+        }
+        if (occupied[0] & (1ull << slot)) Expire(slot);
+    }
+
+    /* ── Availability ────────────────────────────────────────────────── */
+
+    void SetOnline(uint16_t id, bool on)
+    {
+        Device& d = devices[id];
+        d.online.store(on, std::memory_order_relaxed);
+        if (on) {
+            online.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            online.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        if (d.pending) {
+            // The change before this one never went out, so the receiver
+            // still holds this state
+            d.pending = false;
+            --pending;
+        } else if (!on_change(ctx, id, d.mac, on)) {
+            d.pending = true;
+            ++pending;
+        }
+    }
+};
+
+/* ── DeviceRegistry ──────────────────────────────────────────────────── */
+
+DeviceRegistry::DeviceRegistry(const Config& cfg, ChangeFn on_change, void* ctx)
+    : impl_(std::make_unique<Impl>(cfg, on_change, ctx))
+{
+}
+
+DeviceRegistry::~DeviceRegistry() = default;
+
+int DeviceRegistry::Find(const uint8_t* mac) const
+{
+    uint32_t probes;
+    const uint32_t slot = impl_->Probe(MacKey(mac), &probes);
+    return impl_->slots[slot] == kNone ? -1 : impl_->slots[slot];
+}
+
+int DeviceRegistry::Touch(const uint8_t* mac, int64_t now_us)
+{
+    auto& d = *impl_;
+    if (!d.started) {
+        d.now_tick = d.TickOf(now_us);
+        d.started = true;
+    }
+
+    const uint64_t key = MacKey(mac);
+    uint32_t probes;
+    const uint32_t slot = d.Probe(key, &probes);
+    ++d.stats.lookups;
+    d.stats.probes += probes;
+    d.stats.max_probes = std::max(d.stats.max_probes, probes);
+
+    uint16_t id = d.slots[slot];
+    if (id == kNone) {
+        const size_t n = d.size.load(std::memory_order_relaxed);
+        if (n == d.cfg.max_devices) return -1;
+        id = static_cast<uint16_t>(n);
+        d.devices[id].key = key;
+        std::memcpy(d.devices[id].mac, mac, kMacLen);
+        d.slots[slot] = id;
+        d.size.store(n + 1, std::memory_order_release);
+    }
+
+    Impl::Device& dev = d.devices[id];
+    dev.last_us.store(now_us, std::memory_order_relaxed);
+    if (!dev.online.load(std::memory_order_relaxed)) {
+        d.Arm(id, d.DeadlineOf(now_us));
+        d.SetOnline(id, true);
+    }
+    return id;
+}
+
+void DeviceRegistry::Advance(int64_t now_us)
+{
+    auto& d = *impl_;
+    const uint64_t target = d.TickOf(now_us);
+    if (!d.started) {
+        d.now_tick = target;
+        d.started = true;
+    }
+    while (d.now_tick < target) {
+        if ((d.occupied[0] | d.occupied[1] | d.occupied[2]) == 0) {
+            d.now_tick = target;
+            break;
+        }
+        d.Step();
+    }
+}
+
+int64_t DeviceRegistry::NextDeadline() const
+{
+    const auto& d = *impl_;
+    const uint64_t slot = d.now_tick & kSlotMask;
+    uint64_t ticks = UINT64_MAX;
+    if (d.occupied[0]) {
+        // Nearest occupied slot after the current one, wrapping round
+        const uint64_t ahead = std::rotr(d.occupied[0], static_cast<int>((slot + 1) & kSlotMask));
+        ticks = std::countr_zero(ahead) + 1;
+    }
+    if (d.occupied[1] | d.occupied[2]) {
+        ticks = std::min(ticks, kSlots - slot);
+    }
+    if (ticks == UINT64_MAX) return INT64_MAX;
+    return static_cast<int64_t>(d.now_tick + ticks) * d.tick_us;
+}
+
+void DeviceRegistry::Retry()
+{
+    auto& d = *impl_;
+    const size_t n = d.size.load(std::memory_order_relaxed);
+    for (size_t id = 0; id < n && d.pending > 0; ++id) {
+        Impl::Device& dev = d.devices[id];
+        if (dev.pending &&
+            d.on_change(d.ctx, static_cast<int>(id), dev.mac, dev.online.load())) {
+            dev.pending = false;
+            --d.pending;
+        }
+    }
+}
+
+size_t DeviceRegistry::Size() const
+{
+    return impl_->size.load(std::memory_order_acquire);
+}
+
+size_t DeviceRegistry::Online() const
+{
+    return impl_->online.load(std::memory_order_relaxed);
+}
+
+const uint8_t* DeviceRegistry::Mac(int id) const
+{
+    return impl_->devices[id].mac;
+}
+
+bool DeviceRegistry::IsOnline(int id) const
+{
+    return impl_->devices[id].online.load(std::memory_order_relaxed);
+}
+
+int64_t DeviceRegistry::LastSeen(int id) const
+{
+    return impl_->devices[id].last_us.load(std::memory_order_relaxed);
+}
+
+DeviceRegistry::Stats DeviceRegistry::GetStats() const
+{
+    return impl_->stats;
+}
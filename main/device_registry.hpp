@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Remote nodes by MAC, with a heartbeat watchdog.
+ *
+ * Each node gets a dense id (0, 1, … in the order first heard) that
+ * callers use to index their own per-node state. The MAC → id lookup is
+ * an open-addressing table at most half full, so a packet costs one or
+ * two probes whatever the fleet size.
+ *
+ * A node is online from its first packet until it has been silent for
+ * timeout_s. Deadlines live on a three-level hierarchical timer wheel
+ * (64 slots per level, tick_ms per slot): Touch() only stamps the time,
+ * and a node's one wheel entry is moved forward when it comes due,
+ * so per-packet cost does not depend on the number of nodes or timers.
+ *
+ * Availability changes go to the ChangeFn on transitions only. One it
+ * could not deliver (MQTT down) is retried by Retry(), unless the node
+ * has changed back in the meantime.
+ *
+ * Not thread-safe: Touch(), Advance() and Retry() belong to one task.
+ * Size(), Online(), Mac(), IsOnline() and LastSeen() may be read from
+ * any task.
+ */
+class DeviceRegistry {
+public:
+    struct Config {
+        size_t max_devices;   // further nodes are refused
+        uint32_t timeout_s;   // silence before a node is offline
+        uint32_t tick_ms;     // wheel resolution
+    };
+
+    /** Availability of node `id` changed. Returns false to be retried. */
+    using ChangeFn = bool (*)(void* ctx, int id, const uint8_t* mac, bool online);
+
+    /** Lookup and wheel work since construction. */
+    struct Stats {
+        uint64_t lookups;
+        uint64_t probes;       // slots compared; probes / lookups ≈ 1 when healthy
+        uint32_t max_probes;   // longest single lookup
+        uint32_t rearms;       // wheel entries moved on: the node had been heard
+        uint32_t cascades;     // entries moved down a level
+        uint32_t expirations;  // online → offline
+    };
+
+    DeviceRegistry(const Config& cfg, ChangeFn on_change, void* ctx);
+    ~DeviceRegistry();
+
+    /** The node's id, or -1 if never heard. */
+    int Find(const uint8_t* mac) const;
+
+    /**
+     * A packet from `mac` at `now_us` (esp_timer time, non-decreasing):
+     * adds the node if new and brings it online if it was not. Returns its
+     * id, or -1 if the registry is full.
+     */
+    int Touch(const uint8_t* mac, int64_t now_us);
+
+    /** Runs the wheel up to `now_us`, taking silent nodes offline. */
+    void Advance(int64_t now_us);
+
+    /**
+     * When Advance() next has work: the earliest wheel slot holding a
+     * deadline or a cascade. INT64_MAX if no node is online.
+     */
+    int64_t NextDeadline() const;
+
+    /** Delivers changes the ChangeFn refused earlier. */
+    void Retry();
+
+    size_t Size() const;
+    size_t Online() const;
+
+    /** For 0 <= id < Size(). */
+    const uint8_t* Mac(int id) const;
+    bool IsOnline(int id) const;
+    int64_t LastSeen(int id) const;
+
+    /** From the task that owns the registry. */
+    Stats GetStats() const;
+
+    DeviceRegistry(const DeviceRegistry&) = delete;
+    DeviceRegistry& operator=(const DeviceRegistry&) = delete;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
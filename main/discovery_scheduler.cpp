@@ -0,0 +1,440 @@
+#include "discovery_scheduler.hpp"
+#include "mqtt.hpp"
+
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+static const char* TAG = "discovery";
+
+namespace {
+
+constexpr uint16_t kNone = UINT16_MAX;
+constexpr size_t kTopicSize = 96;
+
+// While the outbox is over its limit, look again this often
+constexpr int64_t kOutboxPollUs = 100'000;
+
+// Token bucket credit is kept in millionths, so refills need no division
+constexpr int64_t kMicro = 1'000'000;
+
+// New devices rank before everything queued by a reconnect; within a
+// class, first queued goes first
+constexpr uint64_t kBacklog = 1ull << 63;
+
+constexpr uint32_t kFnvBasis = 2166136261u;
+
+uint32_t Fnv1a(uint32_t h, const char* data, size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        h = (h ^ static_cast<uint8_t>(data[i])) * 16777619u;
+    }
+    return h;
+}
+
+} // namespace
+
+/* ── Implementation ──────────────────────────────────────────────────── */
+
+struct DiscoveryScheduler::Impl {
+    struct Device {
+        uint64_t key{};
+        uint32_t hash{};      // of the current config
+        uint32_t retained{};  // of the broker's copy, if `known`
+        bool has_config{};
+        bool known{};
+        uint16_t pos{kNone};  // in the queue
+        uint64_t rank{};
+    };
+
+    /** A retained copy for a device not Update()d yet. */
+    struct Orphan {
+        uint64_t key;
+        uint32_t hash;
+    };
+
+    Config cfg;
+    WriteFn write;
+    ResolveFn resolve;
+    void* ctx;
+    char filter[kTopicSize]{};
+
+    SemaphoreHandle_t lock{};
+    StaticSemaphore_t lock_buf{};
+
+    std::unique_ptr<Device[]> devices;
+    std::unique_ptr<uint16_t[]> heap;
+    size_t queued{};
+    uint64_t next_rank{};
+    std::unique_ptr<Orphan[]> orphans;
+    size_t orphan_count{};
+
+    // Written by Update() and Pump() only, so used unlocked
+    std::unique_ptr<char[]> scratch;
+    char topic[kTopicSize]{};
+
+    // Retained check
+    bool checking{};
+    bool subscribed{};
+    int64_t check_end{};
+
+    // The retained message being received (it may come in pieces)
+    bool rx_ours{};
+    int rx_id{-1};
+    uint64_t rx_key{};
+    uint32_t rx_hash{};
+
+    // Token bucket, in millionths of a message / byte
+    int64_t msg_credit{};
+    int64_t byte_credit{};
+    int64_t byte_burst{};
+    int64_t refilled_us{-1};
+
+    Stats stats{};
+
+    bool Matches(const Device& d) const { return d.known && d.retained == d.hash; }
+
+    /* ── Queue: a binary min-heap on rank ────────────────────────────── */
+
+    void Place(size_t i, uint16_t id)
+    {
+        heap[i] = id;
+        devices[id].pos = static_cast<uint16_t>(i);
+    }
+
+    void SiftUp(size_t i)
+    {
+        const uint16_t id = heap[i];
+        while (i > 0) {
+            const size_t parent = (i - 1) / 2;
+            if (devices[heap[parent]].rank <= devices[id].rank) break;
+            Place(i, heap[parent]);
+            i = parent;
+        }
+        Place(i, id);
+    }
+
+    void SiftDown(size_t i)
+    {
+        const uint16_t id = heap[i];
+        for (;;) {
+            size_t child = 2 * i + 1;
+            if (child >= queued) break;
+            if (child + 1 < queued && devices[heap[child + 1]].rank < devices[heap[child]].rank) {
+                ++child;
+            }
+            if (devices[id].rank <= devices[heap[child]].rank) break;
+            Place(i, heap[child]);
+            i = child;
+        }
+        Place(i, id);
+    }
+
+    /** Queues `id`, or moves it up if it is already queued lower. */
+    void Push(uint16_t id, bool urgent)
+    {
+        Device& d = devices[id];
+        const uint64_t rank = (urgent ? 0 : kBacklog) | next_rank++;
+        if (d.pos != kNone) {
+            if (rank < d.rank) {
+                d.rank = rank;
+                SiftUp(d.pos);
+            }
+            return;
+        }
+        d.rank = rank;
+        heap[queued] = id;
+        SiftUp(queued++);
+    }
+
+    void Pop()
+    {
+        devices[heap[0]].pos = kNone;
+        if (--queued > 0) {
+            Place(0, heap[queued]);
+            SiftDown(0);
+        }
+    }
+
+    /* ── Budget ──────────────────────────────────────────────────────── */
+
+    void Refill(int64_t now_us)
+    {
+        if (refilled_us < 0) refilled_us = now_us;
+        const int64_t dt = now_us - refilled_us;
+        refilled_us = now_us;
+        msg_credit = std::min(msg_credit + dt * cfg.messages_per_s,
+                              int64_t{cfg.burst_messages} * kMicro);
+        byte_credit = std::min(byte_credit + dt * cfg.bytes_per_s, byte_burst);
+    }
+
+    /** Microseconds until `len` bytes fit the budget, 0 if they do now. */
+    int64_t Wait(size_t len) const
+    {
+        int64_t wait = 0;
+        if (cfg.messages_per_s > 0 && msg_credit < kMicro) {
+            wait = (kMicro - msg_credit + cfg.messages_per_s - 1) / cfg.messages_per_s;
+        }
+        const int64_t need = static_cast<int64_t>(len) * kMicro;
+        if (cfg.bytes_per_s > 0 && byte_credit < need) {
+            wait = std::max<int64_t>(wait, (need - byte_credit + cfg.bytes_per_s - 1) /
+                                               cfg.bytes_per_s);
+        }
+        return wait;
+    }
+
+    void Spend(size_t len)
+    {
+        if (cfg.messages_per_s > 0) msg_credit -= kMicro;
+        if (cfg.bytes_per_s > 0) byte_credit -= static_cast<int64_t>(len) * kMicro;
+    }
+
+    /* ── Retained check ──────────────────────────────────────────────── */
+
+    /** Ends the check: everything the broker does not hold as-is queues up. */
+    void FinishCheck()
+    {
+        checking = false;
+        size_t held = 0;
+        for (size_t id = 0; id < cfg.max_devices; ++id) {
+            Device& d = devices[id];
+            if (!d.has_config) continue;
+            if (Matches(d)) {
+                ++held;
+            } else {
+                Push(static_cast<uint16_t>(id), false);
+            }
+        }
+        stats.retained += held;
+        ESP_LOGI(TAG, "%u configs retained, %u to publish, %u for devices not heard yet",
+                 static_cast<unsigned>(held), static_cast<unsigned>(queued),
+                 static_cast<unsigned>(orphan_count));
+    }
+
+    void Remember(uint64_t key, uint32_t hash)
+    {
+        for (size_t i = 0; i < orphan_count; ++i) {
+            if (orphans[i].key == key) {
+                orphans[i].hash = hash;
+                return;
+            }
+        }
+        // Full: the device's config is republished once it is heard
+        if (orphan_count < cfg.max_devices) orphans[orphan_count++] = {key, hash};
+    }
+
+    /** Takes over a remembered retained copy for `key`. */
+    bool Adopt(uint64_t key, uint32_t* hash)
+    {
+        for (size_t i = 0; i < orphan_count; ++i) {
+            if (orphans[i].key == key) {
+                *hash = orphans[i].hash;
+                orphans[i] = orphans[--orphan_count];
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+/* ── DiscoveryScheduler ──────────────────────────────────────────────── */
+
+DiscoveryScheduler::Config DiscoveryScheduler::Config::Default()
+{
+    return {
+        .max_devices = CONFIG_AQM_ESPNOW_MAX_PEERS,
+        .max_config = 3072,
+        .messages_per_s = CONFIG_AQM_ESPNOW_DISCOVERY_MSGS_S,
+        .bytes_per_s = CONFIG_AQM_ESPNOW_DISCOVERY_BYTES_S,
+        .burst_messages = CONFIG_AQM_ESPNOW_DISCOVERY_BURST,
+        .outbox_bytes = CONFIG_AQM_ESPNOW_DISCOVERY_OUTBOX,
+        .check_ms = CONFIG_AQM_HA_DISCOVERY_CHECK_MS,
+    };
+}
+
+DiscoveryScheduler::DiscoveryScheduler(const Config& cfg, const char* filter, WriteFn write,
+                                       ResolveFn resolve, void* ctx)
+    : impl_(std::make_unique<Impl>())
+{
+    auto& d = *impl_;
+    d.cfg = cfg;
+    d.cfg.max_devices = std::clamp<size_t>(cfg.max_devices, 1, kNone - 1);
+    d.cfg.burst_messages = std::max<uint32_t>(cfg.burst_messages, 1);
+    d.write = write;
+    d.resolve = resolve;
+    d.ctx = ctx;
+    std::snprintf(d.filter, sizeof(d.filter), "%s", filter);
+    d.lock = xSemaphoreCreateMutexStatic(&d.lock_buf);
+
+    d.devices = std::make_unique<Impl::Device[]>(d.cfg.max_devices);
+    d.heap = std::make_unique<uint16_t[]>(d.cfg.max_devices);
+    d.orphans = std::make_unique<Impl::Orphan[]>(d.cfg.max_devices);
+    d.scratch = std::make_unique<char[]>(d.cfg.max_config);
+
+    // A second's bytes, and never less than the largest config
+    d.byte_burst = static_cast<int64_t>(std::max<size_t>(d.cfg.bytes_per_s, d.cfg.max_config)) *
+                   kMicro;
+    d.msg_credit = int64_t{d.cfg.burst_messages} * kMicro;
+    d.byte_credit = d.byte_burst;
+}
+
+DiscoveryScheduler::~DiscoveryScheduler()
+{
+    vSemaphoreDelete(impl_->lock);
+}
+
+void DiscoveryScheduler::Update(int id, uint64_t key)
+{
+    auto& d = *impl_;
+    if (id < 0 || static_cast<size_t>(id) >= d.cfg.max_devices) return;
+    const size_t len = d.write(d.ctx, id, d.topic, sizeof(d.topic), d.scratch.get(),
+                               d.cfg.max_config);
+
+    xSemaphoreTake(d.lock, portMAX_DELAY);
+    Impl::Device& dev = d.devices[id];
+    dev.key = key;
+    dev.has_config = len > 0;
+    dev.hash = Fnv1a(kFnvBasis, d.scratch.get(), len);
+    uint32_t hash;
+    if (!dev.known && d.Adopt(key, &hash)) {
+        dev.known = true;
+        dev.retained = hash;
+        // Counted by FinishCheck() if the check is still on
+        if (d.Matches(dev) && dev.has_config && !d.checking) ++d.stats.retained;
+    }
+    if (dev.has_config && !d.Matches(dev)) d.Push(static_cast<uint16_t>(id), true);
+    xSemaphoreGive(d.lock);
+}
+
+void DiscoveryScheduler::OnConnect(int64_t now_us)
+{
+    auto& d = *impl_;
+    xSemaphoreTake(d.lock, portMAX_DELAY);
+    for (size_t id = 0; id < d.cfg.max_devices; ++id) d.devices[id].known = false;
+    d.orphan_count = 0;
+    d.rx_ours = false;
+    d.checking = true;
+    d.subscribed = d.cfg.check_ms > 0;
+    d.check_end = now_us + int64_t{d.cfg.check_ms} * 1000;
+    xSemaphoreGive(d.lock);
+
+    // Outside the lock: the retained copies may be delivered right away
+    if (d.subscribed) mqtt_subscribe(d.filter, 0);
+}
+
+bool DiscoveryScheduler::OnData(const char* topic, int topic_len, const char* data, int data_len,
+                                int offset, int total_len)
+{
+    auto& d = *impl_;
+    xSemaphoreTake(d.lock, portMAX_DELAY);
+    if (!d.checking) {
+        xSemaphoreGive(d.lock);
+        return false;
+    }
+    if (offset == 0) {
+        d.rx_ours = d.resolve(d.ctx, topic, topic_len, &d.rx_id, &d.rx_key);
+        d.rx_hash = kFnvBasis;
+    }
+    const bool ours = d.rx_ours;
+    if (ours) {
+        d.rx_hash = Fnv1a(d.rx_hash, data, data_len);
+        if (offset + data_len >= total_len) {
+            if (d.rx_id >= 0 && static_cast<size_t>(d.rx_id) < d.cfg.max_devices) {
+                Impl::Device& dev = d.devices[d.rx_id];
+                dev.known = true;
+                dev.retained = d.rx_hash;
+            } else {
+                d.Remember(d.rx_key, d.rx_hash);
+            }
+            d.rx_ours = false;
+        }
+    }
+    xSemaphoreGive(d.lock);
+    return ours;
+}
+
+int64_t DiscoveryScheduler::Pump(int64_t now_us)
+{
+    auto& d = *impl_;
+    xSemaphoreTake(d.lock, portMAX_DELAY);
+    d.Refill(now_us);
+
+    if (d.checking) {
+        if (now_us < d.check_end) {
+            xSemaphoreGive(d.lock);
+            return d.check_end;
+        }
+        d.FinishCheck();
+        if (d.subscribed) {
+            d.subscribed = false;
+            xSemaphoreGive(d.lock);
+            mqtt_unsubscribe(d.filter);
+            xSemaphoreTake(d.lock, portMAX_DELAY);
+        }
+    }
+
+    int64_t next = INT64_MAX;
+    while (d.queued > 0 && !d.checking && mqtt_is_connected()) {
+        const uint16_t id = d.heap[0];
+        Impl::Device& dev = d.devices[id];
+        if (!dev.has_config || d.Matches(dev)) {
+            d.Pop();
+            continue;
+        }
+        if (d.cfg.outbox_bytes > 0 &&
+            static_cast<size_t>(mqtt_outbox_bytes()) > d.cfg.outbox_bytes) {
+            ++d.stats.outbox_waits;
+            next = now_us + kOutboxPollUs;
+            break;
+        }
+
+        const size_t len = d.write(d.ctx, id, d.topic, sizeof(d.topic), d.scratch.get(),
+                                   d.cfg.max_config);
+        if (len == 0) {
+            d.Pop();
+            continue;
+        }
+        const int64_t wait = d.Wait(len);
+        if (wait > 0) {
+            ++d.stats.throttled;
+            next = now_us + wait;
+            break;
+        }
+
+        d.Pop();
+        d.Spend(len);
+        const uint32_t hash = Fnv1a(kFnvBasis, d.scratch.get(), len);
+        xSemaphoreGive(d.lock);
+        const bool ok = mqtt_publish(d.topic, d.scratch.get(), 1, true) >= 0;
+        xSemaphoreTake(d.lock, portMAX_DELAY);
+        if (!ok) {
+            d.Push(id, true);
+            next = now_us + kOutboxPollUs;
+            break;
+        }
+        ++d.stats.published;
+        d.stats.bytes += len;
+        // Assumed held from here on; the next connect checks
+        dev.known = true;
+        dev.retained = hash;
+    }
+    if (d.checking) next = d.check_end;  // reconnected meanwhile
+    xSemaphoreGive(d.lock);
+    return next;
+}
+
+DiscoveryScheduler::Stats DiscoveryScheduler::GetStats() const
+{
+    auto& d = *impl_;
+    xSemaphoreTake(d.lock, portMAX_DELAY);
+    Stats s = d.stats;
+    s.queued = static_cast<uint32_t>(d.queued);
+    xSemaphoreGive(d.lock);
+    return s;
+}
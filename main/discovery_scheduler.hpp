@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Paces retained Home Assistant discovery for a fleet of devices.
+ *
+ * Every device (a dense id, e.g. from a DeviceRegistry) has one config,
+ * written on demand by a WriteFn. The scheduler keeps only that config's
+ * hash and the hash of the copy the broker retains, and publishes when the
+ * two differ:
+ *
+ *  - Update(): the device is new or its config changed. It goes to the
+ *    front of the queue.
+ *  - OnConnect(): subscribes to `filter` for check_ms and records the
+ *    retained copies as they arrive. Devices whose copy matches are not
+ *    republished; the rest queue up behind any new devices.
+ *
+ * Pump() publishes from the queue (QoS 1, retained) as a token bucket
+ * allows: messages_per_s and bytes_per_s sustained, bursts of up to
+ * burst_messages and one second's bytes. It never publishes while
+ * esp-mqtt's outbox holds more than outbox_bytes, so a connect with a
+ * whole fleet to announce cannot overrun it.
+ *
+ * Retained copies for devices not yet Update()d (after a reboot, before
+ * the node is heard again) are remembered by key until they are.
+ *
+ * Update() and Pump() belong to one task; OnConnect() and OnData() may
+ * be called from the MQTT task.
+ */
+class DiscoveryScheduler {
+public:
+    struct Config {
+        size_t max_devices;
+        size_t max_config;        // longest config, bytes
+        uint32_t messages_per_s;  // 0: no message budget
+        uint32_t bytes_per_s;     // 0: no byte budget
+        uint32_t burst_messages;
+        size_t outbox_bytes;      // hold off above this, 0 = ignore the outbox
+        uint32_t check_ms;        // wait for retained copies after connecting
+
+        /** The Kconfig values (AQM_ESPNOW_DISCOVERY_*, AQM_HA_DISCOVERY_CHECK_MS). */
+        static Config Default();
+    };
+
+    struct Stats {
+        uint32_t published;
+        uint32_t bytes;
+        uint32_t retained;      // found on the broker unchanged, not republished
+        uint32_t throttled;     // Pump() stopped by the budget
+        uint32_t outbox_waits;  // Pump() stopped by the outbox
+        uint32_t queued;        // waiting now
+    };
+
+    /**
+     * Writes device `id`'s discovery topic and config, both NUL-terminated.
+     * Returns the config's length, 0 if the device has none (yet) or it
+     * does not fit.
+     */
+    using WriteFn = size_t (*)(void* ctx, int id, char* topic, size_t topic_size, char* config,
+                               size_t size);
+
+    /**
+     * Which device a retained config's topic is for: false if the topic is
+     * not a discovery topic of ours, else `*key` and `*id` (-1 if the device
+     * is not known yet).
+     */
+    using ResolveFn = bool (*)(void* ctx, const char* topic, int topic_len, int* id,
+                               uint64_t* key);
+
+    DiscoveryScheduler(const Config& cfg, const char* filter, WriteFn write, ResolveFn resolve,
+                       void* ctx);
+    ~DiscoveryScheduler();
+
+    /** Device `id` (with `key`, e.g. its MAC) is new, or its config changed. */
+    void Update(int id, uint64_t key);
+
+    /** Starts the retained check; call on every MQTT connect. */
+    void OnConnect(int64_t now_us);
+
+    /** Feed every incoming MQTT message. Returns true if it was a retained config of ours. */
+    bool OnData(const char* topic, int topic_len, const char* data, int data_len, int offset,
+                int total_len);
+
+    /**
+     * Publishes what the budget allows. Returns when it next has work,
+     * INT64_MAX if none (Update() and OnConnect() add work).
+     */
+    int64_t Pump(int64_t now_us);
+
+    Stats GetStats() const;
+
+    DiscoveryScheduler(const DiscoveryScheduler&) = delete;
+    DiscoveryScheduler& operator=(const DiscoveryScheduler&) = delete;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
@@ -1,12 +1,16 @@
 #include "esp32_8048s043.hpp"
+#include "task_plan.hpp"
 
 #include "esp_check.h"
 #include "esp_log.h"
 #include "esp_lcd_panel_ops.h"
 #include "esp_lcd_panel_rgb.h"
 #include "esp_lvgl_port.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
+#include "sdkconfig.h"
 
+#include <algorithm>
 #include <cstdint>
 
 // ESP-IDF config structs have many fields we intentionally leave defaulted.
@@ -48,6 +52,133 @@ constexpr gpio_num_t kDataPins[] = {
 };
 
 constexpr uint32_t kPixelClkHz = 18'000'000;
+constexpr uint32_t kHsyncPulse = 4, kHsyncBack = 8, kHsyncFront = 8;
+constexpr uint32_t kVsyncPulse = 4, kVsyncBack = 8, kVsyncFront = 8;
+constexpr uint32_t kBytesPerPx = 2;  // RGB565
+
+// The panel DMA reads the whole frame buffer from PSRAM every frame,
+// whatever LVGL draws: ~43 Hz, ~33 MB/s.
+constexpr uint32_t kPanelHz = kPixelClkHz /
+    ((kHRes + kHsyncPulse + kHsyncBack + kHsyncFront) *
+     (kVRes + kVsyncPulse + kVsyncBack + kVsyncFront));
+constexpr uint32_t kScanoutBytesPerS = kPanelHz * kHRes * kVRes * kBytesPerPx;
+
+/* ── Pipeline (Kconfig) ──────────────────────────────────────────────── */
+
+enum class Pipeline { kPartial, kBounce, kDirect, kTearFree };
+
+#if CONFIG_AQM_DISPLAY_DIRECT
+constexpr auto kPipeline = Pipeline::kDirect;
+#elif CONFIG_AQM_DISPLAY_TEAR_FREE
+constexpr auto kPipeline = Pipeline::kTearFree;
+#elif CONFIG_AQM_DISPLAY_BOUNCE
+constexpr auto kPipeline = Pipeline::kBounce;
+#else
+constexpr auto kPipeline = Pipeline::kPartial;
+#endif
+
+// Frame buffers in PSRAM. With more than one, LVGL draws into a buffer the
+// panel is not scanning out and the port swaps them at vsync.
+constexpr size_t kFrameBuffers =
+    kPipeline == Pipeline::kDirect ? 2 : kPipeline == Pipeline::kTearFree ? 3 : 1;
+constexpr bool kAvoidTearing = kFrameBuffers > 1;
+
+#ifdef CONFIG_AQM_DISPLAY_BOUNCE_LINES
+constexpr uint32_t kBounceLines = CONFIG_AQM_DISPLAY_BOUNCE_LINES;
+#else
+constexpr uint32_t kBounceLines = 0;
+#endif
+static_assert(kBounceLines == 0 || kVRes % kBounceLines == 0,
+              "bounce buffer lines must divide the panel height");
+
+#ifdef CONFIG_AQM_DISPLAY_DRAW_BUF_LINES
+constexpr uint32_t kDrawBufLines = CONFIG_AQM_DISPLAY_DRAW_BUF_LINES;
+#else
+constexpr uint32_t kDrawBufLines = 10;  // unused: LVGL draws into the frame buffers
+#endif
+#if CONFIG_AQM_DISPLAY_DRAW_BUF_PSRAM
+constexpr bool kDrawBufPsram = true;
+#else
+constexpr bool kDrawBufPsram = false;
+#endif
+#if CONFIG_AQM_DISPLAY_DRAW_BUF_DOUBLE
+constexpr bool kDrawBufDouble = true;
+#else
+constexpr bool kDrawBufDouble = false;
+#endif
+
+/**
+ * PSRAM bytes moved per flushed pixel, LVGL side (scanout excluded):
+ * partial modes copy the draw buffer into the frame buffer, rendering into
+ * PSRAM too if the draw buffer lives there; direct mode renders into the
+ * frame buffer and then copies the dirty areas to the other one; tear-free
+ * renders the full frame straight into a frame buffer.
+ */
+constexpr uint32_t kPsramBytesPerPx =
+    kPipeline == Pipeline::kDirect   ? 3 * kBytesPerPx :
+    kPipeline == Pipeline::kTearFree ? kBytesPerPx :
+    kDrawBufPsram                    ? 3 * kBytesPerPx : kBytesPerPx;
+
+/* ── Metrics ─────────────────────────────────────────────────────────── */
+
+struct Meter {
+    Stats stats{};
+    int64_t refr_start_us{};
+    int64_t flush_start_us{};
+    int64_t wait_start_us{};
+    uint32_t frame_flushes{};
+
+    // Snapshot at the previous LogStats()
+    Stats logged{};
+    int64_t logged_us{};
+};
+
+Meter s_meter;
+
+void OnDisplayEvent(lv_event_t* e)
+{
+    auto& m = s_meter;
+    auto& st = m.stats;
+    const int64_t now = esp_timer_get_time();
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_REFR_START:
+        m.refr_start_us = now;
+        m.frame_flushes = 0;
+        break;
+    case LV_EVENT_REFR_READY:
+        if (m.frame_flushes != 0) {
+            const int64_t us = now - m.refr_start_us;
+            ++st.frames;
+            st.render_us += us;
+            if (us > st.max_render_us) st.max_render_us = us;
+        }
+        break;
+    case LV_EVENT_FLUSH_START: {
+        m.flush_start_us = now;
+        const auto* area = static_cast<const lv_area_t*>(lv_event_get_param(e));
+        const uint32_t px = area ? lv_area_get_size(area) : 0;
+        st.flushed_px += px;
+        st.psram_bytes += uint64_t{px} * kPsramBytesPerPx;
+        break;
+    }
+    case LV_EVENT_FLUSH_FINISH: {
+        const int64_t us = now - m.flush_start_us;
+        ++st.flushes;
+        ++m.frame_flushes;
+        st.flush_us += us;
+        if (us > st.max_flush_us) st.max_flush_us = us;
+        break;
+    }
+    case LV_EVENT_FLUSH_WAIT_START:
+        m.wait_start_us = now;
+        break;
+    case LV_EVENT_FLUSH_WAIT_FINISH:
+        st.flush_wait_us += now - m.wait_start_us;
+        break;
+    default:
+        break;
+    }
+}
 
 /* ── Initialisation helpers ──────────────────────────────────────────── */
 
@@ -59,17 +190,20 @@ esp_err_t InitLcd(esp_lcd_panel_handle_t& out_panel)
             .pclk_hz            = kPixelClkHz,
             .h_res              = kHRes,
             .v_res              = kVRes,
-            .hsync_pulse_width  = 4,
-            .hsync_back_porch   = 8,
-            .hsync_front_porch  = 8,
-            .vsync_pulse_width  = 4,
-            .vsync_back_porch   = 8,
-            .vsync_front_porch  = 8,
+            .hsync_pulse_width  = kHsyncPulse,
+            .hsync_back_porch   = kHsyncBack,
+            .hsync_front_porch  = kHsyncFront,
+            .vsync_pulse_width  = kVsyncPulse,
+            .vsync_back_porch   = kVsyncBack,
+            .vsync_front_porch  = kVsyncFront,
             .flags = {.pclk_active_neg = true},
         },
         .data_width = 16,
-        .num_fbs = 1,
-        .bounce_buffer_size_px = 0,
+        .num_fbs = kFrameBuffers,
+        // Bounce buffers: the panel DMA reads small internal-RAM buffers that
+        // the CPU refills from the PSRAM frame buffer, so Wi-Fi and flash
+        // traffic on the PSRAM bus can no longer starve the scanout.
+        .bounce_buffer_size_px = kHRes * kBounceLines,
         .hsync_gpio_num = kPinHsync,
         .vsync_gpio_num = kPinVsync,
         .de_gpio_num = kPinDE,
@@ -89,7 +223,8 @@ esp_err_t InitLcd(esp_lcd_panel_handle_t& out_panel)
     ESP_RETURN_ON_ERROR(esp_lcd_panel_reset(out_panel), TAG, "Panel reset failed");
     ESP_RETURN_ON_ERROR(esp_lcd_panel_init(out_panel), TAG, "Panel init failed");
 
-    ESP_LOGI(TAG, "RGB LCD panel initialised (%lux%lu)", kHRes, kVRes);
+    ESP_LOGI(TAG, "RGB LCD panel initialised (%lux%lu, %u FB, %lu-line bounce)",
+             kHRes, kVRes, static_cast<unsigned>(kFrameBuffers), kBounceLines);
     return ESP_OK;
 }
 
@@ -111,28 +246,36 @@ esp_err_t Init()
     esp_lcd_panel_handle_t lcd_panel{};
     ESP_RETURN_ON_ERROR(InitLcd(lcd_panel), TAG, "LCD init failed");
 
-    const lvgl_port_cfg_t lvgl_cfg = ESP_LVGL_PORT_INIT_CONFIG();
+    // The port task runs lv_timer_handler(); rendering itself is spread over
+    // LVGL's draw unit threads (CONFIG_LV_DRAW_SW_DRAW_UNIT_CNT).
+    lvgl_port_cfg_t lvgl_cfg = ESP_LVGL_PORT_INIT_CONFIG();
+    lvgl_cfg.task_priority = task_plan::kLvgl.priority;
+    lvgl_cfg.task_stack = task_plan::kLvgl.stack;
+    lvgl_cfg.task_affinity = task_plan::kLvgl.core;
     ESP_RETURN_ON_ERROR(lvgl_port_init(&lvgl_cfg), TAG, "LVGL port init failed");
 
+    // With avoid_tearing the port hands LVGL the panel's frame buffers and
+    // ignores the draw buffer settings.
     const lvgl_port_display_cfg_t disp_cfg = {
         .panel_handle = lcd_panel,
-        .buffer_size = kHRes * 10,
-        .double_buffer = false,
+        .buffer_size = kAvoidTearing ? kHRes * kVRes : kHRes * kDrawBufLines,
+        .double_buffer = kAvoidTearing || kDrawBufDouble,
         .hres = kHRes,
         .vres = kVRes,
         .monochrome = false,
         .color_format = LV_COLOR_FORMAT_RGB565,
         .flags = {
-            .buff_dma = false,
-            .buff_spiram = false,
+            .buff_dma = !kDrawBufPsram,
+            .buff_spiram = kDrawBufPsram,
             .swap_bytes = false,
-            .direct_mode = false,
+            .full_refresh = kPipeline == Pipeline::kTearFree,
+            .direct_mode = kPipeline == Pipeline::kDirect,
         },
     };
     const lvgl_port_display_rgb_cfg_t rgb_cfg = {
         .flags = {
-            .bb_mode = false,
-            .avoid_tearing = false,
+            .bb_mode = kBounceLines > 0,
+            .avoid_tearing = kAvoidTearing,
         },
     };
     auto* disp = lvgl_port_add_disp_rgb(&disp_cfg, &rgb_cfg);
@@ -141,9 +284,91 @@ esp_err_t Init()
         return ESP_FAIL;
     }
 
+    if (lvgl_port_lock(0)) {
+        for (auto code : {LV_EVENT_REFR_START, LV_EVENT_REFR_READY,
+                          LV_EVENT_FLUSH_START, LV_EVENT_FLUSH_FINISH,
+                          LV_EVENT_FLUSH_WAIT_START, LV_EVENT_FLUSH_WAIT_FINISH}) {
+            lv_display_add_event_cb(disp, OnDisplayEvent, code, nullptr);
+        }
+        s_meter.logged_us = esp_timer_get_time();
+        lvgl_port_unlock();
+    }
+    ESP_LOGI(TAG, "Pipeline: %s, draw buffer %s; scanout %lu Hz, %lu KB/s PSRAM",
+             PipelineName(),
+             kAvoidTearing ? "= frame buffers"
+                 : kDrawBufPsram ? "in PSRAM" : "in internal DMA RAM",
+             kPanelHz, kScanoutBytesPerS / 1000);
+
     BacklightOn();
     ESP_LOGI(TAG, "Display fully initialised");
     return ESP_OK;
 }
 
+const char* PipelineName()
+{
+    switch (kPipeline) {
+    case Pipeline::kBounce:   return "single FB + bounce buffers";
+    case Pipeline::kDirect:   return "double FB, direct mode";
+    case Pipeline::kTearFree: return "triple FB, full refresh on vsync";
+    default:                  return "single FB, partial";
+    }
+}
+
+int64_t BenchRedraw(int frames)
+{
+    if (frames <= 0 || !lvgl_port_lock(0)) return 0;
+
+    int64_t total = 0;
+    int64_t best = INT64_MAX;
+    int64_t worst = 0;
+    for (int i = 0; i < frames; ++i) {
+        lv_obj_invalidate(lv_screen_active());
+        const int64_t t0 = esp_timer_get_time();
+        lv_refr_now(nullptr);
+        const int64_t us = esp_timer_get_time() - t0;
+        total += us;
+        best = std::min(best, us);
+        worst = std::max(worst, us);
+    }
+    lvgl_port_unlock();
+
+    const int64_t avg = total / frames;
+    ESP_LOGI(TAG, "Full-screen redraw x%d: %lld us avg, %lld min, %lld max "
+             "(%s, %d draw unit(s))",
+             frames, static_cast<long long>(avg), static_cast<long long>(best),
+             static_cast<long long>(worst), PipelineName(), LV_DRAW_SW_DRAW_UNIT_CNT);
+    return avg;
+}
+
+Stats GetStats()
+{
+    return s_meter.stats;
+}
+
+void LogStats()
+{
+    auto& m = s_meter;
+    const auto& now = m.stats;
+    const auto& then = m.logged;
+    const int64_t t = esp_timer_get_time();
+    const double s = (t - m.logged_us) / 1e6;
+    const uint32_t frames = now.frames - then.frames;
+    const uint32_t flushes = now.flushes - then.flushes;
+
+    ESP_LOGI(TAG, "%.1f fps, render %lld us avg / %lld max, flush %lld us avg / %lld max, "
+             "wait %lld us/frame, %.0f kpx/s, PSRAM %.0f KB/s + %lu KB/s scanout",
+             s > 0 ? frames / s : 0.0,
+             frames ? static_cast<long long>((now.render_us - then.render_us) / frames) : 0LL,
+             static_cast<long long>(now.max_render_us),
+             flushes ? static_cast<long long>((now.flush_us - then.flush_us) / flushes) : 0LL,
+             static_cast<long long>(now.max_flush_us),
+             frames ? static_cast<long long>((now.flush_wait_us - then.flush_wait_us) / frames) : 0LL,
+             s > 0 ? (now.flushed_px - then.flushed_px) / s / 1000 : 0.0,
+             s > 0 ? (now.psram_bytes - then.psram_bytes) / s / 1000 : 0.0,
+             kScanoutBytesPerS / 1000);
+
+    m.logged = now;
+    m.logged_us = t;
+}
+
 } // namespace esp32_8048s043
@@ -10,9 +10,44 @@ constexpr uint32_t kHRes = 800;
 constexpr uint32_t kVRes = 480;
 
 /**
- * Initialise the RGB LCD panel and LVGL port.
+ * Display pipeline counters since Init(), from LVGL's refresh and flush
+ * events. Updated in the LVGL task; read with the port lock held.
+ */
+struct Stats {
+    uint32_t frames;          // refreshes that flushed anything
+    uint32_t flushes;         // flush_cb calls (several per frame in partial modes)
+    uint64_t flushed_px;
+    int64_t render_us;        // REFR_START → REFR_READY, cumulative
+    int64_t max_render_us;
+    int64_t flush_us;         // inside flush_cb, cumulative
+    int64_t max_flush_us;
+    int64_t flush_wait_us;    // blocked on the panel (vsync, previous flush)
+    uint64_t psram_bytes;     // estimated LVGL-side PSRAM traffic (render + copies)
+};
+
+/**
+ * Initialise the RGB LCD panel and LVGL port, in the pipeline selected by
+ * CONFIG_AQM_DISPLAY_* (frame buffers, bounce buffers, draw buffer).
  * After this returns the LVGL task is running and the display is ready.
  */
 [[nodiscard]] esp_err_t Init();
 
+/** Name of the configured pipeline, for logs. */
+const char* PipelineName();
+
+Stats GetStats();
+
+/**
+ * Invalidates and synchronously redraws the active screen `frames` times
+ * and logs the timings; returns the mean in microseconds. Takes the LVGL
+ * port lock, so call from outside the LVGL task.
+ */
+int64_t BenchRedraw(int frames);
+
+/**
+ * Logs FPS, render/flush times and PSRAM bandwidth since the previous
+ * call. Call from the LVGL task (e.g. an lv_timer).
+ */
+void LogStats();
+
 } // namespace esp32_8048s043
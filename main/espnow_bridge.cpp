@@ -0,0 +1,721 @@
+#include "espnow_bridge.hpp"
+#include "device_id.hpp"
+#include "device_registry.hpp"
+#include "discovery_scheduler.hpp"
+#include "espnow_protocol.h"
+#include "ha_discovery.hpp"
+#include "mqtt.hpp"
+#include "task_plan.hpp"
+
+#include "sdkconfig.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <tuple>
+
+static const char* TAG = "espnow";
+
+namespace {
+
+constexpr size_t kMacLen = 6;
+
+// Reordering tolerated per peer, in frames (bits of Peer::window)
+constexpr int kSeqWindow = 32;
+
+// A jump further ahead than this is a resync, not that many losses
+constexpr int kMaxGap = 1024;
+
+// Longest uplink record: an unknown type, so the whole payload as hex
+// (see Append()); a decoded message is far shorter
+constexpr size_t kMaxRecord =
+    sizeof(R"({"mac":"a0b1c2d3e4f5","type":255,"seq":65535,"rssi":-128,)"
+           R"("age_ms":4294967295,"data":""})") +
+    2 * espnow::kMaxPayload;
+
+// Longest "values" object of message M: `,"key":` and a number of at most
+// 20 characters per field
+template <typename M>
+constexpr size_t ValuesLen()
+{
+    size_t n = 0;
+    for (const auto& f : espnow::Schema<M>::kFields) {
+        n += std::char_traits<char>::length(f.key) + 4 + 20;
+    }
+    return n;
+}
+
+template <typename... Ms>
+constexpr size_t MaxValuesLen(std::tuple<Ms...>*)
+{
+    return std::max({ValuesLen<Ms>()...});
+}
+
+constexpr size_t kMaxValues = MaxValuesLen(static_cast<espnow::Messages*>(nullptr));
+static_assert(kMaxValues < kMaxRecord);
+
+/** One frame as the radio delivered it, waiting for the bridge task. */
+struct RxFrame {
+    int64_t rx_us;
+    uint8_t mac[kMacLen];
+    int8_t rssi;
+    uint8_t len;
+    uint8_t data[espnow::kMaxFrame];
+};
+
+uint64_t MacKey(const uint8_t* mac)
+{
+    uint64_t key = 0;
+    std::memcpy(&key, mac, kMacLen);
+    return key;
+}
+
+void PutHex(char* out, const uint8_t* data, size_t len)
+{
+    static constexpr char kDigits[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; ++i) {
+        *out++ = kDigits[data[i] >> 4];
+        *out++ = kDigits[data[i] & 0x0F];
+    }
+    *out = '\0';
+}
+
+int HexDigit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/** Decodes `len` hex digits into `out`. False if malformed or too long. */
+bool ParseHex(const char* hex, size_t len, uint8_t* out, size_t max)
+{
+    if (len % 2 != 0 || len / 2 > max) return false;
+    for (size_t i = 0; i < len; i += 2) {
+        const int hi = HexDigit(hex[i]);
+        const int lo = HexDigit(hex[i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i / 2] = static_cast<uint8_t>(hi << 4 | lo);
+    }
+    return true;
+}
+
+} // namespace
+
+/* ── Implementation ──────────────────────────────────────────────────── */
+
+struct EspNowBridge::Impl {
+    /** Link state of one node, by registry id. Written by the bridge task only. */
+    struct Peer {
+        bool synced{};
+        uint16_t last_seq{};
+        uint32_t window{};  // bit i set: frame last_seq - i arrived
+        bool has_stray{};
+        uint16_t stray_seq{};  // last frame dropped as out of sequence
+        std::atomic<uint32_t> received{0};
+        std::atomic<uint32_t> duplicates{0};
+        std::atomic<uint32_t> lost{0};
+        std::atomic<uint32_t> late{0};
+        std::atomic<uint32_t> stale{0};
+        std::atomic<uint32_t> restarts{0};
+        std::atomic<int8_t> rssi{0};
+        uint8_t type{};  // of its readings, 0 until the first
+    };
+
+    Config cfg;
+    std::unique_ptr<EspNowTransport> io;
+    TaskHandle_t task{};
+
+    // Receive hook → task. Single producer (the radio), single consumer.
+    RxFrame* ring{};
+    uint32_t mask{};
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+
+    std::unique_ptr<DeviceRegistry> registry;
+    std::unique_ptr<Peer[]> peers;
+    std::atomic<bool> resync{false};  // MQTT reconnected: retry availability
+    std::unique_ptr<DiscoveryScheduler> discovery;
+    int64_t discovery_next{INT64_MAX};
+
+    // Uplink batch; between batches it also builds the stats messages
+    std::unique_ptr<char[]> batch;
+    size_t batch_len{};
+    uint32_t batch_frames{};
+
+    char rx_topic[48]{};
+    char stats_topic[48]{};
+    char peers_topic[48]{};
+    char cmd_prefix[48]{};   // aqm/<id>/espnow/
+    char cmd_filter[64]{};   // aqm/<id>/espnow/+/cmd/+
+    char disc_prefix[64]{};  // homeassistant/device/<id>/
+
+    std::atomic<uint16_t> tx_seq{0};
+
+    std::atomic<uint32_t> received{0};
+    std::atomic<uint32_t> ring_full{0};
+    std::atomic<uint32_t> malformed{0};
+    std::atomic<uint32_t> unknown_peer{0};
+    std::atomic<uint32_t> published{0};
+    std::atomic<uint32_t> unsent{0};
+    std::atomic<uint32_t> batches{0};
+    std::atomic<uint32_t> sent{0};
+
+    /* ── Receive hook (radio context) ────────────────────────────────── */
+
+    static void OnRecv(void* ctx, const uint8_t* mac, const uint8_t* data, size_t len,
+                       int8_t rssi)
+    {
+        auto* self = static_cast<Impl*>(ctx);
+        if (len > espnow::kMaxFrame) {
+            self->malformed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        const uint32_t h = self->head.load(std::memory_order_relaxed);
+        const uint32_t t = self->tail.load(std::memory_order_acquire);
+        if (h - t > self->mask) {
+            self->ring_full.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        RxFrame& f = self->ring[h & self->mask];
+        f.rx_us = esp_timer_get_time();
+        std::memcpy(f.mac, mac, kMacLen);
+        f.rssi = rssi;
+        f.len = static_cast<uint8_t>(len);
+        std::memcpy(f.data, data, len);
+        self->head.store(h + 1, std::memory_order_release);
+
+        // Every frame notifies: skipping when the ring looked non-empty
+        // loses the wake if the task is just finishing its last Drain().
+        // Notifies only add up to a count, so a burst costs one wake.
+        xTaskNotifyGive(self->task);
+    }
+
+    /* ── Bridge task ─────────────────────────────────────────────────── */
+
+    static void Run(void* arg)
+    {
+        static_cast<Impl*>(arg)->Loop();
+    }
+
+    void Loop()
+    {
+        const TickType_t stats_ticks = pdMS_TO_TICKS(cfg.stats_s * 1000);
+        TickType_t next_stats = xTaskGetTickCount() + stats_ticks;
+        for (;;) {
+            TickType_t wait = portMAX_DELAY;
+            if (cfg.stats_s > 0) {
+                const auto until = static_cast<int32_t>(next_stats - xTaskGetTickCount());
+                wait = static_cast<TickType_t>(std::max<int32_t>(until, 0));
+            }
+            // Sleep until the heartbeat wheel or discovery next has work,
+            // not every tick
+            const int64_t deadline = std::min(registry->NextDeadline(), discovery_next);
+            if (deadline != INT64_MAX) {
+                const int64_t ms = (deadline - esp_timer_get_time() + 999) / 1000;
+                wait = std::min(wait, pdMS_TO_TICKS(std::max<int64_t>(ms, 0)));
+            }
+            if (ulTaskNotifyTake(pdTRUE, wait) > 0) {
+                // Let the rest of the burst arrive, then publish it as one.
+                // Its frames notified too; clear that before draining, so
+                // only frames after this point wake the task again.
+                if (cfg.batch_ms > 0) vTaskDelay(pdMS_TO_TICKS(cfg.batch_ms));
+                ulTaskNotifyTake(pdTRUE, 0);
+                Drain();
+            }
+            registry->Advance(esp_timer_get_time());
+            if (resync.exchange(false)) registry->Retry();
+            if (discovery) discovery_next = discovery->Pump(esp_timer_get_time());
+            if (cfg.stats_s > 0 &&
+                static_cast<int32_t>(xTaskGetTickCount() - next_stats) >= 0) {
+                PublishStats();
+                next_stats += stats_ticks;
+            }
+        }
+    }
+
+    void Drain()
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        while (t != head.load(std::memory_order_acquire)) {
+            Accept(ring[t & mask]);
+            tail.store(++t, std::memory_order_release);
+        }
+        Flush();
+    }
+
+    void Accept(const RxFrame& f)
+    {
+        received.fetch_add(1, std::memory_order_relaxed);
+        espnow::Header h;
+        if (f.len < sizeof(h) || f.data[0] != espnow::kVersion) {
+            malformed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::memcpy(&h, f.data, sizeof(h));
+
+        const int id = registry->Touch(f.mac, f.rx_us);
+        if (id < 0) {
+            unknown_peer.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        Peer& p = peers[id];
+        p.rssi.store(f.rssi, std::memory_order_relaxed);
+        if (!Track(p, h.seq)) return;
+
+        p.received.fetch_add(1, std::memory_order_relaxed);
+        if (discovery && espnow::IsReading(h.type) && h.type != p.type) {
+            // New node, or it changed what it reports: (re)announce it
+            p.type = h.type;
+            discovery->Update(id, MacKey(f.mac));
+        }
+        Append(f, h);
+    }
+
+    /** DiscoveryScheduler WriteFn: the node's Home Assistant device config. */
+    static size_t WriteDiscovery(void* ctx, int id, char* topic, size_t topic_size, char* config,
+                                 size_t size)
+    {
+        const auto* self = static_cast<const Impl*>(ctx);
+        char mac[2 * kMacLen + 1];
+        PutHex(mac, self->registry->Mac(id), kMacLen);
+        return ha_discovery_write_node(device_id_get(), mac, self->peers[id].type, topic,
+                                       topic_size, config, size);
+    }
+
+    /** DiscoveryScheduler ResolveFn: homeassistant/device/<id>/<mac>/config. */
+    static bool ResolveDiscovery(void* ctx, const char* topic, int topic_len, int* id,
+                                 uint64_t* key)
+    {
+        const auto* self = static_cast<const Impl*>(ctx);
+        constexpr char kSuffix[] = "/config";
+        const size_t prefix_len = std::strlen(self->disc_prefix);
+        uint8_t mac[kMacLen];
+        if (topic_len < 0 ||
+            static_cast<size_t>(topic_len) != prefix_len + 2 * kMacLen + sizeof(kSuffix) - 1 ||
+            std::memcmp(topic, self->disc_prefix, prefix_len) != 0 ||
+            std::memcmp(topic + prefix_len + 2 * kMacLen, kSuffix, sizeof(kSuffix) - 1) != 0 ||
+            !ParseHex(topic + prefix_len, 2 * kMacLen, mac, sizeof(mac))) {
+            return false;
+        }
+        *key = MacKey(mac);
+        *id = self->registry->Find(mac);
+        return true;
+    }
+
+    /** Registry ChangeFn: retained "online" / "offline" per node. */
+    static bool OnAvailability(void* ctx, int, const uint8_t* mac, bool online)
+    {
+        const auto* self = static_cast<const Impl*>(ctx);
+        if (!mqtt_is_connected()) return false;
+        char hex[2 * kMacLen + 1];
+        PutHex(hex, mac, kMacLen);
+        char topic[80];
+        std::snprintf(topic, sizeof(topic), "%s%s/availability", self->cmd_prefix, hex);
+        return mqtt_publish(topic, online ? "online" : "offline", 1, true) >= 0;
+    }
+
+    /**
+     * Folds `seq` into the peer's window (as in IPsec anti-replay).
+     * Returns false for a duplicate or a stray frame.
+     */
+    static bool Track(Peer& p, uint16_t seq)
+    {
+        const int diff = static_cast<int16_t>(seq - p.last_seq);
+        // seq 0 is a boot unless it follows 65535 (or repeats the last frame)
+        const bool boot = seq == 0 && diff != 1 && diff != 0;
+        if (p.synced && !boot && (diff > kMaxGap || diff <= -kSeqWindow)) {
+            // Far out of sequence: a delayed stray, or a restart whose first
+            // frames were lost. Resync only once a second frame follows it.
+            const int from_stray = static_cast<int16_t>(seq - p.stray_seq);
+            if (!p.has_stray || from_stray <= 0 || from_stray > kSeqWindow) {
+                p.has_stray = true;
+                p.stray_seq = seq;
+                p.stale.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        if (!p.synced || boot || diff > kMaxGap || diff <= -kSeqWindow) {
+            // First frame, or the node restarted: everything before is history
+            if (p.synced) p.restarts.fetch_add(1, std::memory_order_relaxed);
+            p.synced = true;
+            p.has_stray = false;
+            p.last_seq = seq;
+            p.window = UINT32_MAX;
+            return true;
+        }
+        p.has_stray = false;
+        if (diff > 0) {
+            p.window = diff < kSeqWindow ? p.window << diff | 1u : 1u;
+            p.last_seq = seq;
+            if (diff > 1) p.lost.fetch_add(diff - 1, std::memory_order_relaxed);
+            return true;
+        }
+        const uint32_t bit = 1u << -diff;
+        if (p.window & bit) {
+            p.duplicates.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        // Counted lost when the gap opened; it was only late
+        p.window |= bit;
+        p.late.fetch_add(1, std::memory_order_relaxed);
+        p.lost.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /* ── Uplink ──────────────────────────────────────────────────────── */
+
+    // {"mac":"a0b1c2d3e4f5","type":"sen55","seq":17,"rssi":-61,"age_ms":21,
+    //  "values":{"pm1_0":1.2,…,"nox_index":null}}, or for a type not in
+    //  espnow_protocol.h: "type":200,…,"data":"0a0b…"
+    void Append(const RxFrame& f, const espnow::Header& h)
+    {
+        const uint8_t* payload = f.data + sizeof(h);
+        const size_t payload_len = f.len - sizeof(h);
+
+        char values[kMaxValues + 1] = "";
+        size_t values_len = 0;
+        const char* name = espnow::Decode(h.type, payload, payload_len,
+                                          [&](const espnow::Field& field, float v) {
+            values_len += std::snprintf(values + values_len, sizeof(values) - values_len,
+                                        std::isnan(v) ? "%s\"%s\":null" : "%s\"%s\":%.*f",
+                                        values_len ? "," : "", field.key, field.decimals,
+                                        static_cast<double>(v));
+        });
+
+        char mac[2 * kMacLen + 1];
+        PutHex(mac, f.mac, kMacLen);
+        const auto age_ms = static_cast<unsigned long>((esp_timer_get_time() - f.rx_us) / 1000);
+        char rec[kMaxRecord];
+        size_t len;
+        if (name) {
+            len = std::snprintf(rec, sizeof(rec),
+                                "{\"mac\":\"%s\",\"type\":\"%s\",\"seq\":%u,\"rssi\":%d,"
+                                "\"age_ms\":%lu,\"values\":{%s}}",
+                                mac, name, static_cast<unsigned>(h.seq), f.rssi, age_ms, values);
+        } else {
+            len = std::snprintf(rec, sizeof(rec),
+                                "{\"mac\":\"%s\",\"type\":%u,\"seq\":%u,\"rssi\":%d,"
+                                "\"age_ms\":%lu,\"data\":\"",
+                                mac, static_cast<unsigned>(h.type), static_cast<unsigned>(h.seq),
+                                f.rssi, age_ms);
+            PutHex(rec + len, payload, payload_len);
+            len += 2 * payload_len;
+            len += std::snprintf(rec + len, sizeof(rec) - len, "\"}");
+        }
+
+        if (batch_len + len + 3 > cfg.batch_bytes) Flush();
+        batch_len += std::snprintf(batch.get() + batch_len, cfg.batch_bytes - batch_len, "%s%s",
+                                   batch_frames ? "," : "{\"frames\":[", rec);
+        ++batch_frames;
+    }
+
+    void Flush()
+    {
+        if (batch_frames == 0) return;
+        std::snprintf(batch.get() + batch_len, cfg.batch_bytes - batch_len, "]}");
+
+        if (mqtt_is_connected() && mqtt_publish(rx_topic, batch.get()) >= 0) {
+            published.fetch_add(batch_frames, std::memory_order_relaxed);
+            batches.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            unsent.fetch_add(batch_frames, std::memory_order_relaxed);
+        }
+        batch_len = 0;
+        batch_frames = 0;
+    }
+
+    // Totals on .../espnow/stats:
+    //   {"rx":…,"ring_full":0,…,"peers":40,"online":38,"announced":40,
+    //    "announce_queue":0}
+    // then the peers, as many messages of at most batch_bytes as it takes,
+    // on .../espnow/peers:
+    //   {"a0b1c2d3e4f5":{"online":true,"rx":…,"lost":…,"dup":…,"late":…,
+    //    "stale":0,"restarts":0,"rssi":-61,"age_s":3},…}
+    void PublishStats()
+    {
+        if (!mqtt_is_connected()) return;
+        const auto s = Totals();
+        char* buf = batch.get();
+        const size_t size = cfg.batch_bytes;
+        std::snprintf(buf, size,
+            "{\"rx\":%lu,\"ring_full\":%lu,\"malformed\":%lu,\"unknown_peer\":%lu,"
+            "\"dup\":%lu,\"lost\":%lu,\"stale\":%lu,\"published\":%lu,\"unsent\":%lu,"
+            "\"batches\":%lu,\"sent\":%lu,\"peers\":%lu,\"online\":%lu,\"announced\":%lu,"
+            "\"announce_queue\":%lu}",
+            static_cast<unsigned long>(s.received), static_cast<unsigned long>(s.ring_full),
+            static_cast<unsigned long>(s.malformed), static_cast<unsigned long>(s.unknown_peer),
+            static_cast<unsigned long>(s.duplicates), static_cast<unsigned long>(s.lost),
+            static_cast<unsigned long>(s.stale),
+            static_cast<unsigned long>(s.published), static_cast<unsigned long>(s.unsent),
+            static_cast<unsigned long>(s.batches), static_cast<unsigned long>(s.sent),
+            static_cast<unsigned long>(s.peers), static_cast<unsigned long>(s.online),
+            static_cast<unsigned long>(s.announced), static_cast<unsigned long>(s.announce_queue));
+        mqtt_publish(stats_topic, buf);
+
+        const int64_t now = esp_timer_get_time();
+        const size_t n = registry->Size();
+        size_t len = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const int id = static_cast<int>(i);
+            const auto& p = peers[i];
+            char mac[2 * kMacLen + 1];
+            PutHex(mac, registry->Mac(id), kMacLen);
+            char entry[200];
+            const int entry_len = std::snprintf(
+                entry, sizeof(entry),
+                "\"%s\":{\"online\":%s,\"rx\":%lu,\"lost\":%lu,\"dup\":%lu,\"late\":%lu,"
+                "\"stale\":%lu,\"restarts\":%lu,\"rssi\":%d,\"age_s\":%lld}",
+                mac, registry->IsOnline(id) ? "true" : "false",
+                static_cast<unsigned long>(p.received.load()),
+                static_cast<unsigned long>(p.lost.load()),
+                static_cast<unsigned long>(p.duplicates.load()),
+                static_cast<unsigned long>(p.late.load()),
+                static_cast<unsigned long>(p.stale.load()),
+                static_cast<unsigned long>(p.restarts.load()), p.rssi.load(),
+                static_cast<long long>((now - registry->LastSeen(id)) / 1'000'000));
+            if (len > 0 && len + entry_len + 2 >= size) {
+                std::snprintf(buf + len, size - len, "}");
+                mqtt_publish(peers_topic, buf);
+                len = 0;
+            }
+            len += std::snprintf(buf + len, size - len, "%s%s", len ? "," : "{", entry);
+        }
+        if (len > 0) {
+            std::snprintf(buf + len, size - len, "}");
+            mqtt_publish(peers_topic, buf);
+        }
+    }
+
+    Stats Totals() const
+    {
+        Stats s{};
+        s.received = received.load(std::memory_order_relaxed);
+        s.ring_full = ring_full.load(std::memory_order_relaxed);
+        s.malformed = malformed.load(std::memory_order_relaxed);
+        s.unknown_peer = unknown_peer.load(std::memory_order_relaxed);
+        s.published = published.load(std::memory_order_relaxed);
+        s.unsent = unsent.load(std::memory_order_relaxed);
+        s.batches = batches.load(std::memory_order_relaxed);
+        s.sent = sent.load(std::memory_order_relaxed);
+        const size_t n = registry->Size();
+        s.peers = static_cast<uint32_t>(n);
+        s.online = static_cast<uint32_t>(registry->Online());
+        if (discovery) {
+            const auto ds = discovery->GetStats();
+            s.announced = ds.published;
+            s.announce_queue = ds.queued;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            s.duplicates += peers[i].duplicates.load(std::memory_order_relaxed);
+            s.lost += peers[i].lost.load(std::memory_order_relaxed);
+            s.stale += peers[i].stale.load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+};
+
+/* ── EspNowBridge ────────────────────────────────────────────────────── */
+
+EspNowBridge::Config EspNowBridge::Config::Default()
+{
+    return {
+        .ring_depth = CONFIG_AQM_ESPNOW_RX_RING,
+        .batch_ms = CONFIG_AQM_ESPNOW_BATCH_MS,
+        .batch_bytes = CONFIG_AQM_ESPNOW_BATCH_BYTES,
+        .max_peers = CONFIG_AQM_ESPNOW_MAX_PEERS,
+        .heartbeat_s = CONFIG_AQM_ESPNOW_HEARTBEAT_S,
+        .stats_s = CONFIG_AQM_ESPNOW_STATS_S,
+#if CONFIG_AQM_ESPNOW_DISCOVERY
+        .discovery = true,
+#else
+        .discovery = false,
+#endif
+    };
+}
+
+EspNowBridge::EspNowBridge(std::unique_ptr<EspNowTransport> transport, const Config& cfg)
+    : impl_(std::make_unique<Impl>())
+{
+    auto& d = *impl_;
+    d.cfg = cfg;
+    d.cfg.ring_depth = std::bit_ceil(std::max<size_t>(cfg.ring_depth, 2));
+    d.cfg.batch_bytes = std::max(cfg.batch_bytes, kMaxRecord + 16);
+    d.io = std::move(transport);
+    d.mask = static_cast<uint32_t>(d.cfg.ring_depth - 1);
+
+    // The ring is the one large buffer; PSRAM is fine at radio rates
+    const size_t ring_bytes = d.cfg.ring_depth * sizeof(RxFrame);
+    d.ring = static_cast<RxFrame*>(heap_caps_malloc(ring_bytes, MALLOC_CAP_SPIRAM));
+    if (!d.ring) {
+        ESP_LOGW(TAG, "No PSRAM for %u frames, using internal RAM",
+                 static_cast<unsigned>(d.cfg.ring_depth));
+        d.ring = static_cast<RxFrame*>(heap_caps_malloc(ring_bytes, MALLOC_CAP_DEFAULT));
+    }
+    assert(d.ring);
+
+    d.registry = std::make_unique<DeviceRegistry>(
+        DeviceRegistry::Config{
+            .max_devices = d.cfg.max_peers,
+            .timeout_s = d.cfg.heartbeat_s,
+            .tick_ms = 1000,
+        },
+        Impl::OnAvailability, &d);
+    d.peers = std::make_unique<Impl::Peer[]>(d.cfg.max_peers);
+    d.batch = std::make_unique<char[]>(d.cfg.batch_bytes);
+
+    const char* id = device_id_get();
+    std::snprintf(d.rx_topic, sizeof(d.rx_topic), "aqm/%s/espnow/rx", id);
+    std::snprintf(d.stats_topic, sizeof(d.stats_topic), "aqm/%s/espnow/stats", id);
+    std::snprintf(d.peers_topic, sizeof(d.peers_topic), "aqm/%s/espnow/peers", id);
+    std::snprintf(d.cmd_prefix, sizeof(d.cmd_prefix), "aqm/%s/espnow/", id);
+    std::snprintf(d.cmd_filter, sizeof(d.cmd_filter), "aqm/%s/espnow/+/cmd/+", id);
+    std::snprintf(d.disc_prefix, sizeof(d.disc_prefix), "homeassistant/device/%s/", id);
+
+    if (d.cfg.discovery) {
+        auto dc = DiscoveryScheduler::Config::Default();
+        dc.max_devices = d.cfg.max_peers;
+        char filter[80];
+        std::snprintf(filter, sizeof(filter), "%s+/config", d.disc_prefix);
+        d.discovery = std::make_unique<DiscoveryScheduler>(dc, filter, Impl::WriteDiscovery,
+                                                           Impl::ResolveDiscovery, &d);
+    }
+
+    task_plan::Create<task_plan::kEspNow>(Impl::Run, &d, &d.task);
+    ESP_ERROR_CHECK(d.io->Start(Impl::OnRecv, &d));
+    ESP_LOGI(TAG, "Bridging to %s (ring %u, batch %lu ms / %u bytes, %u peers)", d.rx_topic,
+             static_cast<unsigned>(d.cfg.ring_depth), static_cast<unsigned long>(d.cfg.batch_ms),
+             static_cast<unsigned>(d.cfg.batch_bytes), static_cast<unsigned>(d.cfg.max_peers));
+}
+
+EspNowBridge::~EspNowBridge()
+{
+    // Radio first, so nothing writes to the ring or wakes the task after
+    impl_->io.reset();
+    if (impl_->task) {
+        vTaskDelete(impl_->task);
+    }
+    heap_caps_free(impl_->ring);
+}
+
+esp_err_t EspNowBridge::Send(const uint8_t* mac, uint8_t type, const uint8_t* payload, size_t len)
+{
+    if (len > espnow::kMaxPayload) return ESP_ERR_INVALID_SIZE;
+
+    uint8_t frame[espnow::kMaxFrame];
+    const espnow::Header h{
+        .version = espnow::kVersion,
+        .type = type,
+        .seq = impl_->tx_seq.fetch_add(1, std::memory_order_relaxed),
+    };
+    std::memcpy(frame, &h, sizeof(h));
+    if (len > 0) std::memcpy(frame + sizeof(h), payload, len);
+
+    const esp_err_t err = impl_->io->Send(mac, frame, sizeof(h) + len);
+    if (err == ESP_OK) {
+        impl_->sent.fetch_add(1, std::memory_order_relaxed);
+    }
+    return err;
+}
+
+void EspNowBridge::OnMqttConnect()
+{
+    mqtt_subscribe(impl_->cmd_filter, 1);
+    if (impl_->discovery) impl_->discovery->OnConnect(esp_timer_get_time());
+    // Availability changes missed while disconnected, and discovery, go
+    // out from the task
+    impl_->resync.store(true);
+    xTaskNotifyGive(impl_->task);
+}
+
+bool EspNowBridge::OnMqttData(const char* topic, int topic_len, const char* data, int data_len,
+                              int offset, int total_len)
+{
+    const auto& d = *impl_;
+    if (d.discovery &&
+        d.discovery->OnData(topic, topic_len, data, data_len, offset, total_len)) {
+        return true;
+    }
+
+    // aqm/<id>/espnow/<mac>/cmd/<type>; commands always fit one piece
+    const size_t prefix_len = std::strlen(d.cmd_prefix);
+    if (offset != 0 || data_len != total_len || topic_len < 0 ||
+        static_cast<size_t>(topic_len) <= prefix_len ||
+        std::memcmp(topic, d.cmd_prefix, prefix_len) != 0) {
+        return false;
+    }
+
+    char rest[32];
+    const auto rest_len = static_cast<size_t>(topic_len) - prefix_len;
+    if (rest_len >= sizeof(rest)) return false;
+    std::memcpy(rest, topic + prefix_len, rest_len);
+    rest[rest_len] = '\0';
+
+    uint8_t mac[kMacLen];
+    char* end = nullptr;
+    if (rest_len < 2 * kMacLen + 5 || std::strncmp(rest + 2 * kMacLen, "/cmd/", 5) != 0 ||
+        !ParseHex(rest, 2 * kMacLen, mac, sizeof(mac))) {
+        return false;
+    }
+    // <type> is a number or a message name from espnow_protocol.h
+    const char* type_str = rest + 2 * kMacLen + 5;
+    unsigned long type = std::strtoul(type_str, &end, 10);
+    uint8_t named;
+    if (end == type_str && espnow::TypeFromName(type_str, &named)) {
+        type = named;
+        end = rest + rest_len;
+    }
+    uint8_t payload[espnow::kMaxPayload];
+    if (end == type_str || *end != '\0' || type > UINT8_MAX ||
+        !ParseHex(data, static_cast<size_t>(data_len), payload, sizeof(payload))) {
+        ESP_LOGW(TAG, "Bad command on %s", rest);
+        return true;
+    }
+
+    const esp_err_t err = Send(mac, static_cast<uint8_t>(type), payload,
+                               static_cast<size_t>(data_len) / 2);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Command to %.12s failed: %s", rest, esp_err_to_name(err));
+    }
+    return true;
+}
+
+EspNowBridge::Stats EspNowBridge::GetStats() const
+{
+    return impl_->Totals();
+}
+
+size_t EspNowBridge::GetPeers(PeerStats* out, size_t max) const
+{
+    const auto& d = *impl_;
+    const size_t n = std::min(max, d.registry->Size());
+    for (size_t i = 0; i < n; ++i) {
+        const auto& p = d.peers[i];
+        auto& o = out[i];
+        const int id = static_cast<int>(i);
+        std::memcpy(o.mac, d.registry->Mac(id), kMacLen);
+        o.online = d.registry->IsOnline(id);
+        o.received = p.received.load(std::memory_order_relaxed);
+        o.duplicates = p.duplicates.load(std::memory_order_relaxed);
+        o.lost = p.lost.load(std::memory_order_relaxed);
+        o.late = p.late.load(std::memory_order_relaxed);
+        o.stale = p.stale.load(std::memory_order_relaxed);
+        o.restarts = p.restarts.load(std::memory_order_relaxed);
+        o.rssi = p.rssi.load(std::memory_order_relaxed);
+        o.last_us = d.registry->LastSeen(id);
+    }
+    return n;
+}
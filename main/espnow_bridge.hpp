@@ -0,0 +1,137 @@
+#pragma once
+
+#include "espnow_protocol.h"
+#include "espnow_transport.hpp"
+
+#include "esp_err.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * ESP-NOW ↔ MQTT bridge for the remote nodes.
+ *
+ * Uplink: the radio's receive hook only copies each frame into a
+ * lock-free single-producer ring and notifies the bridge task. The task
+ * waits out the rest of the burst (batch_ms), then drops duplicates by
+ * per-peer sequence number, counts losses, and publishes whatever
+ * arrived as one JSON message per batch_bytes to aqm/<device_id>/espnow/rx:
+ *
+ *   {"frames":[{"mac":"a0b1c2d3e4f5","type":"sen55","seq":17,"rssi":-61,
+ *               "age_ms":21,"values":{"pm1_0":1.2,…}},…]}
+ *
+ * Messages in espnow_protocol.h are decoded into `values`, in units; any
+ * other type goes out as its number with the payload as hex in `data`.
+ * `age_ms` is how long the frame waited between the radio and the batch. Frames that arrive
+ * while MQTT is down are counted as unsent and discarded. Every stats_s the counters go to
+ * aqm/<device_id>/espnow/stats and the per-node ones, paged, to
+ * aqm/<device_id>/espnow/peers.
+ *
+ * Nodes are tracked in a DeviceRegistry: a node is online from its first
+ * frame until heartbeat_s of silence, and each change is published,
+ * retained, as "online" / "offline" on
+ * aqm/<device_id>/espnow/<mac>/availability.
+ *
+ * With `discovery`, each node is announced to Home Assistant as a device
+ * of its own once its first reading arrives (ha_discovery_write_node()),
+ * paced by a DiscoveryScheduler so that a connect with the whole fleet to
+ * announce does not overrun the MQTT outbox, and skipping nodes whose
+ * config the broker already retains.
+ *
+ * Downlink: a message on aqm/<device_id>/espnow/<mac>/cmd/<type> is sent
+ * to that node as one frame of `type`, a number or a message name such
+ * as "command" (the payload as hex, e.g. an espnow::Command).
+ */
+class EspNowBridge {
+public:
+    struct Config {
+        size_t ring_depth;    // frames between the radio and the task; power of two
+        uint32_t batch_ms;    // wait after the first frame of a burst
+        size_t batch_bytes;   // largest uplink message
+        size_t max_peers;     // peers tracked; frames from others are dropped
+        uint32_t heartbeat_s; // silence before a peer is offline
+        uint32_t stats_s;     // between stats messages, 0 = never
+        bool discovery;       // announce nodes to Home Assistant
+
+        /** The Kconfig values (AQM_ESPNOW_*). */
+        static Config Default();
+    };
+
+    /** Bridge-wide counters, cumulative. */
+    struct Stats {
+        uint32_t received;     // frames out of the ring
+        uint32_t ring_full;    // dropped in the receive hook: the task fell behind
+        uint32_t malformed;    // too short or another protocol version
+        uint32_t unknown_peer; // dropped: peer table full
+        uint32_t duplicates;
+        uint32_t lost;         // sequence gaps, net of late arrivals
+        uint32_t stale;        // dropped: far out of sequence
+        uint32_t published;    // frames sent on in a batch
+        uint32_t unsent;       // frames dropped while MQTT was down
+        uint32_t batches;
+        uint32_t sent;         // downlink frames
+        uint32_t peers;
+        uint32_t online;
+        uint32_t announced;       // discovery configs published
+        uint32_t announce_queue;  // waiting for the discovery budget
+    };
+
+    /** One node's link, as seen from its sequence numbers. */
+    struct PeerStats {
+        uint8_t mac[6];
+        bool online;
+        uint32_t received;     // frames accepted
+        uint32_t duplicates;
+        uint32_t lost;         // never arrived (late arrivals are subtracted)
+        uint32_t late;         // arrived out of order, within the window
+        uint32_t stale;        // dropped: far out of sequence, and nothing followed
+        uint32_t restarts;     // seq restarted from 0, or a jump a second frame confirmed
+        int8_t rssi;           // of the latest frame
+        int64_t last_us;       // esp_timer time of the latest frame
+    };
+
+    /** Starts the transport and spawns the bridge task. */
+    EspNowBridge(std::unique_ptr<EspNowTransport> transport, const Config& cfg = Config::Default());
+
+    /** Deletes the task; the transport is stopped when it is destroyed. */
+    ~EspNowBridge();
+
+    /** Sends `len` bytes of `type` to `mac`, after a Header with our next seq. */
+    esp_err_t Send(const uint8_t* mac, uint8_t type, const uint8_t* payload, size_t len);
+
+    /** Sends one espnow_protocol.h message, e.g. a Command. */
+    template <typename M>
+    esp_err_t Send(const uint8_t* mac, const M& msg)
+    {
+        return Send(mac, static_cast<uint8_t>(espnow::Schema<M>::kType),
+                    reinterpret_cast<const uint8_t*>(&msg), sizeof(M));
+    }
+
+    /**
+     * Subscribes to the command topics and starts the discovery check;
+     * call on every MQTT connect.
+     */
+    void OnMqttConnect();
+
+    /**
+     * Feed every incoming MQTT message. Returns true if it was a command or
+     * a retained node config.
+     */
+    bool OnMqttData(const char* topic, int topic_len, const char* data, int data_len,
+                    int offset, int total_len);
+
+    Stats GetStats() const;
+
+    /** Copies up to `max` peers, in the order first heard. Returns how many. */
+    size_t GetPeers(PeerStats* out, size_t max) const;
+
+    EspNowBridge(const EspNowBridge&) = delete;
+    EspNowBridge& operator=(const EspNowBridge&) = delete;
+    EspNowBridge(EspNowBridge&&) = delete;
+    EspNowBridge& operator=(EspNowBridge&&) = delete;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
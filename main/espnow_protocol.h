@@ -0,0 +1,356 @@
+#pragma once
+
+// Frames exchanged between the gateway and its ESP-NOW nodes. Shared with
+// the node firmware: fixed layout, little-endian, no padding, header-only
+// and heap-free.
+//
+// A frame is a Header and one message. Each message is declared once, as
+// a field list below; the list generates the packed struct, its schema
+// (key, unit, wire type, offset, fixed-point scale) and, through the
+// templates at the end, the encoder and decoder. Readings are fixed
+// point: value = raw / scale, and a raw value at its type's maximum means
+// "not available" (NaN), the SEN55's own convention.
+//
+// Compatibility: fields are only ever appended, and decoders accept a
+// payload longer than they know (older gateway, newer node). Anything
+// else bumps kVersion.
+
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace espnow {
+
+static_assert(std::endian::native == std::endian::little, "wire format is little-endian");
+
+/// ESP-NOW v1 payload limit.
+inline constexpr size_t kMaxFrame = 250;
+
+inline constexpr uint8_t kVersion = 1;
+
+/// Header::type values.
+enum class MsgType : uint8_t {
+    kSen55 = 0x01,     // node → gateway
+    kPms5003 = 0x02,   // node → gateway
+    kPwm12v = 0x03,    // node → gateway
+    kCommand = 0x40,   // gateway → node
+    kAck = 0x41,       // node → gateway, for every kCommand
+};
+
+/// Types below kCommand are a node's readings.
+constexpr bool IsReading(uint8_t type)
+{
+    return type != 0 && type < static_cast<uint8_t>(MsgType::kCommand);
+}
+
+/// Starts every frame. `seq` counts up per sender from 0 at boot (and
+/// wraps); the receiver uses it to drop duplicates and count losses.
+struct [[gnu::packed]] Header {
+    uint8_t version;  // kVersion
+    uint8_t type;     // MsgType
+    uint16_t seq;
+};
+static_assert(sizeof(Header) == 4);
+
+inline constexpr size_t kMaxPayload = kMaxFrame - sizeof(Header);
+
+/// Command::op values.
+enum class Op : uint8_t {
+    kIdentify = 1,     // blink / beep; value: seconds
+    kSetInterval = 2,  // value: seconds between readings
+    kSetDuty = 3,      // PWM12V; value: duty in 0.1 %
+    kReboot = 4,
+};
+
+/// Ack::status values.
+enum class Status : uint8_t {
+    kOk = 0,
+    kUnknownOp = 1,
+    kBadValue = 2,
+    kBusy = 3,
+};
+
+/* ── Schema ──────────────────────────────────────────────────────────── */
+
+enum class Wire : uint8_t { kU8, kU16, kI16, kU32, kI32 };
+
+template <typename T>
+constexpr Wire WireOf()
+{
+    if constexpr (std::is_same_v<T, uint8_t>) return Wire::kU8;
+    else if constexpr (std::is_same_v<T, uint16_t>) return Wire::kU16;
+    else if constexpr (std::is_same_v<T, int16_t>) return Wire::kI16;
+    else if constexpr (std::is_same_v<T, uint32_t>) return Wire::kU32;
+    else {
+        static_assert(std::is_same_v<T, int32_t>, "no wire type for this field type");
+        return Wire::kI32;
+    }
+}
+
+constexpr size_t WireSize(Wire w)
+{
+    return w == Wire::kU8 ? 1 : (w == Wire::kU32 || w == Wire::kI32) ? 4 : 2;
+}
+
+/// Decimal places that show a value of this scale exactly (1/200 → 3).
+constexpr uint8_t DecimalsFor(uint16_t scale)
+{
+    uint8_t d = 0;
+    for (uint32_t p = 1; p % scale != 0 && d < 6; p *= 10) ++d;
+    return d;
+}
+
+/// One payload field.
+struct Field {
+    const char* key;
+    const char* unit;    // "" if unitless
+    Wire wire;
+    uint8_t offset;      // in the payload
+    uint16_t scale;      // value = raw / scale
+    uint8_t decimals;    // DecimalsFor(scale)
+};
+
+/// Per-message schema; specialised by ESPNOW_MESSAGE below.
+template <typename M> struct Schema;
+
+/// Payload is exactly its fields, in order, nothing between them.
+template <typename M>
+constexpr bool PacksTight()
+{
+    size_t next = 0;
+    for (const Field& f : Schema<M>::kFields) {
+        if (f.offset != next || f.scale == 0) return false;
+        next += WireSize(f.wire);
+    }
+    return next == sizeof(M) && sizeof(M) <= kMaxPayload;
+}
+
+// F(type, member, scale, unit)
+#define ESPNOW_MEMBER(type, member, scale, unit) type member;
+#define ESPNOW_FIELD(type, member, scale, unit)                                   \
+    Field{#member, unit, WireOf<type>(), static_cast<uint8_t>(offsetof(M, member)), \
+          scale, DecimalsFor(scale)},
+#define ESPNOW_MESSAGE(Name, msg_type, name, FIELDS)                             \
+    struct [[gnu::packed]] Name {                                                \
+        FIELDS(ESPNOW_MEMBER)                                                    \
+    };                                                                           \
+    template <> struct Schema<Name> {                                            \
+        using M = Name;                                                          \
+        static constexpr MsgType kType = msg_type;                               \
+        static constexpr const char* kName = name;                               \
+        static constexpr Field kFields[] = {FIELDS(ESPNOW_FIELD)};               \
+    };                                                                           \
+    static_assert(PacksTight<Name>(), #Name ": fields must be contiguous")
+
+/* ── Messages ────────────────────────────────────────────────────────── */
+
+// Sensirion SEN5x: the sensor's own Read-Measured-Values scaling, so a
+// node can forward the raw words unchanged
+#define ESPNOW_SEN55_FIELDS(F)            \
+    F(uint16_t, pm1_0, 10, "µg/m³")       \
+    F(uint16_t, pm2_5, 10, "µg/m³")       \
+    F(uint16_t, pm4_0, 10, "µg/m³")       \
+    F(uint16_t, pm10, 10, "µg/m³")        \
+    F(int16_t, humidity, 100, "%")        \
+    F(int16_t, temperature, 200, "°C")    \
+    F(int16_t, voc_index, 10, "")         \
+    F(int16_t, nox_index, 10, "")
+ESPNOW_MESSAGE(Sen55, MsgType::kSen55, "sen55", ESPNOW_SEN55_FIELDS);
+static_assert(sizeof(Sen55) == 16);
+
+// Plantower PMS5003: atmospheric mass concentrations and particle counts
+// per 0.1 L above each size
+#define ESPNOW_PMS5003_FIELDS(F)          \
+    F(uint16_t, pm1_0, 1, "µg/m³")        \
+    F(uint16_t, pm2_5, 1, "µg/m³")        \
+    F(uint16_t, pm10, 1, "µg/m³")         \
+    F(uint16_t, n0_3, 1, "/0.1L")         \
+    F(uint16_t, n0_5, 1, "/0.1L")         \
+    F(uint16_t, n1_0, 1, "/0.1L")         \
+    F(uint16_t, n2_5, 1, "/0.1L")         \
+    F(uint16_t, n5_0, 1, "/0.1L")         \
+    F(uint16_t, n10, 1, "/0.1L")
+ESPNOW_MESSAGE(Pms5003, MsgType::kPms5003, "pms5003", ESPNOW_PMS5003_FIELDS);
+static_assert(sizeof(Pms5003) == 18);
+
+// 12 V PWM output (fan or LED strip) with its supply and load
+#define ESPNOW_PWM12V_FIELDS(F)           \
+    F(uint16_t, duty, 10, "%")            \
+    F(uint16_t, rpm, 1, "rpm")            \
+    F(uint16_t, supply, 1000, "V")        \
+    F(uint16_t, current, 1000, "A")       \
+    F(int16_t, temperature, 100, "°C")
+ESPNOW_MESSAGE(Pwm12v, MsgType::kPwm12v, "pwm12v", ESPNOW_PWM12V_FIELDS);
+static_assert(sizeof(Pwm12v) == 10);
+
+// `tag` is chosen by the gateway and echoed in the Ack
+#define ESPNOW_COMMAND_FIELDS(F)          \
+    F(uint8_t, op, 1, "")                 \
+    F(uint16_t, tag, 1, "")               \
+    F(int32_t, value, 1, "")
+ESPNOW_MESSAGE(Command, MsgType::kCommand, "command", ESPNOW_COMMAND_FIELDS);
+static_assert(sizeof(Command) == 7);
+
+#define ESPNOW_ACK_FIELDS(F)              \
+    F(uint16_t, tag, 1, "")               \
+    F(uint8_t, op, 1, "")                 \
+    F(uint8_t, status, 1, "")
+ESPNOW_MESSAGE(Ack, MsgType::kAck, "ack", ESPNOW_ACK_FIELDS);
+static_assert(sizeof(Ack) == 4);
+
+#undef ESPNOW_MESSAGE
+#undef ESPNOW_FIELD
+#undef ESPNOW_MEMBER
+
+/// Every message, for dispatch by type.
+using Messages = std::tuple<Sen55, Pms5003, Pwm12v, Command, Ack>;
+
+/* ── Codec ───────────────────────────────────────────────────────────── */
+
+namespace detail {
+
+template <Wire W> struct WireType;
+template <> struct WireType<Wire::kU8> { using type = uint8_t; };
+template <> struct WireType<Wire::kU16> { using type = uint16_t; };
+template <> struct WireType<Wire::kI16> { using type = int16_t; };
+template <> struct WireType<Wire::kU32> { using type = uint32_t; };
+template <> struct WireType<Wire::kI32> { using type = int32_t; };
+
+/// Rounds to fixed point, saturating below the "not available" value.
+template <typename T>
+T ToRaw(float value, uint16_t scale)
+{
+    constexpr double kMax = static_cast<double>(std::numeric_limits<T>::max()) - 1;
+    constexpr double kMin = static_cast<double>(std::numeric_limits<T>::min());
+    if (std::isnan(value)) return std::numeric_limits<T>::max();
+    const double raw = std::round(static_cast<double>(value) * scale);
+    return static_cast<T>(raw > kMax ? kMax : raw < kMin ? kMin : raw);
+}
+
+template <typename T>
+float FromRaw(T raw, uint16_t scale)
+{
+    if (raw == std::numeric_limits<T>::max()) return NAN;
+    return static_cast<float>(static_cast<double>(raw) / scale);
+}
+
+template <typename Tuple, typename Fn, size_t... I>
+bool AnyOf(Fn&& fn, std::index_sequence<I...>)
+{
+    return (fn(static_cast<std::tuple_element_t<I, Tuple>*>(nullptr)) || ...);
+}
+
+} // namespace detail
+
+/// Number of fields of message M.
+template <typename M>
+inline constexpr size_t kFieldCount = std::size(Schema<M>::kFields);
+
+/// M from engineering values, one per field in schema order (NaN: n/a).
+template <typename M>
+M FromValues(const float (&values)[kFieldCount<M>])
+{
+    M msg;
+    auto* out = reinterpret_cast<uint8_t*>(&msg);
+    [&]<size_t... I>(std::index_sequence<I...>) {
+        ((
+            [&] {
+                constexpr Field f = Schema<M>::kFields[I];
+                using T = typename detail::WireType<f.wire>::type;
+                const T raw = detail::ToRaw<T>(values[I], f.scale);
+                std::memcpy(out + f.offset, &raw, sizeof(T));
+            }()),
+         ...);
+    }(std::make_index_sequence<kFieldCount<M>>{});
+    return msg;
+}
+
+/// Header and `msg` into `frame` (at least sizeof(Header) + sizeof(M)
+/// bytes). Returns the frame length.
+template <typename M>
+size_t Encode(const M& msg, uint16_t seq, uint8_t* frame)
+{
+    const Header h{
+        .version = kVersion,
+        .type = static_cast<uint8_t>(Schema<M>::kType),
+        .seq = seq,
+    };
+    std::memcpy(frame, &h, sizeof(h));
+    std::memcpy(frame + sizeof(h), &msg, sizeof(M));
+    return sizeof(h) + sizeof(M);
+}
+
+/// Calls sink(const Field&, float value) for each field of an M payload.
+/// False, with no calls, if the payload is too short.
+template <typename M, typename Sink>
+bool DecodeAs(const uint8_t* payload, size_t len, Sink&& sink)
+{
+    if (len < sizeof(M)) return false;
+    [&]<size_t... I>(std::index_sequence<I...>) {
+        ((
+            [&] {
+                constexpr Field f = Schema<M>::kFields[I];
+                using T = typename detail::WireType<f.wire>::type;
+                T raw;
+                std::memcpy(&raw, payload + f.offset, sizeof(T));
+                sink(f, detail::FromRaw(raw, f.scale));
+            }()),
+         ...);
+    }(std::make_index_sequence<kFieldCount<M>>{});
+    return true;
+}
+
+/// DecodeAs() for whichever message `type` is. Returns the message name,
+/// or nullptr for an unknown type or a short payload.
+template <typename Sink>
+const char* Decode(uint8_t type, const uint8_t* payload, size_t len, Sink&& sink)
+{
+    const char* name = nullptr;
+    detail::AnyOf<Messages>(
+        [&]<typename M>(M*) {
+            if (type != static_cast<uint8_t>(Schema<M>::kType)) return false;
+            if (DecodeAs<M>(payload, len, sink)) name = Schema<M>::kName;
+            return true;
+        },
+        std::make_index_sequence<std::tuple_size_v<Messages>>{});
+    return name;
+}
+
+/// The MsgType named `name` ("sen55", "command", …); false if none.
+inline bool TypeFromName(std::string_view name, uint8_t* type)
+{
+    return detail::AnyOf<Messages>(
+        [&]<typename M>(M*) {
+            if (name != Schema<M>::kName) return false;
+            *type = static_cast<uint8_t>(Schema<M>::kType);
+            return true;
+        },
+        std::make_index_sequence<std::tuple_size_v<Messages>>{});
+}
+
+/// Fields of message `type` at run time (`*fields`, `*count`). Returns
+/// the message name, nullptr for an unknown type.
+inline const char* FieldsOf(uint8_t type, const Field** fields, size_t* count)
+{
+    const char* name = nullptr;
+    detail::AnyOf<Messages>(
+        [&]<typename M>(M*) {
+            if (type != static_cast<uint8_t>(Schema<M>::kType)) return false;
+            *fields = Schema<M>::kFields;
+            *count = kFieldCount<M>;
+            name = Schema<M>::kName;
+            return true;
+        },
+        std::make_index_sequence<std::tuple_size_v<Messages>>{});
+    return name;
+}
+
+} // namespace espnow
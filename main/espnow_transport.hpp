@@ -0,0 +1,32 @@
+#pragma once
+
+#include "esp_err.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Radio link to the ESP-NOW nodes. On the board this is the IDF esp_now
+ * driver on the Wi-Fi STA interface; host builds plug in a loopback.
+ */
+class EspNowTransport {
+public:
+    /**
+     * Receives one frame from `mac`. On the board this runs in the Wi-Fi
+     * task: copy the frame and return.
+     */
+    using RecvFn = void (*)(void* ctx, const uint8_t* mac, const uint8_t* data, size_t len,
+                            int8_t rssi);
+
+    virtual ~EspNowTransport() = default;
+
+    /** Starts delivering received frames to `fn`. */
+    virtual esp_err_t Start(RecvFn fn, void* ctx) = 0;
+
+    /** Queues one unicast frame to `mac`. */
+    virtual esp_err_t Send(const uint8_t* mac, const uint8_t* data, size_t len) = 0;
+};
+
+/** esp_now on the Wi-Fi STA interface, on the AP's channel. Start Wi-Fi first. */
+std::unique_ptr<EspNowTransport> MakeEspNowWifiTransport();
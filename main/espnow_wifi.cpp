@@ -0,0 +1,90 @@
+#include "espnow_transport.hpp"
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_now.h"
+#include "esp_wifi.h"
+
+#include <cstring>
+
+static const char* TAG = "espnow";
+
+namespace {
+
+class WifiTransport final : public EspNowTransport {
+public:
+    ~WifiTransport() override
+    {
+        esp_now_unregister_recv_cb();
+        esp_now_deinit();
+        s_instance = nullptr;
+    }
+
+    esp_err_t Start(RecvFn fn, void* ctx) override
+    {
+        fn_ = fn;
+        ctx_ = ctx;
+        s_instance = this;
+        // Modem sleep (the STA default) keeps the radio off between DTIM
+        // beacons, and nodes' frames sent meanwhile are simply lost
+        ESP_RETURN_ON_ERROR(esp_wifi_set_ps(WIFI_PS_NONE), TAG, "disable power save");
+        ESP_RETURN_ON_ERROR(esp_now_init(), TAG, "esp_now_init");
+        ESP_RETURN_ON_ERROR(esp_now_register_recv_cb(OnRecv), TAG, "register recv");
+        ESP_LOGI(TAG, "Listening");
+        return ESP_OK;
+    }
+
+    esp_err_t Send(const uint8_t* mac, const uint8_t* data, size_t len) override
+    {
+        if (!esp_now_is_peer_exist(mac)) {
+            ESP_RETURN_ON_ERROR(AddPeer(mac), TAG, "add peer");
+        }
+        return esp_now_send(mac, data, len);
+    }
+
+private:
+    // esp_now callbacks carry no context; there is one radio
+    static inline WifiTransport* s_instance{};
+
+    static void OnRecv(const esp_now_recv_info_t* info, const uint8_t* data, int len)
+    {
+        auto* self = s_instance;
+        if (!self || len <= 0) return;
+        self->fn_(self->ctx_, info->src_addr, data, static_cast<size_t>(len),
+                  static_cast<int8_t>(info->rx_ctrl->rssi));
+    }
+
+    /**
+     * Receiving needs no peer entry, only sending does. The driver holds
+     * a few (ESP_NOW_MAX_TOTAL_PEER_NUM), so with more nodes than that the
+     * oldest entry makes room.
+     */
+    static esp_err_t AddPeer(const uint8_t* mac)
+    {
+        esp_now_peer_info_t peer{};
+        std::memcpy(peer.peer_addr, mac, ESP_NOW_ETH_ALEN);
+        peer.channel = 0;  // the STA's current channel
+        peer.ifidx = WIFI_IF_STA;
+        peer.encrypt = false;
+
+        esp_err_t err = esp_now_add_peer(&peer);
+        if (err == ESP_ERR_ESPNOW_FULL) {
+            esp_now_peer_info_t oldest{};
+            if (esp_now_fetch_peer(true, &oldest) == ESP_OK) {
+                esp_now_del_peer(oldest.peer_addr);
+            }
+            err = esp_now_add_peer(&peer);
+        }
+        return err;
+    }
+
+    RecvFn fn_{};
+    void* ctx_{};
+};
+
+} // namespace
+
+std::unique_ptr<EspNowTransport> MakeEspNowWifiTransport()
+{
+    return std::make_unique<WifiTransport>();
+}
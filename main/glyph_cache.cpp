@@ -0,0 +1,240 @@
+#include "glyph_cache.hpp"
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+
+static const char* TAG = "glyph_cache";
+
+namespace {
+
+constexpr size_t kAscii = 128;
+constexpr int16_t kNotCached = -1;
+
+size_t AlignUp(size_t n)
+{
+    return (n + LV_DRAW_BUF_ALIGN - 1) / LV_DRAW_BUF_ALIGN * LV_DRAW_BUF_ALIGN;
+}
+
+void* AllocPsram(size_t bytes)
+{
+    void* p = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    if (!p) {
+        ESP_LOGW(TAG, "No PSRAM for %u bytes, using internal RAM",
+                 static_cast<unsigned>(bytes));
+        p = heap_caps_malloc(bytes, MALLOC_CAP_DEFAULT);
+    }
+    assert(p);
+    return p;
+}
+
+} // namespace
+
+/* ── GlyphCache ──────────────────────────────────────────────────────── */
+
+struct GlyphCache::Impl {
+    size_t backgrounds{};
+    std::array<int16_t, kAscii> slot{};    // char → glyph index
+    std::vector<lv_image_dsc_t> sprites;   // [glyph * backgrounds + bg]
+    uint8_t* pixels{};
+    Stats stats{};
+};
+
+GlyphCache::GlyphCache(const lv_font_t* font, lv_color_t color,
+                       std::span<const lv_color_t> backgrounds, std::string_view charset)
+    : impl_(std::make_unique<Impl>())
+{
+    auto& d = *impl_;
+    const int64_t t0 = esp_timer_get_time();
+    d.backgrounds = backgrounds.size();
+    d.slot.fill(kNotCached);
+
+    std::vector<char> glyphs;
+    for (char c : charset) {
+        const auto u = static_cast<unsigned char>(c);
+        if (u < 0x20 || u >= 0x7F || d.slot[u] != kNotCached) continue;
+        d.slot[u] = static_cast<int16_t>(glyphs.size());
+        glyphs.push_back(c);
+    }
+
+    // Lay out every sprite in one allocation, each aligned for LVGL
+    const auto height = static_cast<uint32_t>(lv_font_get_line_height(font));
+    d.sprites.resize(glyphs.size() * d.backgrounds);
+    std::vector<size_t> offsets(d.sprites.size());
+    size_t bytes = 0;
+    for (size_t g = 0; g < glyphs.size(); ++g) {
+        const uint32_t w = std::max<uint32_t>(
+            lv_font_get_glyph_width(font, static_cast<unsigned char>(glyphs[g]), 0), 1);
+        const uint32_t stride = lv_draw_buf_width_to_stride(w, LV_COLOR_FORMAT_RGB565);
+        for (size_t bg = 0; bg < d.backgrounds; ++bg) {
+            auto& s = d.sprites[g * d.backgrounds + bg];
+            s = {};
+            s.header.magic = LV_IMAGE_HEADER_MAGIC;
+            s.header.cf = LV_COLOR_FORMAT_RGB565;
+            s.header.w = w;
+            s.header.h = height;
+            s.header.stride = stride;
+            s.data_size = stride * height;
+            offsets[g * d.backgrounds + bg] = bytes;
+            bytes += AlignUp(s.data_size);
+        }
+    }
+    d.pixels = static_cast<uint8_t*>(AllocPsram(bytes + LV_DRAW_BUF_ALIGN));
+    auto* base = reinterpret_cast<uint8_t*>(AlignUp(reinterpret_cast<uintptr_t>(d.pixels)));
+
+    // Render: fill the card colour, draw the glyph over it
+    auto* scratch = lv_obj_create(nullptr);
+    auto* canvas = lv_canvas_create(scratch);
+    for (size_t g = 0; g < glyphs.size(); ++g) {
+        const char text[2] = {glyphs[g], '\0'};
+        for (size_t bg = 0; bg < d.backgrounds; ++bg) {
+            auto& s = d.sprites[g * d.backgrounds + bg];
+            auto* px = base + offsets[g * d.backgrounds + bg];
+            s.data = px;
+
+            const auto w = static_cast<int32_t>(s.header.w);
+            const auto h = static_cast<int32_t>(s.header.h);
+            lv_canvas_set_buffer(canvas, px, w, h, LV_COLOR_FORMAT_RGB565);
+            lv_canvas_fill_bg(canvas, backgrounds[bg], LV_OPA_COVER);
+
+            lv_layer_t layer;
+            lv_canvas_init_layer(canvas, &layer);
+            lv_draw_label_dsc_t dsc;
+            lv_draw_label_dsc_init(&dsc);
+            dsc.font = font;
+            dsc.color = color;
+            dsc.text = text;
+            const lv_area_t area = {0, 0, w - 1, h - 1};
+            lv_draw_label(&layer, &dsc, &area);
+            lv_canvas_finish_layer(canvas, &layer);
+        }
+    }
+    lv_obj_delete(scratch);
+
+    d.stats = {
+        .glyphs = static_cast<uint32_t>(glyphs.size()),
+        .sprites = static_cast<uint32_t>(d.sprites.size()),
+        .bytes = static_cast<uint32_t>(bytes),
+        .render_us = esp_timer_get_time() - t0,
+    };
+    ESP_LOGI(TAG, "%u glyphs x %u backgrounds, %u KiB, built in %ld us",
+             static_cast<unsigned>(d.stats.glyphs), static_cast<unsigned>(d.backgrounds),
+             static_cast<unsigned>(bytes / 1024), static_cast<long>(d.stats.render_us));
+}
+
+GlyphCache::~GlyphCache()
+{
+    heap_caps_free(impl_->pixels);
+}
+
+const lv_image_dsc_t* GlyphCache::Get(char c, size_t bg) const
+{
+    const auto& d = *impl_;
+    const auto u = static_cast<unsigned char>(c);
+    if (u >= kAscii || d.slot[u] == kNotCached || bg >= d.backgrounds) return nullptr;
+    return &d.sprites[d.slot[u] * d.backgrounds + bg];
+}
+
+bool GlyphCache::Covers(std::string_view text) const
+{
+    return std::all_of(text.begin(), text.end(), [this](char c) {
+        const auto u = static_cast<unsigned char>(c);
+        return u < kAscii && impl_->slot[u] != kNotCached;
+    });
+}
+
+GlyphCache::Stats GlyphCache::GetStats() const
+{
+    return impl_->stats;
+}
+
+/* ── GlyphText ───────────────────────────────────────────────────────── */
+
+void GlyphText::Create(lv_obj_t* parent, const GlyphCache* cache, size_t max_chars)
+{
+    cache_ = cache;
+    label_ = lv_label_create(parent);
+    if (!cache_) return;
+
+    row_ = lv_obj_create(parent);
+    lv_obj_remove_style_all(row_);  // no background, border or padding
+    lv_obj_set_size(row_, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
+    lv_obj_set_flex_flow(row_, LV_FLEX_FLOW_ROW);
+    lv_obj_clear_flag(row_, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(row_, LV_OBJ_FLAG_HIDDEN);
+
+    images_.resize(max_chars);
+    shown_.assign(max_chars, nullptr);
+    for (auto& img : images_) {
+        img = lv_image_create(row_);
+        lv_obj_add_flag(img, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+bool GlyphText::SetText(const char* text, size_t bg)
+{
+    changed_px_ = 0;
+    const std::string_view sv(text);
+    if (cache_ && sv.size() <= images_.size() && cache_->Covers(sv)) {
+        if (!row_active_) {
+            AddArea(label_);
+            UseRow(true);
+        }
+        ShowSprites(sv, bg);
+        return changed_px_ != 0;
+    }
+
+    if (!row_active_ && std::strcmp(lv_label_get_text(label_), text) == 0) return false;
+    lv_label_set_text(label_, text);
+    if (row_active_) UseRow(false);
+    AddArea(label_);
+    return true;
+}
+
+void GlyphText::ShowSprites(std::string_view text, size_t bg)
+{
+    uint32_t old_w = 0, new_w = 0, h = 0, swapped_px = 0;
+    for (size_t i = 0; i < images_.size(); ++i) {
+        const auto* src = i < text.size() ? cache_->Get(text[i], bg) : nullptr;
+        const uint32_t was_w = shown_[i] ? shown_[i]->header.w : 0u;
+        const uint32_t w = src ? src->header.w : 0u;
+        old_w += was_w;
+        new_w += w;
+        for (const auto* sprite : {src, shown_[i]}) {
+            if (sprite) h = std::max<uint32_t>(h, sprite->header.h);
+        }
+        if (src == shown_[i]) continue;
+        // A sprite swap redraws the larger of the old and new glyph boxes
+        const auto* box = src ? src : shown_[i];
+        swapped_px += std::max(w, was_w) * box->header.h;
+        if (src) {
+            lv_image_set_src(images_[i], src);
+            if (!shown_[i]) lv_obj_remove_flag(images_[i], LV_OBJ_FLAG_HIDDEN);
+        } else {
+            lv_obj_add_flag(images_[i], LV_OBJ_FLAG_HIDDEN);
+        }
+        shown_[i] = src;
+    }
+    // A new width reflows the row, and its parent re-centres it: every
+    // sprite moves, so the old and new row bounds are redrawn whole
+    changed_px_ += old_w == new_w ? swapped_px : std::max(old_w, new_w) * h;
+}
+
+void GlyphText::UseRow(bool row)
+{
+    row_active_ = row;
+    lv_obj_add_flag(row ? label_ : row_, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_remove_flag(row ? row_ : label_, LV_OBJ_FLAG_HIDDEN);
+}
+
+void GlyphText::AddArea(const lv_obj_t* obj)
+{
+    lv_area_t area;
+    lv_obj_get_coords(obj, &area);
+    changed_px_ += lv_area_get_size(&area);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "lvgl.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/**
+ * Glyphs of one font pre-rendered as RGB565 sprites, once per background
+ * colour they will be shown on.
+ *
+ * Drawing a label rasterises every anti-aliased glyph from the font data
+ * (in flash, read through the PSRAM cache) and blends it onto the
+ * background, on every change. A sprite is the finished pixels: LVGL
+ * draws it as a plain opaque image copy. The sprites are rendered at boot
+ * through an LVGL canvas, so they match what a label would have drawn,
+ * kerning aside.
+ *
+ * Built once with the LVGL lock held; read-only afterwards.
+ */
+class GlyphCache {
+public:
+    struct Stats {
+        uint32_t glyphs;      // characters cached
+        uint32_t sprites;     // glyphs x backgrounds
+        uint32_t bytes;       // sprite pixels
+        int64_t render_us;    // time to build
+    };
+
+    /**
+     * Renders each printable ASCII character of `charset` in `font` and
+     * `color` on each of `backgrounds`, into PSRAM (internal RAM if there
+     * is none).
+     */
+    GlyphCache(const lv_font_t* font, lv_color_t color,
+               std::span<const lv_color_t> backgrounds, std::string_view charset);
+    ~GlyphCache();
+
+    /** Sprite of `c` on background `bg`; nullptr if `c` is not cached. */
+    const lv_image_dsc_t* Get(char c, size_t bg) const;
+
+    /** Whether every character of `text` is cached. */
+    bool Covers(std::string_view text) const;
+
+    Stats GetStats() const;
+
+    GlyphCache(const GlyphCache&) = delete;
+    GlyphCache& operator=(const GlyphCache&) = delete;
+    GlyphCache(GlyphCache&&) = delete;
+    GlyphCache& operator=(GlyphCache&&) = delete;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * A line of text shown as a row of GlyphCache sprites, one image per
+ * character, falling back to a plain label when the text has a character
+ * the cache lacks (or there is no cache). Only the characters that change
+ * are redrawn.
+ *
+ * Creates two sibling objects in the parent: style and place Label() as
+ * the text would be, and Row() to match; only one is visible at a time.
+ */
+class GlyphText {
+public:
+    /** `cache` may be null: label only. Text longer than `max_chars` uses the label. */
+    void Create(lv_obj_t* parent, const GlyphCache* cache, size_t max_chars);
+
+    /**
+     * Shows `text`, as sprites on cache background `bg` where possible.
+     * Returns false if nothing changed.
+     */
+    bool SetText(const char* text, size_t bg);
+
+    /**
+     * Pixels the last SetText() invalidated: changed sprites, the whole row
+     * if its width changed, or the label.
+     */
+    uint32_t ChangedPx() const { return changed_px_; }
+
+    lv_obj_t* Label() const { return label_; }
+    lv_obj_t* Row() const { return row_; }
+
+private:
+    void ShowSprites(std::string_view text, size_t bg);
+    void UseRow(bool row);
+    void AddArea(const lv_obj_t* obj);
+
+    const GlyphCache* cache_{};
+    lv_obj_t* label_{};
+    lv_obj_t* row_{};
+    bool row_active_{};
+    uint32_t changed_px_{};
+    std::vector<lv_obj_t*> images_;
+    std::vector<const lv_image_dsc_t*> shown_;  // per image, nullptr: hidden
+};
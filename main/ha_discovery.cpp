@@ -1,100 +1,564 @@
 #include "ha_discovery.hpp"
+#include "boot_profile.hpp"
+#include "espnow_protocol.h"
 #include "mqtt.hpp"
+#include "sen55_metrics.hpp"
+#include "sen55_mqtt.hpp"
 
+#include <atomic>
+#include <cctype>
 #include <cstdio>
-#include "cJSON.h"
+#include <cstring>
+
+#include "sdkconfig.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 namespace {
 
 const char *TAG = "ha_disc";
 
-struct SensorDef {
-    const char *entity;        // suffix for topic + unique_id
-    const char *name;          // human-readable
-    const char *device_class;  // HA device_class (nullptr if none)
-    const char *unit;          // unit_of_measurement (nullptr if none)
+/// Device health, shown under "Diagnostic" in HA. The state is picked out
+/// of a JSON document; with `attributes`, all of it is also shown as the
+/// entity's attributes.
+struct DiagnosticDef {
+    const char *entity;
+    const char *name;
+    const char *device_class;  // nullptr if none
+    const char *unit;          // nullptr if none
+    const char *state_class;   // nullptr if none
+    const char *value_template;
+    bool attributes;
+};
+
+constexpr DiagnosticDef kBootTime =
+    {"boot_time", "Boot time", "duration", "ms", nullptr,
+     "{{ value_json.total_ms }}", true};
+constexpr DiagnosticDef kPublishLatency =
+    {"publish_latency", "Publish latency p99", "duration", "ms", "measurement",
+     "{{ value_json.publish.p99_ms | default(none) }}", true};
+
+// All from one message on aqm/<device_id>/telemetry (see telemetry.hpp)
+constexpr DiagnosticDef kTelemetry[] = {
+    {"heap_free",     "Free heap",           "data_size", "B", "measurement",
+     "{{ value_json.heap.free }}", false},
+    {"heap_min_free", "Free heap low-water", "data_size", "B", "measurement",
+     "{{ value_json.heap.min }}", false},
+    {"heap_frag",     "Heap fragmentation",  nullptr,     "%", "measurement",
+     "{{ value_json.heap.frag }}", false},
+    {"psram_free",    "Free PSRAM",          "data_size", "B", "measurement",
+     "{{ value_json.psram.free }}", false},
+    {"cpu_core0",     "CPU load core 0",     nullptr,     "%", "measurement",
+     "{{ value_json.cpu.core0 | default(none) }}", true},
+    {"cpu_core1",     "CPU load core 1",     nullptr,     "%", "measurement",
+     "{{ value_json.cpu.core1 | default(none) }}", false},
+    {"stack_min",     "Min stack headroom",  "data_size", "B", "measurement",
+     "{{ value_json.stack_min.free | default(none) }}", false},
+    {"bus_errors",    "Sensor bus errors",   nullptr,     nullptr, "total_increasing",
+     "{{ (value_json.sensor.i2c_errors + value_json.sensor.crc_errors)"
+     " if value_json.sensor is defined else none }}", false},
+    {"mqtt_outbox",   "MQTT outbox",         "data_size", "B", "measurement",
+     "{{ value_json.mqtt_outbox }}", false},
+    {"backlog",       "Offline backlog",     nullptr,     "readings", "measurement",
+     "{{ value_json.backlog }}", false},
+    {"wifi_disconnects", "Wi-Fi disconnects", nullptr,    nullptr, "total_increasing",
+     "{{ value_json.wifi_disconnects }}", false},
+};
+
+#if CONFIG_AQM_ZERO_HEAP
+constexpr DiagnosticDef kFirmwareAllocs =
+    {"heap_allocs", "Heap allocations after boot", nullptr, nullptr, "total_increasing",
+     "{{ value_json.allocs.firmware | default(none) }}", true};
+#endif
+
+#if CONFIG_AQM_HA_DEVICE_DISCOVERY
+HaDiscoveryMode s_mode = HaDiscoveryMode::kDevice;
+#else
+HaDiscoveryMode s_mode = HaDiscoveryMode::kEntity;
+#endif
+
+constexpr uint32_t kCheckMs = CONFIG_AQM_HA_DISCOVERY_CHECK_MS;
+
+/* ── Entities ───────────────────────────────────────────────────────── */
+
+/// Where an entity's state comes from.
+enum class StateSource : uint8_t {
+    kJsonField,  // its own field of the SEN55 JSON state
+    kPerTopic,   // its own plain-value topic
+    kDocument,   // value_template over a JSON document on `topic`
+};
+
+/// One entity, whichever table it came from.
+struct Entity {
+    const char *entity;
+    const char *name;
+    const char *device_class;
+    const char *unit;
+    const char *state_class;
+    StateSource source;
+    const char *topic;           // kJsonField, kDocument
+    const char *value_template;  // kDocument
+    bool attributes;
+    bool diagnostic;
+};
+
+constexpr size_t kMaxEntities = 24;
+
+Entity diagnostic(const DiagnosticDef &d, const char *topic)
+{
+    return {d.entity, d.name, d.device_class, d.unit, d.state_class,
+            StateSource::kDocument, topic, d.value_template, d.attributes, true};
+}
+
+/// Every entity this device announces, SEN55 channels first.
+size_t collect_entities(const char *device_id, Entity (&out)[kMaxEntities])
+{
+    static char telemetry_topic[48];
+    std::snprintf(telemetry_topic, sizeof(telemetry_topic), "aqm/%s/telemetry", device_id);
+
+    size_t n = 0;
+    const bool json = sen55_mqtt_format() == Sen55MqttFormat::kJson;
+    for (const auto &s : sen55_metrics::kMetrics) {
+        out[n++] = {s.key, s.name, s.device_class, s.unit, "measurement",
+                    json ? StateSource::kJsonField : StateSource::kPerTopic,
+                    json ? sen55_mqtt_state_topic() : nullptr, nullptr, false, false};
+    }
+    out[n++] = diagnostic(kBootTime, boot_profile_topic());
+    if (CONFIG_AQM_LATENCY_REPORT_S > 0) {
+        out[n++] = diagnostic(kPublishLatency, sen55_mqtt_latency_topic());
+    }
+#if CONFIG_AQM_TELEMETRY
+    for (const auto &d : kTelemetry) {
+        out[n++] = diagnostic(d, telemetry_topic);
+    }
+#if CONFIG_AQM_ZERO_HEAP
+    out[n++] = diagnostic(kFirmwareAllocs, telemetry_topic);
+#endif
+#endif
+    return n;
+}
+
+/* ── Payloads ───────────────────────────────────────────────────────── */
+
+/// JSON written straight into a fixed buffer. Every value is ours (entity
+/// tables, device id, topics) and none needs escaping, so no JSON library
+/// (and no heap) is involved.
+class JsonWriter {
+public:
+    JsonWriter(char *buf, size_t size) : buf_(buf), size_(size) {}
+
+    template <typename... Args>
+    void Put(const char *fmt, Args... args)
+    {
+        if (len_ < size_) len_ += std::snprintf(buf_ + len_, size_ - len_, fmt, args...);
+    }
+
+    /** Adds ,"key":"value"; skipped when `value` is null. */
+    void Add(const char *key, const char *value)
+    {
+        if (value) Put(",\"%s\":\"%s\"", key, value);
+    }
+
+    bool Ok() const { return len_ < size_; }
+    size_t Length() const { return len_; }
+
+private:
+    char *buf_;
+    size_t size_;
+    size_t len_ = 0;
 };
 
-constexpr SensorDef kSen55Sensors[] = {
-    {"pm1_0",    "PM1.0",       "pm1",         "µg/m³"},
-    {"pm2_5",    "PM2.5",       "pm25",        "µg/m³"},
-    {"pm4_0",    "PM4.0",       nullptr,       "µg/m³"},
-    {"pm10",     "PM10",        "pm10",        "µg/m³"},
-    {"temp",     "Temperature", "temperature", "°C"},
-    {"humidity", "Humidity",    "humidity",    "%"},
-    {"voc",      "VOC Index",   "volatile_organic_compounds_part", nullptr},
-    {"nox",      "NOx Index",   nullptr,       nullptr},
+// Keys use HA's abbreviations (avty_t, stat_t, ...): the same config in
+// roughly two thirds of the bytes.
+void write_device_block(JsonWriter &w, const char *device_id)
+{
+    w.Put("\"dev\":{\"ids\":[\"%s\"],\"name\":\"SEN55 %s\",\"mdl\":\"SEN55\","
+          "\"mf\":\"haynes\",\"sw\":\"1.0.0\"}",
+          device_id, device_id);
+}
+
+/// The entity's own fields, from "name" on. `shared_state_topic` is one
+/// the enclosing device config already sets.
+void write_entity(JsonWriter &w, const char *device_id, const Entity &e,
+                  const char *shared_state_topic)
+{
+    w.Put("\"name\":\"%s\"", e.name);
+    w.Put(",\"uniq_id\":\"sensor_%s_%s\"", device_id, e.entity);
+    w.Put(",\"obj_id\":\"sensor_%s_%s\"", device_id, e.entity);
+
+    switch (e.source) {
+    case StateSource::kJsonField:
+        if (e.topic != shared_state_topic) w.Add("stat_t", e.topic);
+        w.Put(",\"val_tpl\":\"{{ value_json.%s }}\"", e.entity);
+        break;
+    case StateSource::kPerTopic:
+        w.Put(",\"stat_t\":\"aqm/%s/sensor/%s\"", device_id, e.entity);
+        break;
+    case StateSource::kDocument:
+        w.Add("stat_t", e.topic);
+        w.Add("val_tpl", e.value_template);
+        if (e.attributes) w.Add("json_attr_t", e.topic);
+        break;
+    }
+
+    if (e.diagnostic) w.Add("ent_cat", "diagnostic");
+    w.Add("dev_cla", e.device_class);
+    w.Add("unit_of_meas", e.unit);
+    w.Add("stat_cla", e.state_class);
+}
+
+/// homeassistant/sensor/<device_id>/<entity>/config
+void write_entity_config(JsonWriter &w, const char *device_id, const Entity &e)
+{
+    w.Put("{");
+    write_entity(w, device_id, e, nullptr);
+    w.Put(",\"avty_t\":\"aqm/%s/availability\",", device_id);
+    write_device_block(w, device_id);
+    w.Put("}");
+}
+
+/// homeassistant/device/<device_id>/config: every entity as a component.
+/// The availability and, in JSON format, the state topic are shared.
+void write_device_config(JsonWriter &w, const char *device_id,
+                         const Entity *entities, size_t n)
+{
+    const char *shared_state_topic =
+        sen55_mqtt_format() == Sen55MqttFormat::kJson ? sen55_mqtt_state_topic() : nullptr;
+
+    w.Put("{");
+    write_device_block(w, device_id);
+    w.Put(",\"o\":{\"name\":\"cyd-aqm\",\"sw\":\"1.0.0\"}");
+    w.Put(",\"avty_t\":\"aqm/%s/availability\"", device_id);
+    w.Add("stat_t", shared_state_topic);
+    w.Put(",\"cmps\":{");
+    for (size_t i = 0; i < n; ++i) {
+        w.Put("%s\"%s\":{\"p\":\"sensor\",", i ? "," : "", entities[i].entity);
+        write_entity(w, device_id, entities[i], shared_state_topic);
+        w.Put("}");
+    }
+    w.Put("}}");
+}
+
+/* ── ESP-NOW nodes ──────────────────────────────────────────────────── */
+
+/// Names and device classes for espnow_protocol.h field keys; other
+/// fields are announced under their key, without a class.
+struct NodeSensorDef {
+    const char *key;
+    const char *name;
+    const char *device_class;
+};
+
+constexpr NodeSensorDef kNodeSensors[] = {
+    {"pm1_0",       "PM1.0",       "pm1"},
+    {"pm2_5",       "PM2.5",       "pm25"},
+    {"pm4_0",       "PM4.0",       nullptr},
+    {"pm10",        "PM10",        "pm10"},
+    {"temperature", "Temperature", "temperature"},
+    {"humidity",    "Humidity",    "humidity"},
+    {"voc_index",   "VOC Index",   "volatile_organic_compounds_part"},
+    {"nox_index",   "NOx Index",   nullptr},
+    {"duty",        "Duty cycle",  nullptr},
+    {"rpm",         "Fan speed",   nullptr},
+    {"supply",      "Supply",      "voltage"},
+    {"current",     "Current",     "current"},
 };
 
-cJSON *make_device_block(const char *device_id)
+const NodeSensorDef *node_sensor(const char *key)
 {
-    cJSON *dev = cJSON_CreateObject();
-    cJSON *ids = cJSON_CreateArray();
-    cJSON_AddItemToArray(ids, cJSON_CreateString(device_id));
-    cJSON_AddItemToObject(dev, "identifiers", ids);
+    for (const auto &s : kNodeSensors) {
+        if (std::strcmp(s.key, key) == 0) return &s;
+    }
+    return nullptr;
+}
 
-    char name[32];
-    std::snprintf(name, sizeof(name), "SEN55 %s", device_id);
-    cJSON_AddStringToObject(dev, "name", name);
-    cJSON_AddStringToObject(dev, "model", "SEN55");
-    cJSON_AddStringToObject(dev, "manufacturer", "haynes");
-    cJSON_AddStringToObject(dev, "sw_version", "1.0.0");
+/// The node's device (via this gateway), its availability and the shared
+/// state topic, then a component per field. Each value template picks the
+/// node's latest frame out of a batch and keeps the state when the batch
+/// has none.
+void write_node_config(JsonWriter &w, const char *device_id, const char *mac,
+                       const char *model, const espnow::Field *fields, size_t n)
+{
+    char mdl[16];
+    size_t i = 0;
+    for (; model[i] && i + 1 < sizeof(mdl); ++i) {
+        mdl[i] = static_cast<char>(std::toupper(static_cast<unsigned char>(model[i])));
+    }
+    mdl[i] = '\0';
 
-    return dev;
+    w.Put("{\"dev\":{\"ids\":[\"%s_%s\"],\"name\":\"%s %s\",\"mdl\":\"%s\","
+          "\"via_device\":\"%s\"}",
+          device_id, mac, mdl, mac, mdl, device_id);
+    w.Put(",\"o\":{\"name\":\"cyd-aqm\",\"sw\":\"1.0.0\"}");
+    w.Put(",\"avty_t\":\"aqm/%s/espnow/%s/availability\"", device_id, mac);
+    w.Put(",\"stat_t\":\"aqm/%s/espnow/rx\"", device_id);
+    w.Put(",\"cmps\":{");
+    for (size_t k = 0; k < n; ++k) {
+        const auto &f = fields[k];
+        const NodeSensorDef *def = node_sensor(f.key);
+        w.Put("%s\"%s\":{\"p\":\"sensor\",\"name\":\"%s\"", k ? "," : "", f.key,
+              def ? def->name : f.key);
+        w.Put(",\"uniq_id\":\"sensor_%s_%s_%s\"", device_id, mac, f.key);
+        w.Put(",\"val_tpl\":\"{{ value_json.frames|selectattr('mac','eq','%s')"
+              "|map(attribute='values.%s')|list|last|default(this.state) }}\"",
+              mac, f.key);
+        w.Add("dev_cla", def ? def->device_class : nullptr);
+        if (f.unit[0] != '\0') w.Add("unit_of_meas", f.unit);
+        w.Put(",\"stat_cla\":\"measurement\"}");
+    }
+    w.Put("}}");
 }
 
-void publish_sensor_config(const char *device_id, const SensorDef &s)
+/* ── Cache ──────────────────────────────────────────────────────────── */
+
+constexpr uint32_t kFnvBasis = 2166136261u;
+
+uint32_t fnv1a(uint32_t h, const char *data, size_t len)
 {
-    // Discovery topic: homeassistant/sensor/<device_id>/<entity>/config
-    char topic[128];
-    std::snprintf(topic, sizeof(topic),
-                  "homeassistant/sensor/%s/%s/config", device_id, s.entity);
+    for (size_t i = 0; i < len; ++i) {
+        h = (h ^ static_cast<uint8_t>(data[i])) * 16777619u;
+    }
+    return h;
+}
 
-    cJSON *root = cJSON_CreateObject();
+/// One retained discovery message, ready to publish.
+struct Config {
+    char topic[80];
+    const char *payload;  // in s_arena
+    size_t len;
+    uint32_t hash;
+    std::atomic<bool> retained;  // the broker holds exactly this payload
+};
 
-    cJSON_AddStringToObject(root, "name", s.name);
+// Built on the first connect and again only when the mode or the state
+// format changes. Sized for the per-entity layout, the larger of the two.
+char s_arena[10 * 1024];
+Config s_configs[kMaxEntities];
+size_t s_config_count{};
+bool s_built{};
+HaDiscoveryMode s_built_mode{};
+Sen55MqttFormat s_built_format{};
 
-    char unique_id[64];
-    std::snprintf(unique_id, sizeof(unique_id),
-                  "sensor_%s_%s", device_id, s.entity);
-    cJSON_AddStringToObject(root, "unique_id", unique_id);
-    cJSON_AddStringToObject(root, "object_id", unique_id);
+void add_config(const char *topic, const char *payload, const JsonWriter &w)
+{
+    if (!w.Ok()) {
+        ESP_LOGE(TAG, "No room for %s", topic);
+        return;
+    }
+    auto &c = s_configs[s_config_count++];
+    std::snprintf(c.topic, sizeof(c.topic), "%s", topic);
+    c.payload = payload;
+    c.len = w.Length();
+    c.hash = fnv1a(kFnvBasis, payload, c.len);
+    c.retained = false;
+}
 
-    char state_topic[64];
-    std::snprintf(state_topic, sizeof(state_topic),
-                  "aqm/%s/sensor/%s", device_id, s.entity);
-    cJSON_AddStringToObject(root, "state_topic", state_topic);
+void build(const char *device_id)
+{
+    if (s_built && s_built_mode == s_mode && s_built_format == sen55_mqtt_format()) return;
+
+    Entity entities[kMaxEntities];
+    const size_t n = collect_entities(device_id, entities);
+    char topic[80];
+    s_config_count = 0;
 
-    if (s.device_class) {
-        cJSON_AddStringToObject(root, "device_class", s.device_class);
+    if (s_mode == HaDiscoveryMode::kDevice) {
+        JsonWriter w(s_arena, sizeof(s_arena));
+        write_device_config(w, device_id, entities, n);
+        std::snprintf(topic, sizeof(topic), "homeassistant/device/%s/config", device_id);
+        add_config(topic, s_arena, w);
+    } else {
+        size_t used = 0;
+        for (size_t i = 0; i < n; ++i) {
+            char *payload = s_arena + used;
+            JsonWriter w(payload, sizeof(s_arena) - used);
+            write_entity_config(w, device_id, entities[i]);
+            std::snprintf(topic, sizeof(topic), "homeassistant/sensor/%s/%s/config",
+                          device_id, entities[i].entity);
+            add_config(topic, payload, w);
+            if (w.Ok()) used += w.Length() + 1;
+        }
     }
-    if (s.unit) {
-        cJSON_AddStringToObject(root, "unit_of_measurement", s.unit);
+
+    s_built = true;
+    s_built_mode = s_mode;
+    s_built_format = sen55_mqtt_format();
+}
+
+/// Publishes (retained) every config the broker does not already hold, or
+/// all of them.
+void publish_configs(bool skip_retained)
+{
+    size_t published = 0;
+    size_t bytes = 0;
+    for (size_t i = 0; i < s_config_count; ++i) {
+        const auto &c = s_configs[i];
+        if (skip_retained && c.retained) continue;
+        mqtt_publish(c.topic, c.payload, 1, true);
+        ++published;
+        bytes += c.len;
     }
+    ESP_LOGI(TAG, "Published %u of %u configs (%u bytes)", static_cast<unsigned>(published),
+             static_cast<unsigned>(s_config_count), static_cast<unsigned>(bytes));
+}
 
-    cJSON_AddStringToObject(root, "state_class", "measurement");
+/* ── Retained check ─────────────────────────────────────────────────── */
 
-    char avail_topic[64];
-    std::snprintf(avail_topic, sizeof(avail_topic),
-                  "aqm/%s/availability", device_id);
-    cJSON_AddStringToObject(root, "availability_topic", avail_topic);
+// On connect, subscribe to both layouts' config topics: the broker sends
+// what it retains. Configs whose payload hash matches are not republished;
+// ones we no longer announce (the other layout, dropped entities) are
+// deleted. The check ends early only when everything matched, in which
+// case nothing stale can be left: it is cleared whenever we publish.
+std::atomic<bool> s_checking{false};
+bool s_subscribed{};  // both filters requested, so retained copies may end it
+esp_timer_handle_t s_check_timer{};
+char s_device_filter[80]{};
+char s_entity_filter[80]{};
 
-    cJSON_AddItemToObject(root, "device", make_device_block(device_id));
+// The retained message being received (it may come in pieces)
+bool s_rx_ours{};
+int s_rx = -1;  // its config, -1 if stale
+uint32_t s_rx_hash{};
+
+void finish_check()
+{
+    if (!s_checking.exchange(false)) return;
+    mqtt_unsubscribe(s_device_filter);
+    mqtt_unsubscribe(s_entity_filter);
+    publish_configs(true);
+}
+
+/// Start of a message on `topic`: which config it is for, or none.
+void begin_message(const char *topic, int topic_len, int total_len)
+{
+    // Only this device's own topics: other discovery under homeassistant/
+    // (the ESP-NOW nodes', see DiscoveryScheduler) is not ours to delete
+    const size_t prefix_len = std::strchr(s_entity_filter, '+') - s_entity_filter;
+    s_rx_ours = (std::strlen(s_device_filter) == static_cast<size_t>(topic_len) &&
+                 std::memcmp(topic, s_device_filter, topic_len) == 0) ||
+                (static_cast<size_t>(topic_len) > prefix_len &&
+                 std::memcmp(topic, s_entity_filter, prefix_len) == 0);
+    s_rx = -1;
+    s_rx_hash = kFnvBasis;
+    if (!s_rx_ours) return;
+
+    for (size_t i = 0; i < s_config_count; ++i) {
+        const char *t = s_configs[i].topic;
+        if (std::strlen(t) == static_cast<size_t>(topic_len) &&
+            std::memcmp(t, topic, topic_len) == 0) {
+            s_rx = static_cast<int>(i);
+            return;
+        }
+    }
+    // Not announced any more: delete it. An empty one already is a deletion
+    // (possibly our own, coming back).
+    if (total_len > 0) {
+        char stale[80];
+        std::snprintf(stale, sizeof(stale), "%.*s", topic_len, topic);
+        mqtt_publish(stale, "", 1, true);
+        ESP_LOGI(TAG, "Deleted stale %s", stale);
+    }
+}
 
-    char *json = cJSON_PrintUnformatted(root);
-    mqtt_publish(topic, json, 1, true);
-    ESP_LOGI(TAG, "Published: %s", topic);
+void on_check_timer(void * /*arg*/)
+{
+    finish_check();
+}
 
-    cJSON_free(json);
-    cJSON_Delete(root);
+void finish_if_all_retained()
+{
+    if (!s_subscribed) return;
+    for (size_t i = 0; i < s_config_count; ++i) {
+        if (!s_configs[i].retained) return;
+    }
+    esp_timer_stop(s_check_timer);
+    finish_check();
 }
 
 } // namespace
 
-void ha_discovery_publish_sen55(const char *device_id)
+HaDiscoveryMode ha_discovery_mode()
+{
+    return s_mode;
+}
+
+void ha_discovery_set_mode(HaDiscoveryMode mode)
 {
-    for (const auto &s : kSen55Sensors) {
-        publish_sensor_config(device_id, s);
+    s_mode = mode;
+}
+
+void ha_discovery_on_connect(const char *device_id)
+{
+    if (s_checking.exchange(false)) {
+        esp_timer_stop(s_check_timer);  // reconnected mid-check
+    }
+    build(device_id);
+    if (kCheckMs == 0) {
+        publish_configs(false);
+        return;
     }
+
+    if (!s_check_timer) {
+        const esp_timer_create_args_t args = {
+            .callback = on_check_timer,
+            .arg = nullptr,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "ha_disc",
+            .skip_unhandled_events = true,
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&args, &s_check_timer));
+    }
+    for (size_t i = 0; i < s_config_count; ++i) s_configs[i].retained = false;
+    std::snprintf(s_device_filter, sizeof(s_device_filter),
+                  "homeassistant/device/%s/config", device_id);
+    std::snprintf(s_entity_filter, sizeof(s_entity_filter),
+                  "homeassistant/sensor/%s/+/config", device_id);
+
+    s_rx_ours = false;
+    s_subscribed = false;
+    s_checking = true;
+    esp_timer_start_once(s_check_timer, uint64_t{kCheckMs} * 1000);
+    mqtt_subscribe(s_device_filter, 0);
+    mqtt_subscribe(s_entity_filter, 0);
+    s_subscribed = true;
+    finish_if_all_retained();
+}
+
+bool ha_discovery_on_data(const char *topic, int topic_len, const char *data, int data_len,
+                          int offset, int total_len)
+{
+    if (!s_checking) return false;
+
+    if (offset == 0) begin_message(topic, topic_len, total_len);
+    if (!s_rx_ours) return false;
+    if (s_rx < 0) return true;
+
+    auto &c = s_configs[s_rx];
+    s_rx_hash = fnv1a(s_rx_hash, data, data_len);
+    if (offset + data_len < total_len) return true;
+
+    if (static_cast<size_t>(total_len) == c.len && s_rx_hash == c.hash) c.retained = true;
+    s_rx = -1;
+    finish_if_all_retained();
+    return true;
+}
+
+void ha_discovery_publish(const char *device_id)
+{
+    build(device_id);
+    publish_configs(false);
+}
+
+size_t ha_discovery_write_node(const char *device_id, const char *mac, uint8_t type,
+                               char *topic, size_t topic_size, char *config, size_t size)
+{
+    const espnow::Field *fields = nullptr;
+    size_t n = 0;
+    const char *model = espnow::IsReading(type) ? espnow::FieldsOf(type, &fields, &n) : nullptr;
+    if (!model) return 0;
+
+    std::snprintf(topic, topic_size, "homeassistant/device/%s/%s/config", device_id, mac);
+    JsonWriter w(config, size);
+    write_node_config(w, device_id, mac, model, fields, n);
+    return w.Ok() ? w.Length() : 0;
 }
@@ -1,5 +1,47 @@
 #pragma once
 
-/// Publish MQTT Discovery config for the local SEN55 sensor (8 entities).
-/// Call on every MQTT connect (including reconnects).
-void ha_discovery_publish_sen55(const char *device_id);
+#include <cstddef>
+#include <cstdint>
+
+/// How the entities are announced to Home Assistant.
+enum class HaDiscoveryMode {
+    kDevice,  // one message on homeassistant/device/<device_id>/config (HA 2024.11+)
+    kEntity,  // one message per entity on homeassistant/sensor/<device_id>/<entity>/config
+};
+
+/// Current mode; defaults to the Kconfig choice (AQM_HA_DEVICE_DISCOVERY).
+HaDiscoveryMode ha_discovery_mode();
+
+/// Switch mode at runtime. Takes effect on the next connect or publish;
+/// the other mode's retained configs are deleted on the next connect.
+void ha_discovery_set_mode(HaDiscoveryMode mode);
+
+/// Announce the SEN55 and the diagnostic entities (boot time, reading
+/// latency, runtime telemetry). Call on every MQTT connect (including
+/// reconnects).
+///
+/// The configs are built once into a static buffer (again only if the mode
+/// or the state format changes). The broker's retained copies are read
+/// back first: configs whose content differs are republished and ones no
+/// longer announced (the other mode's, dropped entities) are deleted,
+/// CONFIG_AQM_HA_DISCOVERY_CHECK_MS after connecting. When every config
+/// matches, the check ends as soon as they have arrived.
+void ha_discovery_on_connect(const char *device_id);
+
+/// Feed every incoming MQTT message (see mqtt_data_cb_t). Returns true if
+/// it was a retained discovery config this module asked for.
+bool ha_discovery_on_data(const char *topic, int topic_len, const char *data, int data_len,
+                          int offset, int total_len);
+
+/// Publish every config now, whatever the broker holds, e.g. after
+/// sen55_mqtt_set_format().
+void ha_discovery_publish(const char *device_id);
+
+/// Writes the device config of ESP-NOW node `mac` (12 hex digits), relayed
+/// by this gateway: the topic homeassistant/device/<device_id>/<mac>/config
+/// and one sensor per field of its message `type` (espnow_protocol.h), each
+/// picking its value out of the bridge's batches on aqm/<device_id>/espnow/rx.
+/// Returns the config's length, 0 for a type without readings or if it
+/// does not fit. Publishing is up to the caller (see DiscoveryScheduler).
+size_t ha_discovery_write_node(const char *device_id, const char *mac, uint8_t type,
+                               char *topic, size_t topic_size, char *config, size_t size);
@@ -0,0 +1,215 @@
+#include "heap_audit.hpp"
+#include "task_plan.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#if CONFIG_AQM_ZERO_HEAP
+
+namespace {
+
+const char *TAG = "heap_audit";
+
+// Tasks past this share the last slot
+constexpr size_t kSlots = 16;
+
+// Firmware tasks: after boot everything they need is already allocated.
+// (esp-mqtt, lwIP and Wi-Fi allocate per packet by design.) Looked up by
+// name when the audit arms; the hook only compares handles, so it never
+// touches these strings in flash.
+constexpr const char *kFirmwareTasks[] = {
+    task_plan::kSen55.name, task_plan::kLvgl.name, task_plan::kSen55Mqtt.name,
+    task_plan::kHistory.name, task_plan::kTelemetry.name, task_plan::kEspNow.name,
+};
+
+// Tasks inside heap_audit_mqtt_begin() / _end(); more at once than this
+// are counted as their own allocations
+constexpr size_t kMqttCallers = 8;
+
+struct Slot {
+    std::atomic<TaskHandle_t> task;
+    char name[16];
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> bytes;
+    bool firmware;
+};
+
+std::atomic<bool> s_armed{false};
+Slot s_slots[kSlots];
+std::atomic<uint32_t> s_total{0};
+std::atomic<uint32_t> s_firmware{0};
+std::atomic<uint32_t> s_mqtt{0};
+esp_timer_handle_t s_arm_timer{};
+
+// In DRAM (.bss), like everything else the hook reads
+std::atomic<TaskHandle_t> s_firmware_tasks[std::size(kFirmwareTasks)];
+std::atomic<TaskHandle_t> s_mqtt_callers[kMqttCallers];
+
+IRAM_ATTR bool is_firmware_task(TaskHandle_t task)
+{
+    for (const auto &t : s_firmware_tasks) {
+        if (t.load(std::memory_order_relaxed) == task) return true;
+    }
+    return false;
+}
+
+IRAM_ATTR bool in_mqtt_call(TaskHandle_t task)
+{
+    for (const auto &t : s_mqtt_callers) {
+        if (t.load(std::memory_order_relaxed) == task) return true;
+    }
+    return false;
+}
+
+/// Slot of the running task (or of interrupt context), claiming one on
+/// first use. Lock-free: this runs inside every heap allocation.
+IRAM_ATTR Slot &slot_for_caller()
+{
+    const bool isr = xPortInIsrContext();
+    // Interrupt context has no task; a sentinel handle keeps its own slot
+    const auto task = isr ? reinterpret_cast<TaskHandle_t>(1) : xTaskGetCurrentTaskHandle();
+    for (auto &s : s_slots) {
+        TaskHandle_t owner = s.task.load();
+        if (owner == task) return s;
+        if (owner == nullptr && s.task.compare_exchange_strong(owner, task)) {
+            const char *name = isr ? "isr" : pcTaskGetName(nullptr);
+            std::strncpy(s.name, name, sizeof(s.name) - 1);
+            s.firmware = !isr && is_firmware_task(task);
+            return s;
+        }
+        if (owner == task) return s;
+    }
+    return s_slots[kSlots - 1];
+}
+
+void on_arm_timer(void * /*arg*/)
+{
+    for (size_t i = 0; i < std::size(kFirmwareTasks); ++i) {
+        s_firmware_tasks[i] = xTaskGetHandle(kFirmwareTasks[i]);
+    }
+    s_armed = true;
+    ESP_LOGI(TAG, "Armed: heap allocations are now counted%s",
+             CONFIG_AQM_ZERO_HEAP_STRICT ? " (abort in firmware tasks)" : "");
+}
+
+} // namespace
+
+// IDF heap hooks (CONFIG_HEAP_USE_HOOKS), called on every allocation and free
+extern "C" IRAM_ATTR void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t /*caps*/)
+{
+    if (!s_armed.load(std::memory_order_relaxed) || ptr == nullptr) return;
+
+    s_total.fetch_add(1, std::memory_order_relaxed);
+    if (!xPortInIsrContext() && in_mqtt_call(xTaskGetCurrentTaskHandle())) {
+        s_mqtt.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto &s = slot_for_caller();
+    s.count.fetch_add(1, std::memory_order_relaxed);
+    s.bytes.fetch_add(size, std::memory_order_relaxed);
+    if (!s.firmware) return;
+
+    s_firmware.fetch_add(1, std::memory_order_relaxed);
+    if (CONFIG_AQM_ZERO_HEAP_STRICT) {
+        esp_rom_printf(DRAM_STR("heap_audit: %u bytes allocated by %s after boot\n"),
+                       static_cast<unsigned>(size), s.name);
+        abort();
+    }
+}
+
+extern "C" IRAM_ATTR void esp_heap_trace_free_hook(void * /*ptr*/)
+{
+}
+
+void heap_audit_start()
+{
+    const esp_timer_create_args_t args = {
+        .callback = on_arm_timer,
+        .arg = nullptr,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "heap_audit",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&args, &s_arm_timer));
+    ESP_ERROR_CHECK(esp_timer_start_once(s_arm_timer,
+                                         uint64_t{CONFIG_AQM_ZERO_HEAP_ARM_S} * 1'000'000));
+}
+
+size_t heap_audit_report(heap_audit_entry_t *out, size_t max)
+{
+    size_t n = 0;
+    for (auto &s : s_slots) {
+        if (s.task.load() == nullptr || s.count.load() == 0) continue;
+        heap_audit_entry_t e{};
+        std::memcpy(e.task, s.name, sizeof(e.task));
+        e.count = s.count.load();
+        e.bytes = s.bytes.load();
+        e.firmware = s.firmware;
+        if (n < max) {
+            out[n++] = e;
+        } else if (n > 0 && e.count > out[n - 1].count) {
+            out[n - 1] = e;
+        } else {
+            continue;
+        }
+        std::sort(out, out + n, [](const auto &a, const auto &b) { return a.count > b.count; });
+    }
+    return n;
+}
+
+uint32_t heap_audit_total()
+{
+    return s_total.load();
+}
+
+uint32_t heap_audit_firmware()
+{
+    return s_firmware.load();
+}
+
+uint32_t heap_audit_mqtt()
+{
+    return s_mqtt.load();
+}
+
+void heap_audit_mqtt_begin()
+{
+    const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    for (auto &t : s_mqtt_callers) {
+        TaskHandle_t none = nullptr;
+        if (t.compare_exchange_strong(none, task)) return;
+    }
+}
+
+void heap_audit_mqtt_end()
+{
+    const TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    for (auto &t : s_mqtt_callers) {
+        TaskHandle_t mine = task;
+        if (t.compare_exchange_strong(mine, nullptr)) return;
+    }
+}
+
+#else
+
+void heap_audit_start() {}
+size_t heap_audit_report(heap_audit_entry_t * /*out*/, size_t /*max*/) { return 0; }
+uint32_t heap_audit_total() { return 0; }
+uint32_t heap_audit_firmware() { return 0; }
+uint32_t heap_audit_mqtt() { return 0; }
+void heap_audit_mqtt_begin() {}
+void heap_audit_mqtt_end() {}
+
+#endif
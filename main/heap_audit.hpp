@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// Allocations made on the heap since the audit was armed, by one task.
+struct heap_audit_entry_t {
+    char task[16];       // task name, "isr" for interrupt context
+    uint32_t count;
+    uint32_t bytes;
+    bool firmware;       // one of the task_plan tasks, which must not allocate
+                         // (bar esp-mqtt's copies, see heap_audit_mqtt_begin())
+};
+
+/// Arm the audit CONFIG_AQM_ZERO_HEAP_ARM_S after boot: from then on every
+/// heap allocation is counted against the task making it (IDF heap hooks).
+/// With CONFIG_AQM_ZERO_HEAP_STRICT, an allocation from a firmware task
+/// aborts on the spot, so the panic backtrace shows the caller.
+/// Without CONFIG_AQM_ZERO_HEAP this does nothing.
+void heap_audit_start();
+
+/// Copies up to `max` entries, busiest first. Returns how many.
+size_t heap_audit_report(heap_audit_entry_t *out, size_t max);
+
+/// Allocations since arming: all tasks, firmware tasks only, and those
+/// esp-mqtt made inside a firmware or other task's mqtt_* call.
+uint32_t heap_audit_total();
+uint32_t heap_audit_firmware();
+uint32_t heap_audit_mqtt();
+
+/// Brackets an esp-mqtt call (mqtt.cpp does this). At QoS 1/2 esp-mqtt
+/// copies the message into its outbox in the calling task; until
+/// heap_audit_mqtt_end() the running task's allocations count as
+/// esp-mqtt's, not its own. Not nestable.
+void heap_audit_mqtt_begin();
+void heap_audit_mqtt_end();
@@ -0,0 +1,362 @@
+#include "history.hpp"
+#include "sen55_metrics.hpp"
+#include "task_plan.hpp"
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+static const char* TAG = "history";
+
+namespace {
+
+constexpr size_t kChannels = History::kChannelCount;
+static_assert(kChannels == sen55_metrics::kMetricCount, "a channel per metric, in frame order");
+static_assert(sen55_metrics::kMetrics[sen55_metrics::kMetricOfWord[static_cast<size_t>(
+                  History::Channel::kTemperature)]].member == &Sen55::Measurement::temperature);
+constexpr size_t kQueueDepth = 4;
+constexpr uint32_t kBucketSeconds[History::kTierCount] = {0, 60, 3600};
+constexpr float kNaN = std::numeric_limits<float>::quiet_NaN();
+
+using Values = std::array<float, kChannels>;
+
+Values ToValues(const Sen55::Measurement& m)
+{
+    Values v;
+    for (size_t c = 0; c < kChannels; ++c) {
+        v[c] = m.*sen55_metrics::kMetrics[sen55_metrics::kMetricOfWord[c]].member;
+    }
+    return v;
+}
+
+void* AllocPsram(size_t bytes)
+{
+    void* p = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    if (!p) {
+        ESP_LOGW(TAG, "No PSRAM for %u bytes, using internal RAM",
+                 static_cast<unsigned>(bytes));
+        p = heap_caps_malloc(bytes, MALLOC_CAP_DEFAULT);
+    }
+    assert(p);
+    return p;
+}
+
+/**
+ * Fixed-capacity ring of rows, stored as one time column plus `stats`
+ * float columns per channel, all in a single allocation.
+ */
+struct Ring {
+    size_t capacity{};
+    size_t stats{};      // 1 (raw) or 3 (min/avg/max)
+    size_t head{};       // next row to write
+    size_t count{};
+    uint32_t* times{};
+    float* columns{};
+
+    void Init(size_t rows, size_t stats_per_channel)
+    {
+        capacity = std::max<size_t>(rows, 1);
+        stats = stats_per_channel;
+        const size_t floats = capacity * stats * kChannels;
+        auto* mem = AllocPsram(capacity * sizeof(uint32_t) + floats * sizeof(float));
+        times = static_cast<uint32_t*>(mem);
+        columns = reinterpret_cast<float*>(times + capacity);
+    }
+
+    void Free() { heap_caps_free(times); }
+
+    float* Column(size_t channel, size_t stat)
+    {
+        return columns + (channel * stats + (stats == 1 ? 0 : stat)) * capacity;
+    }
+    const float* Column(size_t channel, size_t stat) const
+    {
+        return const_cast<Ring*>(this)->Column(channel, stat);
+    }
+
+    size_t First() const { return (head + capacity - count) % capacity; }
+
+    /** Claims the next row, evicting the oldest when full. Returns its index. */
+    size_t Advance()
+    {
+        const size_t row = head;
+        head = head + 1 == capacity ? 0 : head + 1;
+        if (count < capacity) ++count;
+        return row;
+    }
+
+    bool Full() const { return count == capacity; }
+};
+
+/** Running aggregate of the bucket currently being filled. */
+struct Bucket {
+    uint32_t start{};
+    bool open{};
+    std::array<double, kChannels> sum{};
+    std::array<float, kChannels> min{};
+    std::array<float, kChannels> max{};
+    std::array<uint32_t, kChannels> n{};
+
+    void Reset(uint32_t bucket_start)
+    {
+        start = bucket_start;
+        open = true;
+        sum.fill(0);
+        min.fill(std::numeric_limits<float>::infinity());
+        max.fill(-std::numeric_limits<float>::infinity());
+        n.fill(0);
+    }
+
+    void Add(size_t c, double s, float lo, float hi, uint32_t count)
+    {
+        sum[c] += s;
+        min[c] = std::min(min[c], lo);
+        max[c] = std::max(max[c], hi);
+        n[c] += count;
+    }
+
+    History::Rollup Get(size_t c) const
+    {
+        if (!open || n[c] == 0) return {kNaN, kNaN, kNaN, 0};
+        return {min[c], static_cast<float>(sum[c] / n[c]), max[c], n[c]};
+    }
+};
+
+} // namespace
+
+/* ── Implementation ──────────────────────────────────────────────────── */
+
+struct History::Impl {
+    std::array<Ring, kTierCount> rings;
+    std::array<Bucket, kTierCount> buckets;  // [kRaw] unused
+
+    // Sum and non-NaN count of each raw column, for RawMean()
+    std::array<double, kChannels> raw_sum{};
+    std::array<uint32_t, kChannels> raw_n{};
+
+    SemaphoreHandle_t lock{};
+    StaticSemaphore_t lock_buf{};
+    MeasurementBus* bus{};
+    uint32_t epoch{};
+
+    // Rows closed by the current Append(), handed to on_row after unlocking
+    RowCallback on_row;
+    std::array<std::pair<Tier, Row>, kTierCount> closed{};
+    size_t closed_count{};
+
+    void AppendRaw(uint32_t t_s, const Values& v)
+    {
+        auto& r = rings[0];
+        const bool evict = r.Full();
+        const size_t row = r.Advance();
+        r.times[row] = t_s;
+        for (size_t c = 0; c < kChannels; ++c) {
+            float* col = r.Column(c, 0);
+            if (evict && !std::isnan(col[row])) {
+                raw_sum[c] -= col[row];
+                --raw_n[c];
+            }
+            col[row] = v[c];
+            if (!std::isnan(v[c])) {
+                raw_sum[c] += v[c];
+                ++raw_n[c];
+            }
+        }
+    }
+
+    /** Folds one raw reading or a closed finer bucket into tier `t`. */
+    void Fold(size_t t, uint32_t t_s, const Bucket* finer, const Values* v)
+    {
+        auto& b = buckets[t];
+        const uint32_t start = t_s - t_s % kBucketSeconds[t];
+        if (b.open && b.start != start) {
+            Close(t);
+        }
+        if (!b.open) {
+            b.Reset(start);
+        }
+        for (size_t c = 0; c < kChannels; ++c) {
+            if (finer) {
+                if (finer->n[c] != 0) {
+                    b.Add(c, finer->sum[c], finer->min[c], finer->max[c], finer->n[c]);
+                }
+            } else if (!std::isnan((*v)[c])) {
+                b.Add(c, (*v)[c], (*v)[c], (*v)[c], 1);
+            }
+        }
+    }
+
+    void Store(size_t t, const Row& row)
+    {
+        auto& r = rings[t];
+        const size_t i = r.Advance();
+        r.times[i] = row.time;
+        for (size_t c = 0; c < kChannels; ++c) {
+            r.Column(c, size_t(Stat::kMin))[i] = row.min[c];
+            r.Column(c, size_t(Stat::kAvg))[i] = row.avg[c];
+            r.Column(c, size_t(Stat::kMax))[i] = row.max[c];
+        }
+    }
+
+    /** Writes the open bucket of tier `t` as a row and passes it up a tier. */
+    void Close(size_t t)
+    {
+        auto& b = buckets[t];
+        auto& [tier, row] = closed[closed_count++];
+        tier = Tier(t);
+        row.time = b.start;
+        for (size_t c = 0; c < kChannels; ++c) {
+            const auto agg = b.Get(c);
+            row.min[c] = agg.min;
+            row.avg[c] = agg.avg;
+            row.max[c] = agg.max;
+        }
+        Store(t, row);
+        if (t + 1 < kTierCount) {
+            Fold(t + 1, b.start, &b, nullptr);
+        }
+        b.open = false;
+    }
+
+    static void Run(void* arg)
+    {
+        auto& self = *static_cast<History*>(arg);
+        auto* sub = self.impl_->bus->Subscribe(
+            "history", MeasurementBus::Mode::kQueue, kQueueDepth,
+            xTaskGetCurrentTaskHandle());
+        if (!sub) {
+            ESP_LOGE(TAG, "No free measurement bus slot");
+            vTaskDelete(nullptr);
+            return;
+        }
+
+        Sen55::Measurement m;
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            while (sub->Pop(m)) {
+                self.Append(esp_timer_get_time(), m);
+            }
+        }
+    }
+};
+
+History::History(const Capacity& capacity)
+    : impl_(std::make_unique<Impl>())
+{
+    auto& d = *impl_;
+    d.rings[0].Init(capacity.raw, 1);
+    d.rings[1].Init(capacity.minute, 3);
+    d.rings[2].Init(capacity.hour, 3);
+    d.lock = xSemaphoreCreateMutexStatic(&d.lock_buf);
+
+    size_t bytes = 0;
+    for (const auto& r : d.rings) {
+        bytes += r.capacity * (sizeof(uint32_t) + r.stats * kChannels * sizeof(float));
+    }
+    ESP_LOGI(TAG, "%u raw / %u min / %u h rows, %u KiB",
+             static_cast<unsigned>(d.rings[0].capacity),
+             static_cast<unsigned>(d.rings[1].capacity),
+             static_cast<unsigned>(d.rings[2].capacity),
+             static_cast<unsigned>(bytes / 1024));
+}
+
+History::~History()
+{
+    for (auto& r : impl_->rings) r.Free();
+    vSemaphoreDelete(impl_->lock);
+}
+
+void History::Append(int64_t t_us, const Sen55::Measurement& m)
+{
+    auto& d = *impl_;
+    const auto t_s = d.epoch + static_cast<uint32_t>(t_us / 1'000'000);
+    const auto v = ToValues(m);
+
+    xSemaphoreTake(d.lock, portMAX_DELAY);
+    d.closed_count = 0;
+    d.AppendRaw(t_s, v);
+    d.Fold(1, t_s, nullptr, &v);
+    xSemaphoreGive(d.lock);
+
+    if (d.on_row) {
+        for (size_t i = 0; i < d.closed_count; ++i) {
+            d.on_row(d.closed[i].first, d.closed[i].second);
+        }
+    }
+}
+
+void History::SetEpoch(uint32_t t_s)
+{
+    impl_->epoch = t_s;
+}
+
+void History::Restore(Tier tier, const Row& row)
+{
+    if (tier == Tier::kRaw) return;
+    xSemaphoreTake(impl_->lock, portMAX_DELAY);
+    impl_->Store(size_t(tier), row);
+    xSemaphoreGive(impl_->lock);
+}
+
+void History::OnRow(RowCallback cb)
+{
+    impl_->on_row = std::move(cb);
+}
+
+History::View History::Read() const
+{
+    xSemaphoreTake(impl_->lock, portMAX_DELAY);
+    return View(this);
+}
+
+void History::Start(MeasurementBus& bus)
+{
+    impl_->bus = &bus;
+    task_plan::Create<task_plan::kHistory>(Impl::Run, this);
+}
+
+/* ── View ────────────────────────────────────────────────────────────── */
+
+History::View::~View()
+{
+    if (owner_) xSemaphoreGive(owner_->impl_->lock);
+}
+
+History::View::View(View&& other) noexcept
+    : owner_(other.owner_)
+{
+    other.owner_ = nullptr;
+}
+
+History::Column<uint32_t> History::View::Times(Tier tier) const
+{
+    const auto& r = owner_->impl_->rings[size_t(tier)];
+    return {r.times, r.capacity, r.First(), r.count};
+}
+
+History::Column<float> History::View::Values(Tier tier, Channel channel, Stat stat) const
+{
+    const auto& r = owner_->impl_->rings[size_t(tier)];
+    return {r.Column(size_t(channel), size_t(stat)), r.capacity, r.First(), r.count};
+}
+
+History::Rollup History::View::Pending(Tier tier, Channel channel) const
+{
+    return owner_->impl_->buckets[size_t(tier)].Get(size_t(channel));
+}
+
+float History::View::RawMean(Channel channel) const
+{
+    const auto& d = *owner_->impl_;
+    const auto c = size_t(channel);
+    return d.raw_n[c] ? static_cast<float>(d.raw_sum[c] / d.raw_n[c]) : kNaN;
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "measurement_bus.hpp"
+#include "sen55.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+
+/**
+ * Time-series history of SEN55 readings, held in PSRAM in three tiers:
+ *
+ *   kRaw     every reading (~1 s) for the last hour
+ *   kMinute  1 min min/avg/max rollups for days
+ *   kHour    1 h min/avg/max rollups for weeks
+ *
+ * Each tier is a ring stored column by column (one contiguous array per
+ * channel and statistic), so a chart or export of one quantity walks
+ * sequential memory. Rollups are folded in incrementally as readings
+ * arrive: O(1) per reading, never a rescan.
+ *
+ * Readers take a View, which holds the history lock for its lifetime and
+ * exposes the rings in place. Keep views short-lived; the writer waits on
+ * them.
+ *
+ * Times are whole seconds of esp_timer time plus an epoch set at boot
+ * (see SetEpoch()), so rows restored from flash sort before new ones.
+ */
+class History {
+public:
+    /** In Read-Measured-Values order: a channel is its sen55_metrics word. */
+    enum class Channel : uint8_t {
+        kPm1_0, kPm2_5, kPm4_0, kPm10, kHumidity, kTemperature, kVocIndex, kNoxIndex,
+    };
+    static constexpr size_t kChannelCount = 8;
+
+    enum class Tier : uint8_t { kRaw, kMinute, kHour };
+    static constexpr size_t kTierCount = 3;
+
+    enum class Stat : uint8_t { kMin, kAvg, kMax };
+
+    /** Rows kept per tier. */
+    struct Capacity {
+        size_t raw;
+        size_t minute;
+        size_t hour;
+    };
+
+    /** Aggregate of a bucket; all NaN when count is 0. */
+    struct Rollup {
+        float min;
+        float avg;
+        float max;
+        uint32_t count;
+    };
+
+    /** One closed Minute or Hour bucket. */
+    struct Row {
+        uint32_t time;  // bucket start
+        std::array<float, kChannelCount> min;
+        std::array<float, kChannelCount> avg;
+        std::array<float, kChannelCount> max;
+    };
+
+    using RowCallback = std::function<void(Tier tier, const Row& row)>;
+
+    /** One column of a ring, oldest first. Does not own the data. */
+    template <typename T>
+    class Column {
+    public:
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        const T& operator[](size_t i) const
+        {
+            const size_t j = first_ + i;
+            return data_[j < capacity_ ? j : j - capacity_];
+        }
+        const T& back() const { return (*this)[size_ - 1]; }
+
+        /** The ring as at most two contiguous runs, in order. */
+        std::span<const T> Head() const
+        {
+            return {data_ + first_, std::min(size_, capacity_ - first_)};
+        }
+        std::span<const T> Tail() const
+        {
+            return {data_, size_ - Head().size()};
+        }
+
+    private:
+        friend class History;
+        Column(const T* data, size_t capacity, size_t first, size_t size)
+            : data_(data), capacity_(capacity), first_(first), size_(size) {}
+
+        const T* data_;
+        size_t capacity_;
+        size_t first_;
+        size_t size_;
+    };
+
+    /** Read access to all tiers. Holds the history lock until destroyed. */
+    class View {
+    public:
+        ~View();
+        View(View&& other) noexcept;
+        View(const View&) = delete;
+        View& operator=(const View&) = delete;
+        View& operator=(View&&) = delete;
+
+        /** Bucket start times (raw: reading times), in seconds. */
+        Column<uint32_t> Times(Tier tier) const;
+
+        /** One statistic of one channel. Raw rows have min == avg == max. */
+        Column<float> Values(Tier tier, Channel channel, Stat stat = Stat::kAvg) const;
+
+        /** The bucket still being filled (not yet in the Minute/Hour rings). */
+        Rollup Pending(Tier tier, Channel channel) const;
+
+        /** Mean of the whole raw ring, kept as a running sum. */
+        float RawMean(Channel channel) const;
+
+    private:
+        friend class History;
+        explicit View(const History* owner) : owner_(owner) {}
+        const History* owner_;
+    };
+
+    explicit History(const Capacity& capacity);
+    ~History();
+
+    /** Records a reading taken at `t_us` (esp_timer time). Times must not go back. */
+    void Append(int64_t t_us, const Sen55::Measurement& m);
+
+    /** Offsets all later timestamps by `t_s`. Call before Start(). */
+    void SetEpoch(uint32_t t_s);
+
+    /** Puts a saved Minute/Hour row back, oldest first, before Start(). */
+    void Restore(Tier tier, const Row& row);
+
+    /**
+     * Called on the writer task for each Minute/Hour row as it closes,
+     * outside the history lock. Set before Start().
+     */
+    void OnRow(RowCallback cb);
+
+    View Read() const;
+
+    /** Subscribes to `bus` and appends every reading from a small task. */
+    void Start(MeasurementBus& bus);
+
+    History(const History&) = delete;
+    History& operator=(const History&) = delete;
+    History(History&&) = delete;
+    History& operator=(History&&) = delete;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
@@ -0,0 +1,484 @@
+#include "history_log.hpp"
+
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+
+#include <array>
+#include <bit>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+static const char* TAG = "history_log";
+
+/* ── Flash layout ────────────────────────────────────────────────────── */
+
+// Sector:  SectorHeader, then records until the first 0xFF length byte.
+// Record:  len (u8), crc8 (u8) over the payload, payload of `len` bytes.
+// Payload: one row as a bit stream, MSB first, padded to a byte:
+//   time   '0'                     same delta as the previous row
+//          '10'   + 7 bits         delta-of-delta in [-63, 64]
+//          '110'  + 9 bits         in [-255, 256]
+//          '1110' + 12 bits        in [-2047, 2048]
+//          '1111' + 32 bits        raw delta
+//   value  '0'                     same as the previous row
+//          '10'   + w bits         zigzag delta fits the previous width w
+//          '11'   + 5 bits (w - 1) + w bits
+// for 24 columns: min[0..7], avg[0..7], max[0..7], each as a fixed-point
+// integer in the channel's storage step (NaN is INT32_MIN). The first row of a
+// sector is coded against time first_t - bucket and all-zero values.
+
+namespace {
+
+constexpr uint32_t kSectorSize = 4096;
+constexpr uint32_t kMagic = 0x31474C48;  // "HLG1"
+constexpr size_t kColumns = 3 * History::kChannelCount;
+constexpr size_t kMaxPayload = (36 + kColumns * 39 + 7) / 8;
+constexpr int32_t kNaNCode = INT32_MIN;
+
+// Fixed-point steps per channel: 10x finer than the sensor's output
+// resolution for PM, the sensor's own for the rest. Min and max are
+// therefore exact; averages are rounded to the step.
+constexpr float kScale[History::kChannelCount] = {
+    100, 100, 100, 100,  // PM µg/m³: 0.01
+    100,                 // %RH: 0.01
+    200,                 // °C: 0.005
+    10, 10,              // VOC, NOx index: 0.1
+};
+
+int32_t Quantize(float v, size_t channel)
+{
+    return std::isnan(v) ? kNaNCode : static_cast<int32_t>(std::lround(v * kScale[channel]));
+}
+
+float Dequantize(int32_t q, size_t channel)
+{
+    return q == kNaNCode ? NAN : static_cast<float>(q) / kScale[channel];
+}
+
+struct SectorHeader {
+    uint32_t magic;
+    uint32_t seq;       // increases by one per sector written
+    uint32_t first_t;   // time of the first row
+    uint32_t bucket_s;
+};
+
+constexpr uint32_t kFirstRecord = sizeof(SectorHeader);
+
+static_assert(kMaxPayload + 2 < 0xFF, "record length must fit a byte");
+
+uint8_t Crc8(const uint8_t* data, size_t len)
+{
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; ++b) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+class BitWriter {
+public:
+    explicit BitWriter(uint8_t* buf) : buf_(buf) {}
+
+    void Put(uint32_t value, unsigned bits)
+    {
+        while (bits > 0) {
+            const unsigned room = 8 - (pos_ & 7);
+            const unsigned n = bits < room ? bits : room;
+            const uint32_t chunk = (value >> (bits - n)) & ((1u << n) - 1);
+            if ((pos_ & 7) == 0) buf_[pos_ >> 3] = 0;
+            buf_[pos_ >> 3] |= static_cast<uint8_t>(chunk << (room - n));
+            pos_ += n;
+            bits -= n;
+        }
+    }
+
+    size_t Bytes() const { return (pos_ + 7) / 8; }
+
+private:
+    uint8_t* buf_;
+    size_t pos_{};
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t* buf, size_t len) : buf_(buf), end_(len * 8) {}
+
+    uint32_t Get(unsigned bits)
+    {
+        uint32_t value = 0;
+        while (bits > 0) {
+            if (pos_ >= end_) {
+                overrun_ = true;
+                return 0;
+            }
+            const unsigned room = 8 - (pos_ & 7);
+            const unsigned n = bits < room ? bits : room;
+            const uint32_t chunk = (buf_[pos_ >> 3] >> (room - n)) & ((1u << n) - 1);
+            value = (value << n) | chunk;
+            pos_ += n;
+            bits -= n;
+        }
+        return value;
+    }
+
+    bool Overrun() const { return overrun_; }
+
+private:
+    const uint8_t* buf_;
+    size_t end_;
+    size_t pos_{};
+    bool overrun_{};
+};
+
+/** Per-sector delta state, identical on the encode and decode side. */
+struct Codec {
+    uint32_t prev_time{};
+    uint32_t prev_delta{};
+    std::array<int32_t, kColumns> prev{};
+    std::array<uint8_t, kColumns> width{};  // bits of the last coded delta, 0 = none yet
+
+    void Reset(uint32_t first_t, uint32_t bucket_s)
+    {
+        prev_time = first_t - bucket_s;
+        prev_delta = bucket_s;
+        prev.fill(0);
+        width.fill(0);
+    }
+
+    static float& Column(History::Row& row, size_t i)
+    {
+        auto& stat = i < 8 ? row.min : i < 16 ? row.avg : row.max;
+        return stat[i % 8];
+    }
+
+    size_t Encode(History::Row row, uint8_t* out)
+    {
+        BitWriter w(out);
+
+        const uint32_t delta = row.time - prev_time;
+        const int64_t dod = int64_t{delta} - int64_t{prev_delta};
+        if (dod == 0) {
+            w.Put(0b0, 1);
+        } else if (dod >= -63 && dod <= 64) {
+            w.Put(0b10, 2);
+            w.Put(static_cast<uint32_t>(dod + 63), 7);
+        } else if (dod >= -255 && dod <= 256) {
+            w.Put(0b110, 3);
+            w.Put(static_cast<uint32_t>(dod + 255), 9);
+        } else if (dod >= -2047 && dod <= 2048) {
+            w.Put(0b1110, 4);
+            w.Put(static_cast<uint32_t>(dod + 2047), 12);
+        } else {
+            w.Put(0b1111, 4);
+            w.Put(delta, 32);
+        }
+        prev_time = row.time;
+        prev_delta = delta;
+
+        for (size_t i = 0; i < kColumns; ++i) {
+            const int32_t q = Quantize(Column(row, i), i % 8);
+            // Wrapping difference, so jumps to and from kNaNCode still fit 32 bits
+            const auto d = static_cast<int32_t>(static_cast<uint32_t>(q) -
+                                                static_cast<uint32_t>(prev[i]));
+            const uint32_t zz = (static_cast<uint32_t>(d) << 1) ^ static_cast<uint32_t>(d >> 31);
+            prev[i] = q;
+            if (zz == 0) {
+                w.Put(0b0, 1);
+                continue;
+            }
+            const auto bits = static_cast<uint8_t>(32 - std::countl_zero(zz));
+            if (width[i] != 0 && bits <= width[i]) {
+                w.Put(0b10, 2);
+                w.Put(zz, width[i]);
+            } else {
+                w.Put(0b11, 2);
+                w.Put(bits - 1u, 5);
+                w.Put(zz, bits);
+                width[i] = bits;
+            }
+        }
+        return w.Bytes();
+    }
+
+    bool Decode(const uint8_t* in, size_t len, History::Row* row)
+    {
+        BitReader r(in, len);
+
+        uint32_t delta;
+        if (r.Get(1) == 0) {
+            delta = prev_delta;
+        } else if (r.Get(1) == 0) {
+            delta = prev_delta + r.Get(7) - 63;
+        } else if (r.Get(1) == 0) {
+            delta = prev_delta + r.Get(9) - 255;
+        } else if (r.Get(1) == 0) {
+            delta = prev_delta + r.Get(12) - 2047;
+        } else {
+            delta = r.Get(32);
+        }
+        row->time = prev_time + delta;
+        prev_time = row->time;
+        prev_delta = delta;
+
+        for (size_t i = 0; i < kColumns; ++i) {
+            uint32_t zz = 0;
+            if (r.Get(1) == 1) {
+                if (r.Get(1) == 0) {
+                    if (width[i] == 0) return false;
+                    zz = r.Get(width[i]);
+                } else {
+                    width[i] = static_cast<uint8_t>(r.Get(5) + 1);
+                    zz = r.Get(width[i]);
+                }
+            }
+            const uint32_t d = (zz >> 1) ^ (0u - (zz & 1));
+            prev[i] = static_cast<int32_t>(static_cast<uint32_t>(prev[i]) + d);
+            Column(*row, i) = Dequantize(prev[i], i % 8);
+        }
+        return !r.Overrun();
+    }
+};
+
+} // namespace
+
+/* ── Implementation ──────────────────────────────────────────────────── */
+
+struct HistoryLog::Impl {
+    const esp_partition_t* part{};
+    uint32_t sectors{};
+    uint32_t bucket_s{};
+
+    bool has_head{};
+    uint32_t head{};        // sector being appended to
+    uint32_t head_seq{};
+    uint32_t write_off{};
+    bool head_full{};       // torn record: no more appends to this sector
+    Codec enc;
+
+    bool has_last{};
+    uint32_t last_t{};
+
+    std::vector<uint8_t> buf;  // one sector
+    Stats stats{};
+
+    bool ReadHeader(uint32_t index, SectorHeader* h)
+    {
+        ++stats.header_reads;
+        return esp_partition_read(part, index * kSectorSize, h, sizeof(*h)) == ESP_OK &&
+               h->magic == kMagic && h->bucket_s == bucket_s;
+    }
+
+    /**
+     * Decodes every record of sector `index`, calling `fn` per row.
+     * Leaves `codec` and `end` positioned after the last good record and
+     * returns false if the sector ends in a torn or corrupt record.
+     */
+    template <typename Fn>
+    bool DecodeSector(uint32_t index, const SectorHeader& h, Codec* codec,
+                      uint32_t* end, Fn&& fn)
+    {
+        codec->Reset(h.first_t, bucket_s);
+        *end = kFirstRecord;
+        ++stats.sector_reads;
+        if (esp_partition_read(part, index * kSectorSize, buf.data(), kSectorSize) != ESP_OK) {
+            return false;
+        }
+        uint32_t off = kFirstRecord;
+        while (off + 2 <= kSectorSize && buf[off] != 0xFF) {
+            const uint8_t len = buf[off];
+            if (off + 2 + len > kSectorSize || Crc8(&buf[off + 2], len) != buf[off + 1]) {
+                return false;
+            }
+            History::Row row;
+            Codec next = *codec;
+            if (!next.Decode(&buf[off + 2], len, &row)) {
+                return false;
+            }
+            *codec = next;
+            fn(row);
+            off += 2 + len;
+            *end = off;
+        }
+        return true;
+    }
+
+    /** Finds the newest sector: O(log n) header reads, plus that sector. */
+    void Open()
+    {
+        const int64_t start_us = esp_timer_get_time();
+        SectorHeader first{};
+        SectorHeader h{};
+
+        // Sectors are written 0, 1, ..., n-1, 0, ... with consecutive seq,
+        // so "valid and seq >= seq(0)" holds for a prefix ending at the head.
+        if (ReadHeader(0, &first)) {
+            uint32_t lo = 0;
+            uint32_t hi = sectors - 1;
+            while (lo < hi) {
+                const uint32_t mid = lo + (hi - lo + 1) / 2;
+                if (ReadHeader(mid, &h) && h.seq >= first.seq) {
+                    lo = mid;
+                } else {
+                    hi = mid - 1;
+                }
+            }
+            head = lo;
+            has_head = true;
+        } else if (ReadHeader(sectors - 1, &h)) {
+            // Wrapped, and sector 0 was being rewritten when power went
+            head = sectors - 1;
+            has_head = true;
+        }
+
+        if (has_head) {
+            ReadHeader(head, &h);
+            head_seq = h.seq;
+            head_full = !DecodeSector(head, h, &enc, &write_off, [&](const History::Row& row) {
+                last_t = row.time;
+                has_last = true;
+            });
+            // Newest sector holds no rows yet: take the last time from the one before
+            SectorHeader prev{};
+            const uint32_t p = (head + sectors - 1) % sectors;
+            if (!has_last && p != head && ReadHeader(p, &prev) && prev.seq + 1 == h.seq) {
+                Codec scratch;
+                uint32_t end;
+                DecodeSector(p, prev, &scratch, &end, [&](const History::Row& row) {
+                    last_t = row.time;
+                    has_last = true;
+                });
+            }
+        }
+        stats.open_us = esp_timer_get_time() - start_us;
+    }
+
+    void StartSector(uint32_t first_t)
+    {
+        head = has_head ? (head + 1) % sectors : 0;
+        head_seq = has_head ? head_seq + 1 : 1;
+        has_head = true;
+        head_full = false;
+
+        esp_partition_erase_range(part, head * kSectorSize, kSectorSize);
+        ++stats.erases;
+        const SectorHeader h{kMagic, head_seq, first_t, bucket_s};
+        esp_partition_write(part, head * kSectorSize, &h, sizeof(h));
+        write_off = kFirstRecord;
+        enc.Reset(first_t, bucket_s);
+    }
+};
+
+HistoryLog::HistoryLog(const char* partition_label, uint32_t bucket_seconds)
+    : impl_(std::make_unique<Impl>())
+{
+    auto& d = *impl_;
+    d.bucket_s = bucket_seconds;
+    d.part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                      ESP_PARTITION_SUBTYPE_ANY, partition_label);
+    if (!d.part || d.part->size < 2 * kSectorSize) {
+        ESP_LOGW(TAG, "Partition '%s' not found, history will not persist", partition_label);
+        d.part = nullptr;
+        return;
+    }
+    d.sectors = d.part->size / kSectorSize;
+    d.stats.sectors = d.sectors;
+    d.buf.resize(kSectorSize);
+    d.Open();
+
+    ESP_LOGI(TAG, "%s: %s, head sector %u at %u, indexed in %u header + %u sector reads, %lld us",
+             partition_label, d.has_last ? "restored" : "empty",
+             static_cast<unsigned>(d.head), static_cast<unsigned>(d.write_off),
+             static_cast<unsigned>(d.stats.header_reads),
+             static_cast<unsigned>(d.stats.sector_reads),
+             static_cast<long long>(d.stats.open_us));
+}
+
+HistoryLog::~HistoryLog() = default;
+
+void HistoryLog::Append(const History::Row& row)
+{
+    auto& d = *impl_;
+    if (!d.part) return;
+
+    uint8_t record[2 + kMaxPayload];
+    Codec next = d.enc;
+    size_t len = next.Encode(row, record + 2);
+    if (!d.has_head || d.head_full || d.write_off + 2 + len > kSectorSize) {
+        d.StartSector(row.time);
+        next = d.enc;
+        len = next.Encode(row, record + 2);
+    }
+    record[0] = static_cast<uint8_t>(len);
+    record[1] = Crc8(record + 2, len);
+
+    if (esp_partition_write(d.part, d.head * kSectorSize + d.write_off, record, 2 + len) != ESP_OK) {
+        d.head_full = true;
+        return;
+    }
+    d.enc = next;
+    d.write_off += 2 + len;
+    d.last_t = row.time;
+    d.has_last = true;
+    ++d.stats.rows_written;
+    d.stats.bytes_written += 2 + len;
+}
+
+size_t HistoryLog::Replay(size_t max_rows, const std::function<void(const History::Row&)>& fn)
+{
+    auto& d = *impl_;
+    if (!d.has_head || !d.has_last || max_rows == 0) return 0;
+
+    const uint64_t span = uint64_t{max_rows} * d.bucket_s;
+    const uint32_t cutoff = d.last_t + 1 > span ? d.last_t + 1 - span : 0;
+
+    // Walk back over headers to the sector holding the cutoff
+    uint32_t start = d.head;
+    SectorHeader h{};
+    d.ReadHeader(start, &h);
+    for (uint32_t walked = 1; walked < d.sectors && h.first_t > cutoff; ++walked) {
+        SectorHeader prev{};
+        const uint32_t p = (start + d.sectors - 1) % d.sectors;
+        if (!d.ReadHeader(p, &prev) || prev.seq + 1 != h.seq) break;
+        start = p;
+        h = prev;
+    }
+
+    size_t count = 0;
+    for (uint32_t i = start;; i = (i + 1) % d.sectors) {
+        SectorHeader sh{};
+        if (d.ReadHeader(i, &sh)) {
+            Codec codec;
+            uint32_t end;
+            d.DecodeSector(i, sh, &codec, &end, [&](const History::Row& row) {
+                if (row.time >= cutoff) {
+                    fn(row);
+                    ++count;
+                }
+            });
+        }
+        if (i == d.head) break;
+    }
+    return count;
+}
+
+float HistoryLog::Step(History::Channel channel)
+{
+    return 1.0f / kScale[size_t(channel)];
+}
+
+bool HistoryLog::LastTime(uint32_t* t_s) const
+{
+    if (impl_->has_last) *t_s = impl_->last_t;
+    return impl_->has_last;
+}
+
+HistoryLog::Stats HistoryLog::GetStats() const
+{
+    return impl_->stats;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "history.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+/**
+ * Append-only flash log of one History rollup tier, so history survives a
+ * reboot.
+ *
+ * Rows are compressed Gorilla-style: bucket times as delta-of-delta,
+ * values as the difference from the same column's previous value, coded
+ * in the previous bit width where it fits. Values are stored as
+ * fixed-point in Step() units first: min/max come back exactly, averages
+ * rounded to the step. Each 4 KiB sector starts a fresh block that
+ * decodes on its own. Records are byte-aligned and appended to flash as
+ * each row closes.
+ *
+ * Sectors are filled in order round the partition and erased only when
+ * the log wraps onto them, so wear is spread evenly. At start-up the
+ * newest sector is found by binary search over sector headers; only that
+ * sector is read in full.
+ *
+ * Not thread-safe: Replay() at boot, then Append() from one task.
+ */
+class HistoryLog {
+public:
+    struct Stats {
+        uint32_t sectors;         // in the partition, 0 if not found
+        uint32_t rows_written;    // since boot
+        uint32_t bytes_written;   // record bytes since boot, headers excluded
+        uint32_t erases;          // since boot
+        uint32_t header_reads;    // sector header reads since boot (indexing, replay)
+        uint32_t sector_reads;    // whole-sector reads since boot
+        int64_t open_us;          // time to index the log at start-up
+    };
+
+    /** Opens (and indexes) the log in data partition `partition_label`. */
+    HistoryLog(const char* partition_label, uint32_t bucket_seconds);
+    ~HistoryLog();
+
+    /** Appends a row. Times must increase. */
+    void Append(const History::Row& row);
+
+    /**
+     * Calls `fn` for the saved rows in the last `max_rows` buckets, oldest
+     * first, reading back only as many sectors as that needs. Returns the
+     * number of rows.
+     */
+    size_t Replay(size_t max_rows, const std::function<void(const History::Row&)>& fn);
+
+    /** Storage step of `channel`; restored averages are rounded to it. */
+    static float Step(History::Channel channel);
+
+    /** Time of the newest saved row; false if the log is empty. */
+    bool LastTime(uint32_t* t_s) const;
+
+    Stats GetStats() const;
+
+    HistoryLog(const HistoryLog&) = delete;
+    HistoryLog& operator=(const HistoryLog&) = delete;
+    HistoryLog(HistoryLog&&) = delete;
+    HistoryLog& operator=(HistoryLog&&) = delete;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
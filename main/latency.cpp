@@ -0,0 +1,120 @@
+#include "latency.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+
+#include "esp_timer.h"
+
+namespace {
+
+constexpr size_t kStageCount = static_cast<size_t>(LatencyStage::kCount);
+
+constexpr const char *kStageNames[kStageCount] = {"read", "ui", "publish", "ack"};
+
+LatencyHistogram s_stages[kStageCount];
+
+size_t BucketOf(uint32_t us)
+{
+    if (us < LatencyHistogram::kFirstBoundUs) return 0;
+    // 256..511 → 1, 512..1023 → 2, ...
+    const auto i = static_cast<size_t>(std::bit_width(us / LatencyHistogram::kFirstBoundUs));
+    return std::min(i, LatencyHistogram::kBuckets - 1);
+}
+
+} // namespace
+
+/* ── LatencyHistogram ────────────────────────────────────────────────── */
+
+void LatencyHistogram::Record(uint32_t us)
+{
+    buckets_[BucketOf(us)].fetch_add(1, std::memory_order_relaxed);
+    sum_us_.fetch_add(us, std::memory_order_relaxed);
+    uint32_t max = max_us_.load(std::memory_order_relaxed);
+    while (us > max && !max_us_.compare_exchange_weak(max, us, std::memory_order_relaxed)) {}
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::Take()
+{
+    Snapshot s{};
+    for (size_t i = 0; i < kBuckets; ++i) {
+        s.buckets[i] = buckets_[i].exchange(0, std::memory_order_relaxed);
+        s.count += s.buckets[i];
+    }
+    s.sum_us = sum_us_.exchange(0, std::memory_order_relaxed);
+    s.max_us = max_us_.exchange(0, std::memory_order_relaxed);
+    return s;
+}
+
+uint32_t LatencyHistogram::BucketBoundUs(size_t i)
+{
+    return i + 1 < kBuckets ? kFirstBoundUs << i : UINT32_MAX;
+}
+
+uint32_t LatencyHistogram::Snapshot::PercentileUs(unsigned p) const
+{
+    if (count == 0) return 0;
+    // Rank of the sample at or above which p% of the window falls
+    const uint64_t rank = (uint64_t{count} * std::min(p, 100u) + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += buckets[i];
+        if (seen >= rank && seen > 0) return std::min(BucketBoundUs(i), max_us);
+    }
+    return max_us;
+}
+
+/* ── Stages ──────────────────────────────────────────────────────────── */
+
+uint32_t latency_now()
+{
+    return static_cast<uint32_t>(esp_timer_get_time());
+}
+
+void latency_record(LatencyStage stage, uint32_t since)
+{
+    if (since == 0) return;
+    latency_record_us(stage, latency_now() - since);
+}
+
+void latency_record_us(LatencyStage stage, uint32_t us)
+{
+    const auto i = static_cast<size_t>(stage);
+    if (i < kStageCount) s_stages[i].Record(us);
+}
+
+const char *latency_stage_name(LatencyStage stage)
+{
+    const auto i = static_cast<size_t>(stage);
+    return i < kStageCount ? kStageNames[i] : "?";
+}
+
+size_t latency_report_json(char *buf, size_t size, uint32_t unix_s, uint32_t window_s)
+{
+    if (size == 0) return 0;
+    size_t len = 0;
+    auto put = [&](const char *fmt, auto... args) {
+        if (len < size) len += std::snprintf(buf + len, size - len, fmt, args...);
+    };
+    auto ms = [](uint64_t us) { return static_cast<double>(us) / 1000.0; };
+
+    put("{");
+    if (unix_s != 0) put("\"ts\":%lu,", static_cast<unsigned long>(unix_s));
+    put("\"window_s\":%lu", static_cast<unsigned long>(window_s));
+    for (size_t i = 0; i < kStageCount; ++i) {
+        const auto s = s_stages[i].Take();
+        put(",\"%s\":{\"n\":%lu", kStageNames[i], static_cast<unsigned long>(s.count));
+        if (s.count != 0) {
+            put(",\"mean_ms\":%.1f,\"p50_ms\":%.1f,\"p90_ms\":%.1f,\"p99_ms\":%.1f,\"max_ms\":%.1f",
+                ms(s.sum_us / s.count), ms(s.PercentileUs(50)), ms(s.PercentileUs(90)),
+                ms(s.PercentileUs(99)), ms(s.max_us));
+        }
+        put(",\"hist\":[");
+        for (size_t b = 0; b < LatencyHistogram::kBuckets; ++b) {
+            put(b ? ",%lu" : "%lu", static_cast<unsigned long>(s.buckets[b]));
+        }
+        put("]}");
+    }
+    put("}");
+    return std::min(len, size - 1);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Durations counted in power-of-two buckets: [0, 256 µs), [256, 512 µs),
+ * ... [2.10 s, 4.19 s), and one for anything longer.
+ *
+ * Record() is lock-free and may run on several tasks at once and race
+ * with Take(); a sample racing a Take() lands in one window or the next.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t kBuckets = 16;
+    static constexpr uint32_t kFirstBoundUs = 256;
+
+    struct Snapshot {
+        uint32_t count;
+        uint32_t max_us;
+        uint64_t sum_us;
+        std::array<uint32_t, kBuckets> buckets;
+
+        /** Upper bound of the bucket holding the `p`th percentile, capped at max_us. */
+        uint32_t PercentileUs(unsigned p) const;
+    };
+
+    void Record(uint32_t us);
+
+    /** Counts since the previous Take(), resetting them. */
+    Snapshot Take();
+
+    /** Exclusive upper bound of bucket `i`; UINT32_MAX for the last. */
+    static uint32_t BucketBoundUs(size_t i);
+
+private:
+    std::array<std::atomic<uint32_t>, kBuckets> buckets_{};
+    std::atomic<uint32_t> max_us_{};
+    std::atomic<uint64_t> sum_us_{};
+};
+
+/// Where a reading has got to, each measured from the I2C read that
+/// produced it (Sen55::Measurement::read_us), except kRead.
+enum class LatencyStage : uint8_t {
+    kRead,     // sensor update (as Sen55 estimates it) → I2C read complete
+    kUi,       // → values applied to the cards
+    kPublish,  // → handed to esp-mqtt (at QoS 0 that is written to the socket)
+    kAck,      // → PUBACK from the broker (state QoS 1 only)
+    kCount,
+};
+
+/// esp_timer time, low 32 bits: the clock of Measurement::read_us.
+/// Wraps every 71 minutes; only differences under that are meaningful.
+uint32_t latency_now();
+
+/// Records now − `since` (latency_now() time) under `stage`. A zero
+/// `since` is an unstamped reading and is ignored.
+void latency_record(LatencyStage stage, uint32_t since);
+
+/// Records a duration measured elsewhere.
+void latency_record_us(LatencyStage stage, uint32_t us);
+
+const char *latency_stage_name(LatencyStage stage);
+
+/// Takes every stage's histogram and writes them as one JSON document:
+///   {"ts":1700000000,"window_s":60,
+///    "read":{"n":60,"mean_ms":1.1,"p50_ms":1.0,"p90_ms":2.0,"p99_ms":2.0,
+///            "max_ms":1.9,"hist":[0,0,12,48,...]},"ui":{...},...}
+/// `ts` (wall clock at the end of the window) is left out while it is 0.
+/// Bucket bounds are LatencyHistogram's. Returns the length written.
+size_t latency_report_json(char *buf, size_t size, uint32_t unix_s, uint32_t window_s);
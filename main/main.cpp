@@ -1,14 +1,28 @@
+#include "boot_profile.hpp"
 #include "esp32_8048s043.hpp"
+#include "history.hpp"
+#include "history_log.hpp"
+#include "latency.hpp"
+#include "measurement_bus.hpp"
 #include "sen55.hpp"
+#include "sen55_mqtt.hpp"
+#include "telemetry.hpp"
+#include "time_sync.hpp"
 #include "ui.hpp"
 #include "device_id.hpp"
 #include "wifi.hpp"
 #include "mqtt.hpp"
 #include "ha_discovery.hpp"
+#include "espnow_bridge.hpp"
+#include "heap_audit.hpp"
+#include "task_plan.hpp"
 
+#include "sdkconfig.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_lvgl_port.h"
 #include "driver/i2c_master.h"
+#include "freertos/event_groups.h"
 
 #include <cstdio>
 #include <ctime>
@@ -18,64 +32,185 @@ namespace {
 const char *TAG = "main";
 constexpr auto kSen55Sda = GPIO_NUM_11;
 constexpr auto kSen55Scl = GPIO_NUM_12;
+constexpr uint32_t kUiPollMs = 100;
 
-// --- MQTT publishing for SEN55 readings ---
+MeasurementBus s_bus;
+Ui *s_ui{};
+EspNowBridge *s_bridge{};
 
-void publish_sen55(const Sen55::Measurement &m)
+// --- Display consumer ---
+
+// Runs as an LVGL timer, i.e. inside the LVGL task with the port lock
+// already held, so a reading is never dropped for want of the lock.
+void on_ui_timer(lv_timer_t *timer)
 {
-    if (!mqtt_is_connected()) return;
-
-    const char *id = device_id_get();
-    char topic[64];
-    char value[16];
-
-    struct { const char *entity; float val; int decimals; } fields[] = {
-        {"pm1_0",    m.pm1_0,       1},
-        {"pm2_5",    m.pm2_5,       1},
-        {"pm4_0",    m.pm4_0,       1},
-        {"pm10",     m.pm10,        1},
-        {"temp",     m.temperature, 1},
-        {"humidity", m.humidity,    1},
-        {"voc",      m.voc_index,   0},
-        {"nox",      m.nox_index,   0},
-    };
-
-    for (const auto &f : fields) {
-        std::snprintf(topic, sizeof(topic), "aqm/%s/sensor/%s", id, f.entity);
-        if (f.decimals == 0) {
-            std::snprintf(value, sizeof(value), "%d", static_cast<int>(f.val));
-        } else {
-            std::snprintf(value, sizeof(value), "%.1f", f.val);
-        }
-        mqtt_publish(topic, value);
+    auto *sub = static_cast<MeasurementBus::Subscriber *>(lv_timer_get_user_data(timer));
+    Sen55::Measurement m;
+    if (!sub->Pop(m)) return;
+
+    // Wall-clock time once SNTP has set it, uptime until then
+    char ts[32];
+    if (time_sync_valid()) {
+        const auto now = std::time(nullptr);
+        std::tm tm;
+        localtime_r(&now, &tm);
+        std::snprintf(ts, sizeof(ts), "Updated %02d:%02d:%02d",
+                      tm.tm_hour, tm.tm_min, tm.tm_sec);
+    } else {
+        const auto up_s = static_cast<long>(esp_timer_get_time() / 1'000'000);
+        std::snprintf(ts, sizeof(ts), "Up %ld:%02ld:%02ld",
+                      up_s / 3600, up_s / 60 % 60, up_s % 60);
+    }
+
+    s_ui->UpdateMeasurements(m);
+    latency_record(LatencyStage::kUi, m.read_us);
+    s_ui->SetStatus(ts);
+    s_ui->UpdateTrend();
+}
+
+// With no touch input, the display alternates between the cards and a
+// trend chart, stepping through each metric's last hour, then last day.
+void on_screen_timer(lv_timer_t * /*timer*/)
+{
+    static bool trend = false;
+    static size_t step = 0;
+
+    trend = !trend;
+    if (!trend) {
+        s_ui->ShowCards();
+        return;
+    }
+    const auto channel = static_cast<History::Channel>((step / 2) % History::kChannelCount);
+    const auto range = step % 2 ? Ui::TrendRange::kDay : Ui::TrendRange::kHour;
+    s_ui->ShowTrend(channel, range);
+    ++step;
+}
+
+void on_display_stats_timer(lv_timer_t * /*timer*/)
+{
+    esp32_8048s043::LogStats();
+
+    const auto st = s_ui->GetUpdateStats();
+    ESP_LOGI(TAG, "Cards: %lu redrawn in %lu refreshes, %lld us per card, "
+             "%lld us max refresh (glyph cache %s)",
+             static_cast<unsigned long>(st.cards_redrawn),
+             static_cast<unsigned long>(st.refreshes),
+             st.cards_redrawn ? static_cast<long long>(st.refresh_us / st.cards_redrawn) : 0LL,
+             static_cast<long long>(st.max_refresh_us),
+             s_ui->UsesGlyphCache() ? "on" : "off");
+}
+
+// --- History persistence ---
+
+// Refills the Minute/Hour tiers from flash, continues the time line after
+// the newest saved row, and saves every row that closes from now on.
+void restore_history(History &history)
+{
+    static auto minute_log = HistoryLog("hist_min", 60);
+    static auto hour_log = HistoryLog("hist_hour", 3600);
+
+    const size_t minutes = minute_log.Replay(CONFIG_AQM_HISTORY_MINUTE_HOURS * 60,
+        [&](const History::Row &row) { history.Restore(History::Tier::kMinute, row); });
+    const size_t hours = hour_log.Replay(CONFIG_AQM_HISTORY_HOUR_DAYS * 24,
+        [&](const History::Row &row) { history.Restore(History::Tier::kHour, row); });
+    ESP_LOGI(TAG, "History restored: %u minutes, %u hours",
+             static_cast<unsigned>(minutes), static_cast<unsigned>(hours));
+
+    uint32_t last = 0;
+    if (minute_log.LastTime(&last)) {
+        history.SetEpoch(last + 60);
     }
+    history.OnRow([](History::Tier tier, const History::Row &row) {
+        (tier == History::Tier::kMinute ? minute_log : hour_log).Append(row);
+    });
 }
 
 // --- MQTT callbacks ---
 
 void on_mqtt_connect()
 {
-    ha_discovery_publish_sen55(device_id_get());
+    boot_profile_mark(BootPhase::kMqttConnected);
+    ha_discovery_on_connect(device_id_get());
+    if (s_bridge) s_bridge->OnMqttConnect();
 }
 
-void on_mqtt_data(const char * /*topic*/, int /*topic_len*/,
-                  const char * /*data*/, int /*data_len*/)
+void on_mqtt_data(const char *topic, int topic_len, const char *data, int data_len,
+                  int offset, int total_len)
+{
+    if (ha_discovery_on_data(topic, topic_len, data, data_len, offset, total_len)) return;
+    if (s_bridge) s_bridge->OnMqttData(topic, topic_len, data, data_len, offset, total_len);
+}
+
+// --- Boot ---
+//
+// Each step starts as soon as what it needs is ready, not when the one
+// before it in the source is done:
+//
+//   app_main (core 0)  identity → Wi-Fi → sensor → history ─┐   IP → MQTT
+//   boot_ui  (core 1)  panel + LVGL → screen ───────────────┴→ trends
+//
+// Wi-Fi association, the SEN55's first measurement and panel init overlap,
+// and MQTT starts the moment there is an IP. boot_profile records when
+// each step finished, up to the first published reading.
+
+constexpr EventBits_t kHistoryReady = BIT0;
+EventGroupHandle_t s_boot{};
+StaticEventGroup_t s_boot_buf{};
+History *s_history{};
+
+void boot_ui_task(void * /*arg*/)
 {
-    // No subscriptions in Phase 1 — will be used by ESP-NOW gateway in Phase 2
+    ESP_ERROR_CHECK(esp32_8048s043::Init());
+    boot_profile_mark(BootPhase::kDisplayReady);
+
+    // UI (static lifetime), fed from the bus
+    if (lvgl_port_lock(0)) {
+        static auto ui_obj = Ui();
+        s_ui = &ui_obj;
+        auto *sub = s_bus.Subscribe("ui", MeasurementBus::Mode::kLatest);
+        lv_timer_create(on_ui_timer, kUiPollMs, sub);
+        if (CONFIG_AQM_DISPLAY_STATS_INTERVAL_S > 0) {
+            lv_timer_create(on_display_stats_timer,
+                            CONFIG_AQM_DISPLAY_STATS_INTERVAL_S * 1000, nullptr);
+        }
+        lvgl_port_unlock();
+    }
+    boot_profile_mark(BootPhase::kUiReady);
+
+    // Trend screens once the history is back from flash
+    xEventGroupWaitBits(s_boot, kHistoryReady, pdFALSE, pdTRUE, portMAX_DELAY);
+    if (lvgl_port_lock(0)) {
+        s_ui->SetHistory(s_history);
+        if (CONFIG_AQM_UI_TREND_DWELL_S > 0) {
+            lv_timer_create(on_screen_timer, CONFIG_AQM_UI_TREND_DWELL_S * 1000, nullptr);
+        }
+        lvgl_port_unlock();
+    }
+    esp32_8048s043::BenchRedraw(CONFIG_AQM_DISPLAY_REDRAW_BENCH_FRAMES);
+    vTaskDelete(nullptr);
 }
 
 } // namespace
 
 extern "C" void app_main()
 {
-    // 1. Display + LVGL
-    ESP_ERROR_CHECK(esp32_8048s043::Init());
+    boot_profile_mark(BootPhase::kAppMain);
+    s_boot = xEventGroupCreateStatic(&s_boot_buf);
 
-    // 2. Device identity
+    // 1. Device identity
     device_id_init();
     ESP_LOGI(TAG, "Device ID: %s", device_id_get());
 
-    // 3. SEN55 I2C bus
+    // 2. WiFi: association runs in the Wi-Fi task from here on
+    wifi_init();
+    time_sync_init();
+    boot_profile_mark(BootPhase::kWifiStarted);
+
+    // 3. Display, LVGL and the UI, on core 1
+    task_plan::Create(task_plan::kBootUi, boot_ui_task, nullptr);
+
+    // 4. Sensor — starts measuring immediately, publishes at ~1 Hz.
+    // Consumers (display, MQTT, history) pull from the bus at their own pace.
     i2c_master_bus_config_t bus_cfg{};
     bus_cfg.i2c_port = I2C_NUM_1;
     bus_cfg.sda_io_num = kSen55Sda;
@@ -86,42 +221,40 @@ extern "C" void app_main()
     i2c_master_bus_handle_t sen55_bus{};
     ESP_ERROR_CHECK(i2c_new_master_bus(&bus_cfg, &sen55_bus));
 
-    // 4. UI (static lifetime — outlives app_main)
-    static Ui *ui = nullptr;
-    if (lvgl_port_lock(0)) {
-        static auto ui_obj = Ui();
-        ui = &ui_obj;
-        lvgl_port_unlock();
-    }
-
-    // 5. Sensor — starts measuring immediately, calls back at ~1 Hz
+    sen55_mqtt_start(s_bus);
     static auto sensor = Sen55(sen55_bus, [](const Sen55::Measurement &m) {
-        auto now = std::time(nullptr);
-        auto *tm = std::localtime(&now);
-        char ts[32];
-        std::snprintf(ts, sizeof(ts), "Updated %02d:%02d:%02d",
-                      tm->tm_hour, tm->tm_min, tm->tm_sec);
-
-        // Update display
-        if (lvgl_port_lock(0)) {
-            ui->UpdateMeasurements(m);
-            ui->SetStatus(ts);
-            lvgl_port_unlock();
-        }
+        boot_profile_mark(BootPhase::kFirstReading);
+        s_bus.Publish(m);
+    });
+    boot_profile_mark(BootPhase::kSensorStarted);
+#if CONFIG_AQM_TELEMETRY
+    telemetry_start(&sensor);
+#endif
 
-        // Publish to MQTT
-        publish_sen55(m);
+    // 5. History in PSRAM, refilled from flash while the sensor warms up
+    static auto history = History({
+        .raw = CONFIG_AQM_HISTORY_RAW_SECONDS,
+        .minute = CONFIG_AQM_HISTORY_MINUTE_HOURS * 60,
+        .hour = CONFIG_AQM_HISTORY_HOUR_DAYS * 24,
     });
+    restore_history(history);
+    history.Start(s_bus);
+    s_history = &history;
+    xEventGroupSetBits(s_boot, kHistoryReady);
+    boot_profile_mark(BootPhase::kHistoryRestored);
 
-    // 6. WiFi + MQTT
-    wifi_init();
-    if (wifi_wait_connected(15000)) {
-        ESP_LOGI(TAG, "WiFi connected");
-    } else {
-        ESP_LOGW(TAG, "WiFi not connected yet — will auto-reconnect");
-    }
+    // 6. ESP-NOW nodes, on the radio Wi-Fi already started; before MQTT
+    // so the first connect subscribes to their commands
+#if CONFIG_AQM_ESPNOW
+    static auto bridge = EspNowBridge(MakeEspNowWifiTransport());
+    s_bridge = &bridge;
+#endif
 
+    // 7. MQTT as soon as there is an IP (wifi_wait_connected() also
+    // returns on each failed attempt; the reconnect timer keeps trying)
+    while (!wifi_wait_connected(60 * 1000)) {}
     mqtt_init(device_id_get(), on_mqtt_connect, on_mqtt_data);
+    heap_audit_start();
 
     ESP_LOGI(TAG, "Air quality monitor + gateway running");
 }
@@ -0,0 +1,106 @@
+#include "measurement_bus.hpp"
+
+#include <algorithm>
+
+// Latest-value slots are a seqlock on head_: odd while the publisher is
+// writing slots_[0], even once it is stable. Sequence / 2 counts readings,
+// so the consumer can tell how many it skipped.
+
+MeasurementBus::Subscriber* MeasurementBus::Subscribe(const char* name, Mode mode,
+                                                      size_t depth, TaskHandle_t notify)
+{
+    if (mode == Mode::kQueue &&
+        (depth == 0 || depth > kMaxQueueDepth || (depth & (depth - 1)) != 0)) {
+        return nullptr;
+    }
+    const auto index = reserved_.fetch_add(1, std::memory_order_relaxed);
+    if (index >= kMaxSubscribers) {
+        reserved_.fetch_sub(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    auto& sub = subs_[index];
+    sub.name_ = name;
+    sub.mode_ = mode;
+    sub.depth_ = mode == Mode::kQueue ? static_cast<uint32_t>(depth) : 1;
+    sub.notify_ = notify;
+    sub.active_.store(true, std::memory_order_release);
+    return &sub;
+}
+
+void MeasurementBus::Publish(const Sen55::Measurement& m)
+{
+    const auto n = std::min(reserved_.load(std::memory_order_acquire), kMaxSubscribers);
+    for (size_t i = 0; i < n; ++i) {
+        auto& sub = subs_[i];
+        if (!sub.active_.load(std::memory_order_acquire)) {
+            continue;
+        }
+        sub.Push(m);
+        if (sub.notify_) {
+            xTaskNotifyGive(sub.notify_);
+        }
+    }
+    published_.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t MeasurementBus::SubscriberCount() const
+{
+    return std::min(reserved_.load(std::memory_order_acquire), kMaxSubscribers);
+}
+
+void MeasurementBus::Subscriber::Push(const Sen55::Measurement& m)
+{
+    const auto head = head_.load(std::memory_order_relaxed);
+
+    if (mode_ == Mode::kLatest) {
+        head_.store(head + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slots_[0] = m;
+        head_.store(head + 2, std::memory_order_release);
+        return;
+    }
+
+    if (head - tail_.load(std::memory_order_acquire) >= depth_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    slots_[head & (depth_ - 1)] = m;
+    head_.store(head + 1, std::memory_order_release);
+}
+
+bool MeasurementBus::Subscriber::Pop(Sen55::Measurement& out)
+{
+    if (mode_ == Mode::kLatest) {
+        for (;;) {
+            const auto before = head_.load(std::memory_order_acquire);
+            if (before == seen_) {
+                return false;
+            }
+            if (before & 1) {
+                continue;  // publisher mid-write; it finishes in a few cycles
+            }
+            out = slots_[0];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (head_.load(std::memory_order_relaxed) != before) {
+                continue;
+            }
+            const auto skipped = (before - seen_) / 2 - 1;
+            if (skipped > 0) {
+                dropped_.fetch_add(skipped, std::memory_order_relaxed);
+            }
+            seen_ = before;
+            delivered_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    out = slots_[tail & (depth_ - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    delivered_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "sen55.hpp"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Fan-out of sensor readings from the acquisition task to independent
+ * consumers (display, MQTT, history, gateway, ...).
+ *
+ * Publish() never blocks and never allocates. Each subscriber owns either a
+ * latest-value slot or a small single-producer/single-consumer FIFO, so a
+ * slow consumer only loses its own readings, which its drop counter records.
+ *
+ * One publishing task. Each subscriber is drained by exactly one consumer.
+ * Subscribe() may be called at any time, including from consumer tasks.
+ */
+class MeasurementBus {
+public:
+    static constexpr size_t kMaxSubscribers = 6;
+    static constexpr size_t kMaxQueueDepth = 16;
+
+    enum class Mode {
+        kLatest,  // newest reading only; unread ones count as dropped
+        kQueue,   // FIFO; readings that arrive while it is full are dropped
+    };
+
+    class Subscriber {
+    public:
+        /** Takes the next reading. Returns false if there is nothing new. */
+        bool Pop(Sen55::Measurement& out);
+
+        const char* Name() const { return name_; }
+        uint32_t Delivered() const { return delivered_.load(std::memory_order_relaxed); }
+        uint32_t Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    private:
+        friend class MeasurementBus;
+
+        void Push(const Sen55::Measurement& m);
+
+        const char* name_{};
+        Mode mode_{};
+        uint32_t depth_{};
+        TaskHandle_t notify_{};
+        std::atomic<bool> active_{false};
+
+        std::array<Sen55::Measurement, kMaxQueueDepth> slots_{};
+        std::atomic<uint32_t> head_{0};  // publisher: queue write index / slot sequence
+        std::atomic<uint32_t> tail_{0};  // consumer: queue read index
+        uint32_t seen_{0};               // consumer: last slot sequence read
+        std::atomic<uint32_t> delivered_{0};
+        std::atomic<uint32_t> dropped_{0};
+    };
+
+    /**
+     * Registers a consumer. `depth` applies to kQueue and must be a power of
+     * two no larger than kMaxQueueDepth. If `notify` is set, that task gets
+     * a task notification (xTaskNotifyGive) on every publish. Returns
+     * nullptr when the subscriber table is full or the depth is invalid.
+     */
+    Subscriber* Subscribe(const char* name, Mode mode, size_t depth = 1,
+                          TaskHandle_t notify = nullptr);
+
+    /** Hands `m` to every subscriber. Called from the acquisition task. */
+    void Publish(const Sen55::Measurement& m);
+
+    uint32_t Published() const { return published_.load(std::memory_order_relaxed); }
+    size_t SubscriberCount() const;
+    const Subscriber& At(size_t index) const { return subs_[index]; }
+
+private:
+    std::array<Subscriber, kMaxSubscribers> subs_{};
+    std::atomic<size_t> reserved_{0};
+    std::atomic<uint32_t> published_{0};
+};
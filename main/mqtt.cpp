@@ -1,5 +1,7 @@
 #include "mqtt.hpp"
 #include "credentials.h"
+#include "heap_audit.hpp"
+#include "task_plan.hpp"
 
 #include <cstdio>
 #include <cstring>
@@ -15,6 +17,7 @@ esp_mqtt_client_handle_t s_client{};
 bool s_connected{false};
 mqtt_connect_cb_t s_on_connect{};
 mqtt_data_cb_t s_on_data{};
+mqtt_published_cb_t s_on_published{};
 
 char s_availability_topic[64]{};
 
@@ -43,7 +46,14 @@ void event_handler(void * /*arg*/, esp_event_base_t /*base*/,
     case MQTT_EVENT_DATA:
         if (s_on_data) {
             s_on_data(event->topic, event->topic_len,
-                      event->data, event->data_len);
+                      event->data, event->data_len,
+                      event->current_data_offset, event->total_data_len);
+        }
+        break;
+
+    case MQTT_EVENT_PUBLISHED:
+        if (s_on_published) {
+            s_on_published(event->msg_id);
         }
         break;
 
@@ -76,6 +86,9 @@ esp_err_t mqtt_init(const char *device_id,
     cfg.session.last_will.qos = 1;
     cfg.session.last_will.retain = 1;
     cfg.session.keepalive = 60;
+    // Core: CONFIG_MQTT_USE_CORE_0 (see task_plan.hpp)
+    cfg.task.priority = task_plan::kMqtt.priority;
+    cfg.task.stack_size = task_plan::kMqtt.stack;
 
     s_client = esp_mqtt_client_init(&cfg);
     if (!s_client) {
@@ -92,20 +105,46 @@ esp_err_t mqtt_init(const char *device_id,
     return ESP_OK;
 }
 
+void mqtt_set_published_cb(mqtt_published_cb_t cb)
+{
+    s_on_published = cb;
+}
+
 bool mqtt_is_connected()
 {
     return s_connected;
 }
 
+int mqtt_outbox_bytes()
+{
+    return s_client ? esp_mqtt_client_get_outbox_size(s_client) : 0;
+}
+
 int mqtt_publish(const char *topic, const char *data,
                  int qos, bool retain)
 {
     if (!s_client) return -1;
-    return esp_mqtt_client_publish(s_client, topic, data, 0, qos, retain ? 1 : 0);
+    // QoS 1/2 messages are copied into esp-mqtt's outbox in this task
+    heap_audit_mqtt_begin();
+    const int msg_id = esp_mqtt_client_publish(s_client, topic, data, 0, qos, retain ? 1 : 0);
+    heap_audit_mqtt_end();
+    return msg_id;
 }
 
 int mqtt_subscribe(const char *topic, int qos)
 {
     if (!s_client) return -1;
-    return esp_mqtt_client_subscribe(s_client, topic, qos);
+    heap_audit_mqtt_begin();
+    const int msg_id = esp_mqtt_client_subscribe(s_client, topic, qos);
+    heap_audit_mqtt_end();
+    return msg_id;
+}
+
+int mqtt_unsubscribe(const char *topic)
+{
+    if (!s_client) return -1;
+    heap_audit_mqtt_begin();
+    const int msg_id = esp_mqtt_client_unsubscribe(s_client, topic);
+    heap_audit_mqtt_end();
+    return msg_id;
 }
@@ -2,14 +2,21 @@
 
 #include "esp_err.h"
 
-/// Callback for incoming MQTT data.
+/// Callback for incoming MQTT data. A message larger than the esp-mqtt
+/// buffer arrives in pieces, in order: this one starts at `offset` of a
+/// `total_len` payload, and only the first carries the topic.
 using mqtt_data_cb_t = void (*)(const char *topic, int topic_len,
-                                const char *data, int data_len);
+                                const char *data, int data_len,
+                                int offset, int total_len);
 
 /// Callback invoked on every MQTT connect (including reconnects).
 /// Use to publish discovery, subscribe to topics, etc.
 using mqtt_connect_cb_t = void (*)();
 
+/// Callback for MQTT_EVENT_PUBLISHED: the broker acknowledged `msg_id`
+/// (QoS 1 and 2 only). Runs in the esp-mqtt task.
+using mqtt_published_cb_t = void (*)(int msg_id);
+
 /// Initialise MQTT client with LWT on the availability topic.
 /// \param device_id  Used to build the availability topic: aqm/<device_id>/availability
 /// \param on_connect Called on every MQTT_EVENT_CONNECTED
@@ -18,12 +25,22 @@ esp_err_t mqtt_init(const char *device_id,
                     mqtt_connect_cb_t on_connect,
                     mqtt_data_cb_t on_data);
 
+/// Set (or clear, with nullptr) the PUBACK callback.
+void mqtt_set_published_cb(mqtt_published_cb_t cb);
+
 /// True if the MQTT client is currently connected.
 bool mqtt_is_connected();
 
+/// Bytes esp-mqtt holds for QoS 1/2 messages awaiting acknowledgement
+/// (and QoS 0 ones queued while disconnected). 0 before mqtt_init().
+int mqtt_outbox_bytes();
+
 /// Publish a message. Returns the message ID or -1 on error.
 int mqtt_publish(const char *topic, const char *data,
                  int qos = 0, bool retain = false);
 
 /// Subscribe to a topic. Returns the message ID or -1 on error.
 int mqtt_subscribe(const char *topic, int qos = 0);
+
+/// Unsubscribe from a topic. Returns the message ID or -1 on error.
+int mqtt_unsubscribe(const char *topic);
@@ -0,0 +1,310 @@
+#include "outbox.hpp"
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+static const char* TAG = "outbox";
+
+/* ── Flash layout ────────────────────────────────────────────────────── */
+
+// Each 4 KiB sector holds one spill: a header followed by `count` records.
+// A sector is live until all of its records are replayed; it is then
+// marked consumed by clearing `live` (a 1→0 write, no erase) and erased
+// only when the ring wraps back onto it.
+
+namespace {
+
+constexpr uint32_t kSectorSize = 4096;
+constexpr uint32_t kMagic = 0x3158424F;  // "OBX1"
+constexpr uint32_t kLive = 0xFFFFFFFF;
+
+struct SectorHeader {
+    uint32_t magic;
+    uint32_t seq;          // spill number, orders sectors
+    uint16_t count;
+    uint16_t record_size;
+    uint32_t live;         // kLive until fully replayed, then 0
+};
+
+constexpr size_t kRecordsPerSector =
+    (kSectorSize - sizeof(SectorHeader)) / sizeof(Outbox::Record);
+
+static_assert(sizeof(Outbox::Record) == 56, "flash record layout changed");
+static_assert(kRecordsPerSector > 0);
+
+} // namespace
+
+/* ── Implementation ──────────────────────────────────────────────────── */
+
+struct Outbox::Impl {
+    struct Sector {
+        uint32_t seq;
+        uint16_t count;
+        uint16_t index;
+    };
+
+    // PSRAM ring
+    Record* ram{};
+    size_t ram_capacity{};
+    size_t ram_head{};   // next write
+    size_t ram_count{};
+
+    // Flash spill, oldest live sector first
+    const esp_partition_t* part{};
+    size_t sector_count{};
+    std::vector<Sector> live;   // reserved to sector_count at start-up
+    size_t read_offset{};       // records already replayed from live.front()
+    uint32_t next_sector_seq{1};
+    size_t next_sector{};
+    std::vector<uint8_t> sector_buf;
+
+    uint32_t next_seq{1};
+    uint16_t boot_id{};
+
+    std::atomic<uint32_t> flash_depth{0};
+    std::atomic<uint32_t> high_water{0};
+    std::atomic<uint32_t> spilled{0};
+    std::atomic<uint32_t> dropped{0};
+    std::atomic<uint32_t> replayed{0};
+    std::atomic<uint32_t> ram_depth{0};
+
+    Record& RamAt(size_t i)  // i-th oldest
+    {
+        return ram[(ram_head + ram_capacity - ram_count + i) % ram_capacity];
+    }
+
+    uint32_t Depth() const { return ram_depth + flash_depth; }
+
+    void UpdateDepth()
+    {
+        ram_depth = static_cast<uint32_t>(ram_count);
+        high_water = std::max<uint32_t>(high_water, Depth());
+    }
+
+    /** Rebuilds the live-sector list and the next sequence numbers. */
+    void Scan()
+    {
+        live.reserve(sector_count);
+        uint32_t max_sector_seq = 0;
+        uint32_t newest_index = 0;
+        bool any = false;
+
+        for (size_t i = 0; i < sector_count; ++i) {
+            SectorHeader h{};
+            if (esp_partition_read(part, i * kSectorSize, &h, sizeof(h)) != ESP_OK ||
+                h.magic != kMagic || h.record_size != sizeof(Record) ||
+                h.count == 0 || h.count > kRecordsPerSector) {
+                continue;
+            }
+            if (!any || h.seq > max_sector_seq) {
+                max_sector_seq = h.seq;
+                newest_index = static_cast<uint32_t>(i);
+                any = true;
+            }
+            if (h.live == kLive) {
+                live.push_back({h.seq, h.count, static_cast<uint16_t>(i)});
+                flash_depth += h.count;
+            }
+        }
+        std::sort(live.begin(), live.end(),
+                  [](const Sector& a, const Sector& b) { return a.seq < b.seq; });
+
+        if (any) {
+            next_sector_seq = max_sector_seq + 1;
+            next_sector = (newest_index + 1) % sector_count;
+
+            // Continue record numbering after the newest record on flash
+            SectorHeader h{};
+            esp_partition_read(part, newest_index * kSectorSize, &h, sizeof(h));
+            Record last{};
+            esp_partition_read(part, newest_index * kSectorSize + sizeof(SectorHeader) +
+                                     (h.count - 1) * sizeof(Record),
+                               &last, sizeof(last));
+            next_seq = last.seq + 1;
+        }
+        ESP_LOGI(TAG, "%u records pending in %u flash sectors",
+                 static_cast<unsigned>(flash_depth.load()), static_cast<unsigned>(live.size()));
+    }
+
+    /** Moves the oldest RAM records into the next flash sector. */
+    void Spill()
+    {
+        // Ring full of unreplayed sectors: give up the oldest one.
+        if (live.size() == sector_count) {
+            const auto lost = live.front().count - read_offset;
+            dropped += static_cast<uint32_t>(lost);
+            flash_depth -= static_cast<uint32_t>(lost);
+            live.erase(live.begin());
+            read_offset = 0;
+        }
+
+        const size_t n = std::min(kRecordsPerSector, ram_count);
+        SectorHeader h{kMagic, next_sector_seq, static_cast<uint16_t>(n),
+                       static_cast<uint16_t>(sizeof(Record)), kLive};
+        std::memcpy(sector_buf.data(), &h, sizeof(h));
+        for (size_t i = 0; i < n; ++i) {
+            std::memcpy(sector_buf.data() + sizeof(h) + i * sizeof(Record),
+                        &RamAt(i), sizeof(Record));
+        }
+
+        const size_t offset = next_sector * kSectorSize;
+        const size_t bytes = sizeof(h) + n * sizeof(Record);
+        if (esp_partition_erase_range(part, offset, kSectorSize) != ESP_OK ||
+            esp_partition_write(part, offset, sector_buf.data(), bytes) != ESP_OK) {
+            ESP_LOGE(TAG, "Spill to sector %u failed", static_cast<unsigned>(next_sector));
+            dropped += static_cast<uint32_t>(n);
+        } else {
+            live.push_back({next_sector_seq, static_cast<uint16_t>(n),
+                            static_cast<uint16_t>(next_sector)});
+            flash_depth += static_cast<uint32_t>(n);
+            spilled += static_cast<uint32_t>(n);
+        }
+        ram_count -= n;
+        ++next_sector_seq;
+        next_sector = (next_sector + 1) % sector_count;
+    }
+
+    void ConsumeFlashSector()
+    {
+        const auto& s = live.front();
+        constexpr uint32_t kConsumed = 0;
+        esp_partition_write(part, s.index * kSectorSize + offsetof(SectorHeader, live),
+                            &kConsumed, sizeof(kConsumed));
+        live.erase(live.begin());
+        read_offset = 0;
+    }
+};
+
+/* ── Outbox public methods ───────────────────────────────────────────── */
+
+Outbox::Outbox(size_t ram_capacity, const char* partition_label)
+    : impl_(std::make_unique<Impl>())
+{
+    auto& d = *impl_;
+    d.boot_id = static_cast<uint16_t>(esp_random());
+    d.ram_capacity = std::max<size_t>(ram_capacity, 1);
+    d.ram = static_cast<Record*>(
+        heap_caps_malloc(d.ram_capacity * sizeof(Record), MALLOC_CAP_SPIRAM));
+    if (!d.ram) {
+        ESP_LOGW(TAG, "No PSRAM for %u records, using internal RAM",
+                 static_cast<unsigned>(d.ram_capacity));
+        d.ram = static_cast<Record*>(
+            heap_caps_malloc(d.ram_capacity * sizeof(Record), MALLOC_CAP_DEFAULT));
+    }
+    assert(d.ram);
+
+    if (partition_label) {
+        d.part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                          ESP_PARTITION_SUBTYPE_ANY, partition_label);
+        if (!d.part) {
+            ESP_LOGW(TAG, "Partition '%s' not found, RAM only", partition_label);
+        }
+    }
+    if (d.part) {
+        d.sector_count = d.part->size / kSectorSize;
+        d.sector_buf.resize(kSectorSize);
+        d.Scan();
+    }
+    d.UpdateDepth();
+}
+
+Outbox::~Outbox()
+{
+    heap_caps_free(impl_->ram);
+}
+
+void Outbox::Push(uint32_t unix_s, const Sen55::Measurement& m)
+{
+    auto& d = *impl_;
+
+    if (d.ram_count == d.ram_capacity) {
+        if (d.part) {
+            d.Spill();
+        } else {
+            --d.ram_count;  // overwrite the oldest
+            ++d.dropped;
+        }
+    }
+
+    d.ram[d.ram_head] = {d.next_seq++, unix_s, esp_timer_get_time(), d.boot_id, 0, m};
+    d.ram_head = (d.ram_head + 1) % d.ram_capacity;
+    ++d.ram_count;
+    d.UpdateDepth();
+}
+
+size_t Outbox::Peek(Record* out, size_t max)
+{
+    auto& d = *impl_;
+
+    if (!d.live.empty()) {
+        const auto& s = d.live.front();
+        const size_t n = std::min<size_t>(max, s.count - d.read_offset);
+        const size_t offset = s.index * kSectorSize + sizeof(SectorHeader) +
+                              d.read_offset * sizeof(Record);
+        if (esp_partition_read(d.part, offset, out, n * sizeof(Record)) != ESP_OK) {
+            return 0;
+        }
+        return n;
+    }
+
+    const size_t n = std::min(max, d.ram_count);
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = d.RamAt(i);
+    }
+    return n;
+}
+
+void Outbox::Pop(size_t count)
+{
+    auto& d = *impl_;
+
+    while (count > 0 && !d.live.empty()) {
+        const size_t n = std::min<size_t>(count, d.live.front().count - d.read_offset);
+        d.read_offset += n;
+        d.flash_depth -= static_cast<uint32_t>(n);
+        d.replayed += static_cast<uint32_t>(n);
+        count -= n;
+        if (d.read_offset == d.live.front().count) {
+            d.ConsumeFlashSector();
+        }
+    }
+
+    const size_t n = std::min(count, d.ram_count);
+    d.ram_count -= n;
+    d.replayed += static_cast<uint32_t>(n);
+    d.UpdateDepth();
+}
+
+bool Outbox::Empty() const
+{
+    return impl_->Depth() == 0;
+}
+
+Outbox::Stats Outbox::GetStats() const
+{
+    const auto& d = *impl_;
+    return {
+        .depth = d.Depth(),
+        .ram_depth = d.ram_depth,
+        .flash_depth = d.flash_depth,
+        .high_water = d.high_water,
+        .spilled = d.spilled,
+        .dropped = d.dropped,
+        .replayed = d.replayed,
+    };
+}
+
+uint16_t Outbox::BootId() const
+{
+    return impl_->boot_id;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "sen55.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Bounded store-and-forward queue for readings taken while MQTT is down.
+ *
+ * Records go into a ring in PSRAM. When the ring fills, its oldest records
+ * move a whole flash sector at a time to a dedicated partition, so flash is
+ * only written during long outages and each sector is erased once per pass
+ * around the partition. Flash contents survive a reboot. When both are
+ * full, the oldest records are dropped.
+ *
+ * Drained oldest-first with Peek() + Pop(). Not thread-safe apart from
+ * GetStats(): push and drain from one task.
+ */
+class Outbox {
+public:
+    struct Record {
+        uint32_t seq;        // increases per push; restarts at 1 on a boot with no flash backlog
+        uint32_t unix_s;     // wall clock at capture, 0 if not yet set
+        int64_t mono_us;     // esp_timer time at capture (meaningful for boot_id only)
+        uint16_t boot_id;    // random per boot; (boot_id, seq) identifies a record
+        uint16_t reserved;
+        Sen55::Measurement m;
+    };
+
+    struct Stats {
+        uint32_t depth;        // records waiting, RAM + flash
+        uint32_t ram_depth;
+        uint32_t flash_depth;
+        uint32_t high_water;   // largest depth since boot
+        uint32_t spilled;      // records moved from RAM to flash
+        uint32_t dropped;      // oldest records discarded while full
+        uint32_t replayed;     // records confirmed sent through Pop()
+    };
+
+    /**
+     * `ram_capacity` records in PSRAM. `partition_label` names a data
+     * partition to spill to; nullptr or a missing partition means RAM only.
+     */
+    Outbox(size_t ram_capacity, const char* partition_label);
+    ~Outbox();
+
+    void Push(uint32_t unix_s, const Sen55::Measurement& m);
+
+    /** Copies up to `max` of the oldest records without removing them. */
+    size_t Peek(Record* out, size_t max);
+
+    /** Removes the `count` oldest records, normally after sending a Peek(). */
+    void Pop(size_t count);
+
+    bool Empty() const;
+    Stats GetStats() const;
+
+    /** Identifies this boot in Record::boot_id. */
+    uint16_t BootId() const;
+
+    Outbox(const Outbox&) = delete;
+    Outbox& operator=(const Outbox&) = delete;
+    Outbox(Outbox&&) = delete;
+    Outbox& operator=(Outbox&&) = delete;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
@@ -1,24 +1,36 @@
 #include "sen55.hpp"
+#include "latency.hpp"
+#include "sen55_frame.hpp"
+#include "sen55_transport.hpp"
+#include "task_plan.hpp"
 
 #include "esp_check.h"
 #include "esp_log.h"
-#include "driver/i2c_master.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 
 static const char* TAG = "sen55";
 
 /* ── Implementation ──────────────────────────────────────────────────── */
 
-struct Sen55::Impl {
-    static constexpr uint8_t kAddress = 0x69;
-    static constexpr uint32_t kI2cSpeedHz = 10'000;
-    static constexpr int kI2cTimeoutMs = 100;
-    static constexpr int kPollIntervalMs = 1'000;
+// Acquisition is a small state machine stepped by a one-shot esp_timer.
+// The task sleeps on a semaphore between steps instead of vTaskDelay, so
+// the only time spent blocked is the I2C transfer itself.
+//
+// The sensor updates on its own ~1 Hz clock. Each cycle the first
+// data-ready probe is aimed kLeadUs before the predicted update, then
+// repeated every kProbeGapUs until the flag is set. The update therefore
+// lies between the last "not ready" probe and the first "ready" one; its
+// midpoint feeds the phase and period estimates for the next cycle.
 
+struct Sen55::Impl {
     static constexpr uint16_t kCmdStartMeasurement = 0x0021;
     static constexpr uint16_t kCmdStopMeasurement = 0x0104;
     static constexpr uint16_t kCmdReadDataReady = 0x0202;
@@ -26,24 +38,41 @@ struct Sen55::Impl {
 
     static constexpr int kDelayStartMs = 50;
     static constexpr int kDelayStopMs = 200;
-    static constexpr int kDelayCmdMs = 20;
 
-    i2c_master_dev_handle_t dev{};
+    static constexpr int64_t kCmdExecUs = 20'000;          // command → response ready
+    static constexpr int64_t kNominalPeriodUs = 1'000'000;  // sensor update interval
+    static constexpr int64_t kMinPeriodUs = 900'000;
+    static constexpr int64_t kMaxPeriodUs = 1'100'000;
+    static constexpr int64_t kFirstProbeUs = 900'000;       // start → first probe
+    static constexpr int64_t kLeadUs = 30'000;              // probe this early
+    static constexpr int64_t kProbeGapUs = 10'000;          // response → next probe
+    static constexpr int64_t kErrorBackoffUs = 100'000;
+
+    enum class State { kRequestReady, kFetchReady, kFetchValues };
+
+    std::unique_ptr<Sen55Transport> io;
     Callback cb;
     TaskHandle_t task{};
+    esp_timer_handle_t timer{};
+    SemaphoreHandle_t wake{};
+    StaticSemaphore_t wake_buf{};
 
-    static uint8_t Crc8(const uint8_t* data, size_t len)
-    {
-        constexpr uint8_t kPoly = 0x31;
-        uint8_t crc = 0xFF;
-        for (size_t i = 0; i < len; ++i) {
-            crc ^= data[i];
-            for (int bit = 0; bit < 8; ++bit) {
-                crc = (crc & 0x80) ? ((crc << 1) ^ kPoly) : (crc << 1);
-            }
-        }
-        return crc;
-    }
+    State state{State::kRequestReady};
+    int64_t probe_us{};          // when the current data-ready probe was sent
+    int64_t not_ready_us{-1};    // last "not ready" probe this cycle
+    int64_t edge_us{-1};         // estimated time of the latest sensor update
+    bool reread{};               // a read of the sample at edge_us failed; retrying it
+    int64_t period_us{kNominalPeriodUs};
+    sen55_frame::MeasuredWords last_words{};
+
+    std::atomic<uint32_t> samples{0};
+    std::atomic<uint32_t> missed{0};
+    std::atomic<uint32_t> duplicates{0};
+    std::atomic<uint32_t> not_ready{0};
+    std::atomic<uint32_t> i2c_errors{0};
+    std::atomic<uint32_t> crc_errors{0};
+    std::atomic<int64_t> last_sample_us{-1};
+    std::atomic<int64_t> max_latency_us{0};
 
     esp_err_t SendCommand(uint16_t cmd)
     {
@@ -51,111 +80,238 @@ struct Sen55::Impl {
             static_cast<uint8_t>(cmd >> 8),
             static_cast<uint8_t>(cmd & 0xFF),
         };
-        return i2c_master_transmit(dev, buf.data(), buf.size(), kI2cTimeoutMs);
+        return io->Transmit(buf.data(), buf.size());
     }
 
-    esp_err_t ReadWords(uint16_t cmd, uint16_t* words, size_t count)
+    esp_err_t FetchWords(uint16_t* words, size_t count)
     {
-        const std::array<uint8_t, 2> cmd_buf = {
-            static_cast<uint8_t>(cmd >> 8),
-            static_cast<uint8_t>(cmd & 0xFF),
-        };
-
-        const auto rx_len = count * 3;
-        uint8_t rx[24];
+        const auto rx_len = count * sen55_frame::kBytesPerWord;
+        uint8_t rx[sen55_frame::kMeasuredWordCount * sen55_frame::kBytesPerWord];
         assert(rx_len <= sizeof(rx));
 
-        auto err = i2c_master_transmit(dev, cmd_buf.data(), cmd_buf.size(), kI2cTimeoutMs);
+        auto err = io->Receive(rx, rx_len);
         if (err != ESP_OK) {
             return err;
         }
-        vTaskDelay(pdMS_TO_TICKS(kDelayCmdMs));
-        err = i2c_master_receive(dev, rx, rx_len, kI2cTimeoutMs);
-        if (err != ESP_OK) {
-            return err;
+        return sen55_frame::DecodeWords(rx, words, count);
+    }
+
+    void CountError(esp_err_t err, const char* what)
+    {
+        if (err == ESP_ERR_INVALID_CRC) {
+            ++crc_errors;
+        } else {
+            ++i2c_errors;
         }
+        ESP_LOGE(TAG, "%s failed: %s", what, esp_err_to_name(err));
+    }
+
+    void Arm(int64_t delay_us)
+    {
+        ESP_ERROR_CHECK(esp_timer_start_once(timer, std::max<int64_t>(delay_us, 0)));
+    }
+
+    /** Restart the cycle with a fresh data-ready probe after `delay_us`. */
+    void Reprobe(int64_t delay_us)
+    {
+        state = State::kRequestReady;
+        Arm(delay_us);
+    }
 
-        for (size_t i = 0; i < count; ++i) {
-            const auto* triplet = &rx[i * 3];
-            if (auto expected = Crc8(triplet, 2); triplet[2] != expected) {
-                ESP_LOGE(TAG, "CRC mismatch at word %zu: got 0x%02X, expected 0x%02X",
-                         i, triplet[2], expected);
-                return ESP_ERR_INVALID_CRC;
+    /** Folds a newly observed update into the phase/period estimate. */
+    void Lock(int64_t ready_us)
+    {
+        // Without a "not ready" probe this cycle we only know the update
+        // happened at or before ready_us — assume we were a lead late so
+        // the next probe lands earlier and brackets it again.
+        const int64_t lo = not_ready_us >= 0 ? not_ready_us : ready_us - kLeadUs;
+        const int64_t edge = (lo + ready_us) / 2;
+
+        if (edge_us >= 0) {
+            const int64_t gap = edge - edge_us;
+            const int64_t updates = (gap + period_us / 2) / period_us;
+            if (updates > 1) {
+                missed += static_cast<uint32_t>(updates - 1);
+            }
+            if (updates >= 1) {
+                const int64_t observed = gap / updates;
+                period_us = std::clamp(period_us + (observed - period_us) / 8,
+                                       kMinPeriodUs, kMaxPeriodUs);
             }
-            words[i] = (static_cast<uint16_t>(triplet[0]) << 8) | triplet[1];
         }
-        return ESP_OK;
+        edge_us = edge;
+        not_ready_us = -1;
     }
 
-    static void Poll(void* arg)
+    void Deliver(const sen55_frame::MeasuredWords& words, int64_t now)
     {
-        auto& self = *static_cast<Impl*>(arg);
-        Measurement meas{};
+        // Data-ready raised again inside half a period with identical
+        // values: the sensor re-flagged the same sample.
+        if (samples > 0 && words == last_words && edge_us - last_sample_us < period_us / 2) {
+            ++duplicates;
+            return;
+        }
+        last_words = words;
 
-        for (;;) {
-            vTaskDelay(pdMS_TO_TICKS(kPollIntervalMs));
+        auto meas = sen55_frame::DecodeMeasurement(words);
+        meas.read_us = static_cast<uint32_t>(now);
+        ESP_LOGI(TAG, "PM2.5=%.1f  T=%.1f  RH=%.1f  VOC=%.0f  NOx=%.0f",
+                 meas.pm2_5, meas.temperature, meas.humidity,
+                 meas.voc_index, meas.nox_index);
+
+        last_sample_us = edge_us;
+        max_latency_us = std::max<int64_t>(max_latency_us, now - edge_us);
+        latency_record_us(LatencyStage::kRead, static_cast<uint32_t>(now - edge_us));
+        ++samples;
+        cb(meas);
+    }
+
+    void Step()
+    {
+        const auto now = esp_timer_get_time();
 
+        switch (state) {
+        case State::kRequestReady:
+            if (auto err = SendCommand(kCmdReadDataReady); err != ESP_OK) {
+                CountError(err, "data-ready request");
+                Reprobe(kErrorBackoffUs);
+                return;
+            }
+            probe_us = now;
+            state = State::kFetchReady;
+            Arm(kCmdExecUs);
+            return;
+
+        case State::kFetchReady: {
             uint16_t ready_word{};
-            if (auto err = self.ReadWords(kCmdReadDataReady, &ready_word, 1); err != ESP_OK) {
-                ESP_LOGE(TAG, "data-ready failed: %s", esp_err_to_name(err));
-                continue;
+            if (auto err = FetchWords(&ready_word, 1); err != ESP_OK) {
+                CountError(err, "data-ready");
+                Reprobe(kErrorBackoffUs);
+                return;
             }
             if ((ready_word & 0x01) == 0) {
-                continue;
+                ++not_ready;
+                if (reread) {
+                    // The failed read did clear data-ready: the sample is
+                    // gone. Fall back to the last delivered update, so the
+                    // next Lock() counts it as missed.
+                    reread = false;
+                    const int64_t lost_us = edge_us;
+                    edge_us = last_sample_us;
+                    Reprobe(lost_us + period_us - kLeadUs - esp_timer_get_time());
+                    return;
+                }
+                not_ready_us = probe_us;
+                Reprobe(kProbeGapUs);
+                return;
             }
+            // Still flagged after a failed read: the same sample, already locked
+            if (!reread) Lock(probe_us);
+            reread = false;
+            if (auto err = SendCommand(kCmdReadMeasuredValues); err != ESP_OK) {
+                CountError(err, "read request");
+                reread = true;
+                Reprobe(kErrorBackoffUs);
+                return;
+            }
+            state = State::kFetchValues;
+            Arm(kCmdExecUs);
+            return;
+        }
 
-            std::array<uint16_t, 8> words{};
-            if (auto err = self.ReadWords(kCmdReadMeasuredValues, words.data(), words.size());
-                err != ESP_OK) {
-                ESP_LOGE(TAG, "Read failed: %s", esp_err_to_name(err));
-                continue;
+        case State::kFetchValues: {
+            sen55_frame::MeasuredWords words{};
+            if (auto err = FetchWords(words.data(), words.size()); err != ESP_OK) {
+                // Whether the sensor cleared data-ready depends on how far
+                // the transfer got; probe again and re-read if it did not.
+                CountError(err, "read");
+                reread = true;
+                Reprobe(kErrorBackoffUs);
+                return;
             }
+            Deliver(words, esp_timer_get_time());
 
-            meas.pm1_0       = static_cast<float>(words[0]) / 10.0f;
-            meas.pm2_5       = static_cast<float>(words[1]) / 10.0f;
-            meas.pm4_0       = static_cast<float>(words[2]) / 10.0f;
-            meas.pm10        = static_cast<float>(words[3]) / 10.0f;
-            meas.humidity    = static_cast<float>(static_cast<int16_t>(words[4])) / 100.0f;
-            meas.temperature = static_cast<float>(static_cast<int16_t>(words[5])) / 200.0f;
-            meas.voc_index   = static_cast<float>(static_cast<int16_t>(words[6])) / 10.0f;
-            meas.nox_index   = static_cast<float>(static_cast<int16_t>(words[7])) / 10.0f;
+            // Aim the next probe just ahead of the predicted update.
+            Reprobe(edge_us + period_us - kLeadUs - esp_timer_get_time());
+            return;
+        }
+        }
+    }
 
-            ESP_LOGI(TAG, "PM2.5=%.1f  T=%.1f  RH=%.1f  VOC=%.0f  NOx=%.0f",
-                     meas.pm2_5, meas.temperature, meas.humidity,
-                     meas.voc_index, meas.nox_index);
+    static void OnTimer(void* arg)
+    {
+        xSemaphoreGive(static_cast<Impl*>(arg)->wake);
+    }
 
-            self.cb(meas);
+    static void Run(void* arg)
+    {
+        auto& self = *static_cast<Impl*>(arg);
+        self.Arm(kFirstProbeUs);
+        for (;;) {
+            xSemaphoreTake(self.wake, portMAX_DELAY);
+            self.Step();
         }
     }
 };
 
 /* ── Construction / destruction ──────────────────────────────────────── */
 
-Sen55::Sen55(void* i2c_bus, Callback cb)
+Sen55::Sen55(std::unique_ptr<Sen55Transport> transport, Callback cb)
     : impl_(std::make_unique<Impl>())
 {
+    impl_->io = std::move(transport);
     impl_->cb = std::move(cb);
+    impl_->wake = xSemaphoreCreateBinaryStatic(&impl_->wake_buf);
+    assert(impl_->wake);
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = Impl::OnTimer,
+        .arg = impl_.get(),
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "sen55",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &impl_->timer));
 
-    i2c_device_config_t cfg{};
-    cfg.dev_addr_length = I2C_ADDR_BIT_LEN_7;
-    cfg.device_address = Impl::kAddress;
-    cfg.scl_speed_hz = Impl::kI2cSpeedHz;
-    ESP_ERROR_CHECK(i2c_master_bus_add_device(
-        static_cast<i2c_master_bus_handle_t>(i2c_bus), &cfg, &impl_->dev));
     ESP_ERROR_CHECK(impl_->SendCommand(Impl::kCmdStartMeasurement));
     vTaskDelay(pdMS_TO_TICKS(Impl::kDelayStartMs));
-    ESP_LOGI(TAG, "Measurement started on I2C addr 0x%02X", Impl::kAddress);
+    ESP_LOGI(TAG, "Measurement started");
 
-    xTaskCreatePinnedToCore(Impl::Poll, "sen55", 4096,
-                            impl_.get(), 5, &impl_->task, tskNO_AFFINITY);
+    task_plan::Create<task_plan::kSen55>(Impl::Run, impl_.get(), &impl_->task);
 }
 
 Sen55::~Sen55()
 {
+    // Task first: it is the only one that re-arms the timer. A timer that
+    // fires in between just gives the semaphore, which is still valid.
     if (impl_->task) {
         vTaskDelete(impl_->task);
     }
+    esp_timer_stop(impl_->timer);
+    esp_timer_delete(impl_->timer);
+    vSemaphoreDelete(impl_->wake);
+
     impl_->SendCommand(Impl::kCmdStopMeasurement);
     vTaskDelay(pdMS_TO_TICKS(Impl::kDelayStopMs));
     ESP_LOGI(TAG, "Measurement stopped");
 }
+
+Sen55::Stats Sen55::GetStats() const
+{
+    return {
+        .samples = impl_->samples,
+        .missed = impl_->missed,
+        .duplicates = impl_->duplicates,
+        .not_ready = impl_->not_ready,
+        .i2c_errors = impl_->i2c_errors,
+        .crc_errors = impl_->crc_errors,
+        .last_sample_us = impl_->last_sample_us,
+        .max_latency_us = impl_->max_latency_us,
+    };
+}
+
+int64_t Sen55::SampleAgeUs() const
+{
+    const int64_t last = impl_->last_sample_us;
+    return last < 0 ? -1 : esp_timer_get_time() - last;
+}
@@ -4,6 +4,8 @@
 #include <functional>
 #include <memory>
 
+class Sen55Transport;
+
 class Sen55 {
 public:
     struct Measurement {
@@ -15,16 +17,40 @@ public:
         float temperature{};  // °C
         float voc_index{};    // 1–500
         float nox_index{};    // 1–500
+        uint32_t read_us{};   // latency_now() at I2C read completion, 0 if not from a read
+    };
+
+    /** Acquisition health counters, cumulative since construction. */
+    struct Stats {
+        uint32_t samples;         // readings delivered to the callback
+        uint32_t missed;          // sensor updates never read, or lost to a failed read
+        uint32_t duplicates;      // same sample flagged ready twice (not delivered)
+        uint32_t not_ready;       // data-ready probes that found nothing new
+        uint32_t i2c_errors;      // NACKs and timeouts
+        uint32_t crc_errors;
+        int64_t last_sample_us;   // esp_timer time of the last delivered update, -1 if none
+        int64_t max_latency_us;   // sensor update → callback, worst case
     };
 
     using Callback = std::function<void(const Measurement&)>;
 
-    /** Starts measurement and spawns a polling task. Callback fires from the task. */
+    /**
+     * Starts measurement and spawns the acquisition task, which tracks the
+     * sensor's own update cadence. Callback fires from the task.
+     */
     Sen55(void* i2c_bus, Callback cb);
 
+    /** As above, over any transport (e.g. the simulated sensor on the host). */
+    Sen55(std::unique_ptr<Sen55Transport> transport, Callback cb);
+
     /** Stops measurement and deletes the polling task. */
     ~Sen55();
 
+    Stats GetStats() const;
+
+    /** Microseconds since the sensor produced the latest delivered reading, -1 if none yet. */
+    int64_t SampleAgeUs() const;
+
     Sen55(const Sen55&) = delete;
     Sen55& operator=(const Sen55&) = delete;
     Sen55(Sen55&&) = delete;
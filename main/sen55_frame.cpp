@@ -0,0 +1,59 @@
+#include "sen55_frame.hpp"
+#include "sen55_metrics.hpp"
+
+#include "esp_log.h"
+
+static const char* TAG = "sen55";
+
+namespace sen55_frame {
+
+uint8_t Crc8(const uint8_t* data, size_t len)
+{
+    constexpr uint8_t kPoly = 0x31;
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80) ? ((crc << 1) ^ kPoly) : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+esp_err_t DecodeWords(const uint8_t* rx, uint16_t* words, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        const auto* triplet = &rx[i * kBytesPerWord];
+        if (auto expected = Crc8(triplet, 2); triplet[2] != expected) {
+            ESP_LOGE(TAG, "CRC mismatch at word %zu: got 0x%02X, expected 0x%02X",
+                     i, triplet[2], expected);
+            return ESP_ERR_INVALID_CRC;
+        }
+        words[i] = (static_cast<uint16_t>(triplet[0]) << 8) | triplet[1];
+    }
+    return ESP_OK;
+}
+
+void EncodeWords(const uint16_t* words, size_t count, uint8_t* tx)
+{
+    for (size_t i = 0; i < count; ++i) {
+        auto* triplet = &tx[i * kBytesPerWord];
+        triplet[0] = static_cast<uint8_t>(words[i] >> 8);
+        triplet[1] = static_cast<uint8_t>(words[i] & 0xFF);
+        triplet[2] = Crc8(triplet, 2);
+    }
+}
+
+Sen55::Measurement DecodeMeasurement(const MeasuredWords& words)
+{
+    Sen55::Measurement meas{};
+    for (const auto& m : sen55_metrics::kMetrics) {
+        const uint16_t word = words[m.word];
+        const auto raw = m.is_signed ? static_cast<float>(static_cast<int16_t>(word))
+                                     : static_cast<float>(word);
+        meas.*m.member = raw / static_cast<float>(m.scale);
+    }
+    return meas;
+}
+
+} // namespace sen55_frame
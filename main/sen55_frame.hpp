@@ -0,0 +1,41 @@
+#pragma once
+
+#include "sen55.hpp"
+
+#include "esp_err.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Wire-level helpers for the SEN55 I2C protocol: Sensirion CRC-8, word
+ * framing and fixed-point scaling. Pure functions — no I2C or RTOS access,
+ * so they build and run on the host as well as on the target.
+ */
+namespace sen55_frame {
+
+/** Words returned by Read-Measured-Values (0x03C4); see sen55_metrics.hpp. */
+constexpr size_t kMeasuredWordCount = 8;
+
+/** Bytes on the wire per word: big-endian value followed by its CRC. */
+constexpr size_t kBytesPerWord = 3;
+
+using MeasuredWords = std::array<uint16_t, kMeasuredWordCount>;
+
+/** Sensirion CRC-8 (poly 0x31, init 0xFF). */
+uint8_t Crc8(const uint8_t* data, size_t len);
+
+/**
+ * Unpacks `count` CRC-protected words from `rx` (count * 3 bytes).
+ * Returns ESP_ERR_INVALID_CRC on the first bad checksum.
+ */
+esp_err_t DecodeWords(const uint8_t* rx, uint16_t* words, size_t count);
+
+/** Packs `count` words into `tx` (count * 3 bytes), appending each CRC. */
+void EncodeWords(const uint16_t* words, size_t count, uint8_t* tx);
+
+/** Scales raw Read-Measured-Values words into engineering units, per kMetrics. */
+Sen55::Measurement DecodeMeasurement(const MeasuredWords& words);
+
+} // namespace sen55_frame
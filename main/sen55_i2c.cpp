@@ -0,0 +1,57 @@
+#include "sen55.hpp"
+#include "sen55_transport.hpp"
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "driver/i2c_master.h"
+
+static const char* TAG = "sen55";
+
+namespace {
+
+class I2cTransport final : public Sen55Transport {
+public:
+    static constexpr uint8_t kAddress = 0x69;
+    static constexpr uint32_t kI2cSpeedHz = 10'000;
+    static constexpr int kI2cTimeoutMs = 100;
+
+    explicit I2cTransport(i2c_master_bus_handle_t bus)
+    {
+        i2c_device_config_t cfg{};
+        cfg.dev_addr_length = I2C_ADDR_BIT_LEN_7;
+        cfg.device_address = kAddress;
+        cfg.scl_speed_hz = kI2cSpeedHz;
+        ESP_ERROR_CHECK(i2c_master_bus_add_device(bus, &cfg, &dev_));
+        ESP_LOGI(TAG, "SEN55 on I2C addr 0x%02X", kAddress);
+    }
+
+    ~I2cTransport() override
+    {
+        i2c_master_bus_rm_device(dev_);
+    }
+
+    esp_err_t Transmit(const uint8_t* data, size_t len) override
+    {
+        return i2c_master_transmit(dev_, data, len, kI2cTimeoutMs);
+    }
+
+    esp_err_t Receive(uint8_t* data, size_t len) override
+    {
+        return i2c_master_receive(dev_, data, len, kI2cTimeoutMs);
+    }
+
+private:
+    i2c_master_dev_handle_t dev_{};
+};
+
+} // namespace
+
+std::unique_ptr<Sen55Transport> MakeSen55I2cTransport(void* i2c_bus)
+{
+    return std::make_unique<I2cTransport>(static_cast<i2c_master_bus_handle_t>(i2c_bus));
+}
+
+Sen55::Sen55(void* i2c_bus, Callback cb)
+    : Sen55(MakeSen55I2cTransport(i2c_bus), std::move(cb))
+{
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "sen55.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <string_view>
+
+/**
+ * The SEN55's eight metrics, described once: where each sits in a
+ * Read-Measured-Values frame and how it scales, how it is shown on a card,
+ * published over MQTT and announced to Home Assistant, and its severity
+ * bands. Decoding, the UI, sen55_mqtt and ha_discovery all walk kMetrics,
+ * so adding a metric is one row here.
+ *
+ * Rows are in display order (cards, JSON fields, HA entities). `word` is
+ * the metric's position in the frame, which is also its History::Channel.
+ */
+namespace sen55_metrics {
+
+/** A severity band: lo <= value <= hi. */
+struct Band {
+    float lo;
+    float hi;
+};
+
+/** Bands below unhealthy: good, moderate, unhealthy for sensitive groups. */
+inline constexpr size_t kBandCount = 3;
+
+struct Metric {
+    float Sen55::Measurement::* member;
+    uint8_t word;              // index in Read-Measured-Values
+    bool is_signed;            // word is int16
+    uint16_t scale;            // value = raw / scale
+    uint8_t decimals;          // 0: shown as a truncated integer
+    const char* key;           // MQTT entity and JSON key
+    std::string_view json_key; // "\"key\":"
+    std::string_view topic;    // "/sensor/key", after "aqm/<id>"
+    const char* label;         // card title
+    const char* label_unit;    // card unit (the display fonts have no µ or ³)
+    const char* name;          // HA entity name
+    const char* device_class;  // HA device_class, nullptr if none
+    const char* unit;          // HA unit_of_measurement, nullptr if none
+    Band bands[kBandCount];
+};
+
+constexpr float kInf = std::numeric_limits<float>::infinity();
+
+/** Band for "at most `hi`". */
+constexpr Band UpTo(float hi)
+{
+    return {-kInf, hi};
+}
+
+/** Band for "from `lo` to `hi`". */
+constexpr Band Within(float lo, float hi)
+{
+    return {lo, hi};
+}
+
+#define SEN55_METRIC(key, member, word, is_signed, scale, decimals, label, label_unit, name, \
+                     device_class, unit, good, moderate, usg)                                \
+    Metric{&Sen55::Measurement::member, word, is_signed, scale, decimals, #key,               \
+           "\"" #key "\":", "/sensor/" #key, label, label_unit, name, device_class, unit,     \
+           {good, moderate, usg}}
+
+inline constexpr Metric kMetrics[] = {
+    // PM thresholds: US EPA for PM2.5 and PM10, interpolated for the others
+    SEN55_METRIC(pm1_0, pm1_0, 0, false, 10, 1, "PM 1.0", "ug/m3", "PM1.0", "pm1", "µg/m³",
+                 UpTo(12.f), UpTo(35.f), UpTo(55.f)),
+    SEN55_METRIC(pm2_5, pm2_5, 1, false, 10, 1, "PM 2.5", "ug/m3", "PM2.5", "pm25", "µg/m³",
+                 UpTo(12.f), UpTo(35.4f), UpTo(55.4f)),
+    SEN55_METRIC(pm4_0, pm4_0, 2, false, 10, 1, "PM 4.0", "ug/m3", "PM4.0", nullptr, "µg/m³",
+                 UpTo(25.f), UpTo(50.f), UpTo(75.f)),
+    SEN55_METRIC(pm10, pm10, 3, false, 10, 1, "PM 10", "ug/m3", "PM10", "pm10", "µg/m³",
+                 UpTo(54.f), UpTo(154.f), UpTo(254.f)),
+    // Comfort ranges
+    SEN55_METRIC(temp, temperature, 5, true, 200, 1, "Temp", "\xC2\xB0""C", "Temperature",
+                 "temperature", "°C", Within(18.f, 24.f), Within(15.f, 28.f), Within(10.f, 32.f)),
+    SEN55_METRIC(humidity, humidity, 4, true, 100, 1, "Humidity", "%RH", "Humidity",
+                 "humidity", "%", Within(30.f, 60.f), Within(20.f, 70.f), Within(10.f, 80.f)),
+    // Sensirion indices, 1–500
+    SEN55_METRIC(voc, voc_index, 6, true, 10, 0, "VOC", "index", "VOC Index",
+                 "volatile_organic_compounds_part", nullptr,
+                 UpTo(150.f), UpTo(250.f), UpTo(400.f)),
+    SEN55_METRIC(nox, nox_index, 7, true, 10, 0, "NOx", "index", "NOx Index", nullptr, nullptr,
+                 UpTo(20.f), UpTo(150.f), UpTo(250.f)),
+};
+
+#undef SEN55_METRIC
+
+inline constexpr size_t kMetricCount = std::size(kMetrics);
+
+/** Row of each frame word (and History::Channel). */
+inline constexpr auto kMetricOfWord = [] {
+    std::array<size_t, kMetricCount> of{};
+    for (auto& i : of) i = kMetricCount;
+    for (size_t i = 0; i < kMetricCount; ++i) of[kMetrics[i].word] = i;
+    return of;
+}();
+
+static_assert([] {
+    for (size_t i : kMetricOfWord) {
+        if (i >= kMetricCount) return false;
+    }
+    return true;
+}(), "every frame word needs exactly one metric");
+
+/** Room for any value FormatValue() writes (e.g. "-327.7"), and its NUL. */
+inline constexpr size_t kMaxValueText = 12;
+
+/** Severity 0–3: the first band holding `v`, 3 (unhealthy) if none or NaN. */
+constexpr size_t Severity(const Metric& m, float v)
+{
+    for (size_t level = 0; level < kBandCount; ++level) {
+        if (v >= m.bands[level].lo && v <= m.bands[level].hi) return level;
+    }
+    return kBandCount;
+}
+
+/** Writes `v` at the metric's precision; returns snprintf's length. */
+inline int FormatValue(char* buf, size_t size, const Metric& m, float v)
+{
+    if (m.decimals == 0) {
+        return std::snprintf(buf, size, "%d", static_cast<int>(v));
+    }
+    return std::snprintf(buf, size, "%.*f", m.decimals, static_cast<double>(v));
+}
+
+} // namespace sen55_metrics
@@ -0,0 +1,302 @@
+#include "sen55_mqtt.hpp"
+#include "boot_profile.hpp"
+#include "device_id.hpp"
+#include "latency.hpp"
+#include "mqtt.hpp"
+#include "sen55_metrics.hpp"
+#include "task_plan.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace {
+
+const char *TAG = "sen55_mqtt";
+
+// Queue a few readings so a short broker stall doesn't lose any
+constexpr size_t kQueueDepth = 8;
+
+constexpr size_t kReplayBatch = CONFIG_AQM_OUTBOX_REPLAY_BATCH;
+constexpr int kReplayIntervalMs = CONFIG_AQM_OUTBOX_REPLAY_INTERVAL_MS;
+constexpr time_t kMinValidTime = 1'600'000'000;  // 2020-09: clock has been set
+constexpr int kStateQos = CONFIG_AQM_MQTT_STATE_QOS;
+constexpr uint32_t kLatencyReportS = CONFIG_AQM_LATENCY_REPORT_S;
+
+#if CONFIG_AQM_MQTT_STATE_PER_TOPIC
+Sen55MqttFormat s_format = Sen55MqttFormat::kPerTopic;
+#else
+Sen55MqttFormat s_format = Sen55MqttFormat::kJson;
+#endif
+
+char s_state_topic[48]{};
+char s_backfill_topic[48]{};
+char s_latency_topic[48]{};
+Outbox *s_outbox{};
+
+// State messages awaiting PUBACK, as msg_id << 32 | read_us; 0 is free.
+// Filled by the publish task, matched and freed in the esp-mqtt task. A
+// slot overwritten before its PUBACK arrives just goes unmeasured.
+constexpr size_t kPendingAcks = 8;
+std::atomic<uint64_t> s_pending_acks[kPendingAcks]{};
+size_t s_next_pending{};
+
+void track_ack(int msg_id, uint32_t read_us)
+{
+    if (msg_id <= 0 || read_us == 0) return;
+    s_pending_acks[s_next_pending++ % kPendingAcks].store(
+        uint64_t{static_cast<uint32_t>(msg_id)} << 32 | read_us);
+}
+
+void on_published(int msg_id)
+{
+    for (auto &slot : s_pending_acks) {
+        uint64_t v = slot.load();
+        if (v != 0 && v >> 32 == static_cast<uint32_t>(msg_id) &&
+            slot.compare_exchange_strong(v, 0)) {
+            latency_record(LatencyStage::kAck, static_cast<uint32_t>(v));
+            return;
+        }
+    }
+}
+
+uint32_t wall_clock()
+{
+    const auto now = std::time(nullptr);
+    return now >= kMinValidTime ? static_cast<uint32_t>(now) : 0;
+}
+
+using sen55_metrics::kMetricCount;
+using sen55_metrics::kMetrics;
+
+/// aqm/<id>/sensor/<key> for each metric, built on first use.
+const char *sensor_topic(size_t i)
+{
+    static char topics[kMetricCount][48];
+    if (topics[0][0] == '\0') {
+        const char *id = device_id_get();
+        for (size_t k = 0; k < kMetricCount; ++k) {
+            const auto suffix = kMetrics[k].topic;
+            std::snprintf(topics[k], sizeof(topics[k]), "aqm/%s%.*s", id,
+                          static_cast<int>(suffix.size()), suffix.data());
+        }
+    }
+    return topics[i];
+}
+
+/// Message ID of the last topic accepted, -1 if none was. A reading with
+/// some topics sent counts as published: backfilling it would repeat the
+/// values that did go out, so the metrics that failed are skipped instead.
+int publish_per_topic(const Sen55::Measurement &m)
+{
+    char value[sen55_metrics::kMaxValueText];
+    int last_id = -1;
+
+    for (size_t i = 0; i < kMetricCount; ++i) {
+        sen55_metrics::FormatValue(value, sizeof(value), kMetrics[i], m.*kMetrics[i].member);
+        if (const int msg_id = mqtt_publish(sensor_topic(i), value, kStateQos); msg_id >= 0) {
+            last_id = msg_id;
+        }
+    }
+    return last_id;
+}
+
+/// Appends "pm1_0":1.2,...,"nox":1 (no braces). Keys match the per-topic
+/// entity names and the value_templates in ha_discovery.cpp.
+size_t write_fields(char *buf, size_t size, const Sen55::Measurement &m)
+{
+    size_t len = 0;
+    for (const auto &metric : kMetrics) {
+        std::memcpy(buf + len, metric.json_key.data(), metric.json_key.size());
+        len += metric.json_key.size();
+        len += sen55_metrics::FormatValue(buf + len, size - len, metric, m.*metric.member);
+        buf[len++] = ',';
+    }
+    return len - 1;
+}
+
+// {"pm1_0":1.2,...,"nox":1,"ts":1700000000}, ts (UTC) once the clock is set
+int publish_json(const Sen55::Measurement &m)
+{
+    char json[192];  // fits all 8 fields at their widest (e.g. "-163.8"), and ts
+    size_t len = 0;
+
+    json[len++] = '{';
+    len += write_fields(json + len, sizeof(json) - len, m);
+    if (auto ts = wall_clock(); ts != 0) {
+        len += std::snprintf(json + len, sizeof(json) - len, ",\"ts\":%lu",
+                             static_cast<unsigned long>(ts));
+    }
+    json[len++] = '}';
+    json[len] = '\0';
+
+    return mqtt_publish(sen55_mqtt_state_topic(), json, kStateQos);
+}
+
+/// Per-stage latency histograms since the last report, on aqm/<id>/latency.
+void publish_latency(uint32_t window_s)
+{
+    static char json[1024];
+    latency_report_json(json, sizeof(json), wall_clock(), window_s);
+    mqtt_publish(sen55_mqtt_latency_topic(), json);
+}
+
+/// Capture time of `r`, recovered from its monotonic stamp when the clock
+/// was not yet set at capture but is now. 0 if unknown.
+uint32_t record_time(const Outbox::Record &r, uint16_t boot_id)
+{
+    if (r.unix_s != 0) return r.unix_s;
+    const auto now = wall_clock();
+    if (now == 0 || r.boot_id != boot_id) return 0;
+    return now - static_cast<uint32_t>((esp_timer_get_time() - r.mono_us) / 1'000'000);
+}
+
+/// Sends the oldest backlog records as one JSON array on
+/// aqm/<id>/backfill (QoS 1) and pops them once esp-mqtt has queued it:
+///   [{"seq":12,"boot":4711,"ts":1700000000,"pm1_0":1.2,...},...]
+/// Records are replayed to their own topic so that HA entities, which
+/// timestamp on arrival, never show a stale value as current. `seq` starts
+/// over after a reboot, so consumers dedupe on (boot, seq).
+void replay_batch(Outbox &outbox)
+{
+    static Outbox::Record batch[kReplayBatch];
+    static char json[kReplayBatch * 176 + 2];
+
+    const size_t n = outbox.Peek(batch, kReplayBatch);
+    if (n == 0) return;
+
+    size_t len = 0;
+    json[len++] = '[';
+    for (size_t i = 0; i < n; ++i) {
+        const auto &r = batch[i];
+        len += std::snprintf(json + len, sizeof(json) - len, "{\"seq\":%lu,\"boot\":%u,",
+                             static_cast<unsigned long>(r.seq), static_cast<unsigned>(r.boot_id));
+        if (auto ts = record_time(r, outbox.BootId()); ts != 0) {
+            len += std::snprintf(json + len, sizeof(json) - len, "\"ts\":%lu,",
+                                 static_cast<unsigned long>(ts));
+        }
+        len += write_fields(json + len, sizeof(json) - len, r.m);
+        json[len++] = '}';
+        json[len++] = ',';
+    }
+    json[len - 1] = ']';
+    json[len] = '\0';
+
+    if (mqtt_publish(s_backfill_topic, json, 1, false) < 0) return;
+    outbox.Pop(n);
+
+    if (outbox.Empty()) {
+        const auto s = outbox.GetStats();
+        ESP_LOGI(TAG, "Backlog replayed: %lu total, high-water %lu, dropped %lu",
+                 static_cast<unsigned long>(s.replayed),
+                 static_cast<unsigned long>(s.high_water),
+                 static_cast<unsigned long>(s.dropped));
+    }
+}
+
+void publish_task(void *arg)
+{
+    auto *sub = static_cast<MeasurementBus *>(arg)->Subscribe(
+        "mqtt", MeasurementBus::Mode::kQueue, kQueueDepth,
+        xTaskGetCurrentTaskHandle());
+    if (!sub) {
+        ESP_LOGE(TAG, "No free measurement bus slot");
+        vTaskDelete(nullptr);
+        return;
+    }
+
+    std::snprintf(s_backfill_topic, sizeof(s_backfill_topic),
+                  "aqm/%s/backfill", device_id_get());
+    static Outbox outbox(CONFIG_AQM_OUTBOX_RAM_RECORDS, "outbox");
+    s_outbox = &outbox;
+
+    // Live readings always go first; at most one backlog batch per
+    // interval goes out between them.
+    Sen55::Measurement m;
+    int64_t next_replay_us = 0;
+    int64_t last_report_us = esp_timer_get_time();
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, outbox.Empty() ? portMAX_DELAY
+                                                : pdMS_TO_TICKS(kReplayIntervalMs));
+        while (sub->Pop(m)) {
+            if (publish_sen55(m)) {
+                boot_profile_mark(BootPhase::kFirstPublish);
+            } else {
+                outbox.Push(wall_clock(), m);
+            }
+        }
+
+        const auto now = esp_timer_get_time();
+        if (!outbox.Empty() && mqtt_is_connected() && now >= next_replay_us) {
+            replay_batch(outbox);
+            next_replay_us = now + int64_t{kReplayIntervalMs} * 1000;
+        }
+
+        if (kLatencyReportS > 0 && mqtt_is_connected() &&
+            now - last_report_us >= int64_t{kLatencyReportS} * 1'000'000) {
+            publish_latency(static_cast<uint32_t>((now - last_report_us) / 1'000'000));
+            last_report_us = now;
+        }
+    }
+}
+
+} // namespace
+
+Sen55MqttFormat sen55_mqtt_format()
+{
+    return s_format;
+}
+
+void sen55_mqtt_set_format(Sen55MqttFormat format)
+{
+    s_format = format;
+}
+
+const char *sen55_mqtt_state_topic()
+{
+    if (s_state_topic[0] == '\0') {
+        std::snprintf(s_state_topic, sizeof(s_state_topic),
+                      "aqm/%s/state", device_id_get());
+    }
+    return s_state_topic;
+}
+
+const char *sen55_mqtt_latency_topic()
+{
+    if (s_latency_topic[0] == '\0') {
+        std::snprintf(s_latency_topic, sizeof(s_latency_topic),
+                      "aqm/%s/latency", device_id_get());
+    }
+    return s_latency_topic;
+}
+
+bool publish_sen55(const Sen55::Measurement &m)
+{
+    if (!mqtt_is_connected()) return false;
+
+    const int msg_id = s_format == Sen55MqttFormat::kJson ? publish_json(m)
+                                                          : publish_per_topic(m);
+    if (msg_id < 0) return false;
+
+    latency_record(LatencyStage::kPublish, m.read_us);
+    if (kStateQos > 0) track_ack(msg_id, m.read_us);
+    return true;
+}
+
+Outbox::Stats sen55_mqtt_outbox_stats()
+{
+    return s_outbox ? s_outbox->GetStats() : Outbox::Stats{};
+}
+
+void sen55_mqtt_start(MeasurementBus &bus)
+{
+    mqtt_set_published_cb(on_published);
+    task_plan::Create<task_plan::kSen55Mqtt>(publish_task, &bus);
+}
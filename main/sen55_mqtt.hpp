@@ -0,0 +1,41 @@
+#pragma once
+
+#include "measurement_bus.hpp"
+#include "outbox.hpp"
+#include "sen55.hpp"
+
+/// How SEN55 readings are laid out on MQTT.
+enum class Sen55MqttFormat {
+    kJson,      // one JSON document on aqm/<device_id>/state
+    kPerTopic,  // one plain value per aqm/<device_id>/sensor/<entity>
+};
+
+/// Current format; defaults to the Kconfig choice (AQM_MQTT_STATE_FORMAT).
+Sen55MqttFormat sen55_mqtt_format();
+
+/// Switch format at runtime. Re-publish discovery afterwards so HA follows.
+void sen55_mqtt_set_format(Sen55MqttFormat format);
+
+/// JSON state topic, aqm/<device_id>/state.
+const char *sen55_mqtt_state_topic();
+
+/// Latency report topic, aqm/<device_id>/latency (see latency.hpp).
+const char *sen55_mqtt_latency_topic();
+
+/// Publish one SEN55 reading in the current format.
+/// Returns false, having sent nothing, if MQTT is not connected or
+/// esp-mqtt refused every message; the caller then queues it for backfill.
+/// A per-topic reading with only some topics accepted returns true, so no
+/// value is ever sent twice; the refused metrics are dropped.
+bool publish_sen55(const Sen55::Measurement &m);
+
+/// Subscribe to `bus` and publish every reading from a dedicated task, so a
+/// slow broker never holds up acquisition or the display. Readings taken
+/// while disconnected go to an Outbox and are replayed on reconnect to
+/// aqm/<device_id>/backfill, rate-limited behind live publishes; each
+/// record carries "seq" and "boot", unique as a pair across reboots. Every
+/// CONFIG_AQM_LATENCY_REPORT_S it also publishes the latency histograms.
+void sen55_mqtt_start(MeasurementBus &bus);
+
+/// Backlog depth / high-water etc. of the offline outbox (zeros before start).
+Outbox::Stats sen55_mqtt_outbox_stats();
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "esp_err.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Byte-level link to a SEN55. On the board this is the IDF I2C master
+ * driver; host builds plug in a software model of the sensor instead.
+ */
+class Sen55Transport {
+public:
+    virtual ~Sen55Transport() = default;
+
+    /** Writes a command (and any argument words) to the device. */
+    virtual esp_err_t Transmit(const uint8_t* data, size_t len) = 0;
+
+    /** Reads a response. A NACK from a busy or confused device is an error. */
+    virtual esp_err_t Receive(uint8_t* data, size_t len) = 0;
+};
+
+/** SEN55 at its fixed address on an `i2c_master_bus_handle_t`. */
+std::unique_ptr<Sen55Transport> MakeSen55I2cTransport(void* i2c_bus);
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <cstdint>
+
+/**
+ * Core, priority and stack of every long-lived firmware task, in one place.
+ *
+ *   Core 0 (PRO)  Wi-Fi (23), lwIP tcpip (18), esp-mqtt (5), sen55_mqtt (4),
+ *                 espnow (4), history (3), telemetry (2): network and
+ *                 bookkeeping, which the Wi-Fi driver preempts at will.
+ *   Core 1 (APP)  sen55 (6) above LVGL (4), so a long redraw never delays
+ *                 an I2C read.
+ *   Core 1 (APP)  boot_ui (5), at startup only: panel, LVGL and the first
+ *                 screen, while app_main brings up Wi-Fi and the sensor.
+ *   Either core   LVGL's software draw units (LV_DRAW_SW_DRAW_UNIT_CNT),
+ *                 created unpinned by LVGL itself, so a redraw is split
+ *                 across both cores while the network is idle.
+ *
+ * The Wi-Fi, lwIP and esp-mqtt pinning is set in sdkconfig.defaults; the
+ * rest is created from the specs below.
+ *
+ * Long-lived tasks are created with Create<spec>(). With
+ * CONFIG_AQM_ZERO_HEAP their stack and TCB are reserved at link time, one
+ * per spec, so no two tasks from the same spec may be alive at once.
+ */
+namespace task_plan {
+
+struct Spec {
+    const char* name;
+    uint32_t stack;
+    UBaseType_t priority;
+    BaseType_t core;
+};
+
+inline constexpr BaseType_t kProCore = 0;
+inline constexpr BaseType_t kAppCore = 1;
+
+inline constexpr Spec kSen55     {"sen55",      4096, 6, kAppCore};
+inline constexpr Spec kLvgl      {"taskLVGL",   7168, 4, kAppCore};
+inline constexpr Spec kMqtt      {"mqtt_task",  6144, 5, kProCore};
+inline constexpr Spec kSen55Mqtt {"sen55_mqtt", 4096, 4, kProCore};
+inline constexpr Spec kEspNow    {"espnow",     4096, 4, kProCore};
+inline constexpr Spec kHistory   {"history",    3072, 3, kProCore};
+inline constexpr Spec kTelemetry {"telemetry",  4096, 2, kProCore};
+inline constexpr Spec kBootUi    {"boot_ui",    8192, 5, kAppCore};
+
+/** xTaskCreatePinnedToCore() from a Spec; for tasks that exit during boot. */
+inline BaseType_t Create(const Spec& spec, TaskFunction_t fn, void* arg,
+                         TaskHandle_t* out_handle = nullptr)
+{
+    return xTaskCreatePinnedToCore(fn, spec.name, spec.stack, arg, spec.priority,
+                                   out_handle, spec.core);
+}
+
+/** A long-lived task from `S`: statically allocated with CONFIG_AQM_ZERO_HEAP. */
+template <const Spec& S>
+BaseType_t Create(TaskFunction_t fn, void* arg, TaskHandle_t* out_handle = nullptr)
+{
+#if CONFIG_AQM_ZERO_HEAP
+    static StackType_t stack[S.stack / sizeof(StackType_t)];
+    static StaticTask_t tcb;
+    TaskHandle_t task = xTaskCreateStaticPinnedToCore(fn, S.name, S.stack, arg, S.priority,
+                                                      stack, &tcb, S.core);
+    if (out_handle) *out_handle = task;
+    return task ? pdPASS : pdFAIL;
+#else
+    return Create(S, fn, arg, out_handle);
+#endif
+}
+
+} // namespace task_plan
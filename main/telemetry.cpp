@@ -0,0 +1,222 @@
+#include "telemetry.hpp"
+#include "device_id.hpp"
+#include "heap_audit.hpp"
+#include "mqtt.hpp"
+#include "sen55.hpp"
+#include "sen55_mqtt.hpp"
+#include "task_plan.hpp"
+#include "wifi.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+
+#include "sdkconfig.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace {
+
+const char *TAG = "telemetry";
+
+constexpr uint32_t kIntervalS = CONFIG_AQM_TELEMETRY_INTERVAL_S;
+
+// Bounds the sample buffers: about 20 tasks run (task_plan.hpp, LVGL's draw
+// units, and IDF's idle, ipc, timer, event, Wi-Fi and lwIP tasks), so this
+// leaves room. With more, uxTaskGetSystemState() fills in none of them.
+constexpr UBaseType_t kMaxTasks = 40;
+
+const Sen55 *s_sensor{};
+char s_topic[48]{};
+char s_json[2048];  // room for kMaxTasks entries under "tasks"
+int64_t s_cost_us{};   // sampling + publishing, last round
+
+/* ── Task sampling ──────────────────────────────────────────────────── */
+
+#if configUSE_TRACE_FACILITY
+// This round and the last, for run-time deltas
+TaskStatus_t s_tasks[2][kMaxTasks];
+UBaseType_t s_task_count[2]{};
+configRUN_TIME_COUNTER_TYPE s_total[2]{};
+int s_cur{};
+
+void sample_tasks()
+{
+    s_cur ^= 1;
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    s_task_count[s_cur] = uxTaskGetSystemState(s_tasks[s_cur], kMaxTasks, &total);
+    s_total[s_cur] = total;
+    if (s_task_count[s_cur] == 0) {
+        ESP_LOGW(TAG, "%u tasks, room for %u: no task stats this round",
+                 static_cast<unsigned>(uxTaskGetNumberOfTasks()),
+                 static_cast<unsigned>(kMaxTasks));
+    }
+}
+
+#if configGENERATE_RUN_TIME_STATS
+/// CPU share of `t` over the last interval, % of one core.
+float cpu_percent(const TaskStatus_t &t)
+{
+    const auto &prev = s_tasks[s_cur ^ 1];
+    const auto prev_n = s_task_count[s_cur ^ 1];
+    const auto elapsed = s_total[s_cur] - s_total[s_cur ^ 1];
+    if (elapsed == 0) return 0;
+
+    // A task created during the interval ran for all of its counter
+    configRUN_TIME_COUNTER_TYPE before = 0;
+    for (UBaseType_t i = 0; i < prev_n; ++i) {
+        if (prev[i].xHandle == t.xHandle) {
+            before = prev[i].ulRunTimeCounter;
+            break;
+        }
+    }
+    return 100.0f * static_cast<float>(t.ulRunTimeCounter - before) /
+           static_cast<float>(elapsed);
+}
+
+float core_load(BaseType_t core)
+{
+    const TaskHandle_t idle = xTaskGetIdleTaskHandleForCore(core);
+    for (UBaseType_t i = 0; i < s_task_count[s_cur]; ++i) {
+        const auto &t = s_tasks[s_cur][i];
+        if (t.xHandle == idle) return std::max(0.0f, 100.0f - cpu_percent(t));
+    }
+    return 0;
+}
+#endif
+#endif
+
+/* ── Payload ────────────────────────────────────────────────────────── */
+
+// {"heap":{"free":…,"min":…,"largest":…,"frag":12},"psram":{…},
+//  "cpu":{"core0":31.2,"core1":12.0},"stack_min":{"task":"sen55","free":812},
+//  "tasks":{"sen55":[1.2,812],…},"sensor":{"samples":…,"i2c_errors":…},
+//  "allocs":{"total":…,"firmware":0},"mqtt_outbox":0,"backlog":0,
+//  "wifi_disconnects":0,"cost_us":412}
+// allocs: heap allocations since the zero-heap audit was armed
+// tasks: [CPU % of one core, stack never used in bytes]
+size_t write_json(char *buf, size_t size)
+{
+    size_t len = 0;
+    auto put = [&](const char *fmt, auto... args) {
+        if (len < size) len += std::snprintf(buf + len, size - len, fmt, args...);
+    };
+
+    const size_t free_int = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    const size_t largest_int = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    put("{\"heap\":{\"free\":%u,\"min\":%u,\"largest\":%u,\"frag\":%u}",
+        static_cast<unsigned>(free_int),
+        static_cast<unsigned>(heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL)),
+        static_cast<unsigned>(largest_int),
+        static_cast<unsigned>(free_int ? 100 - largest_int * 100 / free_int : 0));
+    put(",\"psram\":{\"free\":%u,\"total\":%u,\"largest\":%u}",
+        static_cast<unsigned>(heap_caps_get_free_size(MALLOC_CAP_SPIRAM)),
+        static_cast<unsigned>(heap_caps_get_total_size(MALLOC_CAP_SPIRAM)),
+        static_cast<unsigned>(heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM)));
+
+#if configUSE_TRACE_FACILITY
+    sample_tasks();
+    const auto *tasks = s_tasks[s_cur];
+    const auto n = s_task_count[s_cur];
+    if (n > 0) {
+#if configGENERATE_RUN_TIME_STATS
+        put(",\"cpu\":{\"core0\":%.1f,\"core1\":%.1f}", core_load(0), core_load(1));
+#endif
+        const auto *tight = std::min_element(tasks, tasks + n, [](const auto &a, const auto &b) {
+            return a.usStackHighWaterMark < b.usStackHighWaterMark;
+        });
+        put(",\"stack_min\":{\"task\":\"%s\",\"free\":%u}", tight->pcTaskName,
+            static_cast<unsigned>(tight->usStackHighWaterMark));
+    }
+#if CONFIG_AQM_TELEMETRY_TASKS
+    put(",\"tasks\":{");
+    for (UBaseType_t i = 0; i < n; ++i) {
+#if configGENERATE_RUN_TIME_STATS
+        const float cpu = cpu_percent(tasks[i]);
+#else
+        const float cpu = 0;
+#endif
+        put("%s\"%s\":[%.1f,%u]", i ? "," : "", tasks[i].pcTaskName, cpu,
+            static_cast<unsigned>(tasks[i].usStackHighWaterMark));
+    }
+    put("}");
+#endif
+#endif
+
+    if (s_sensor) {
+        const auto st = s_sensor->GetStats();
+        put(",\"sensor\":{\"samples\":%lu,\"missed\":%lu,\"i2c_errors\":%lu,\"crc_errors\":%lu}",
+            static_cast<unsigned long>(st.samples), static_cast<unsigned long>(st.missed),
+            static_cast<unsigned long>(st.i2c_errors), static_cast<unsigned long>(st.crc_errors));
+    }
+#if CONFIG_AQM_ZERO_HEAP
+    put(",\"allocs\":{\"total\":%lu,\"firmware\":%lu,\"mqtt\":%lu}",
+        static_cast<unsigned long>(heap_audit_total()),
+        static_cast<unsigned long>(heap_audit_firmware()),
+        static_cast<unsigned long>(heap_audit_mqtt()));
+#endif
+    put(",\"mqtt_outbox\":%d,\"backlog\":%lu,\"wifi_disconnects\":%lu,\"cost_us\":%lld}",
+        mqtt_outbox_bytes(),
+        static_cast<unsigned long>(sen55_mqtt_outbox_stats().depth),
+        static_cast<unsigned long>(wifi_get_stats().disconnects),
+        static_cast<long long>(s_cost_us));
+    return std::min(len, size - 1);
+}
+
+/// Names the tasks behind any firmware allocation since the last round.
+void log_heap_audit()
+{
+#if CONFIG_AQM_ZERO_HEAP
+    static uint32_t reported = 0;
+    const uint32_t firmware = heap_audit_firmware();
+    if (firmware == reported) return;
+    reported = firmware;
+
+    heap_audit_entry_t entries[6];
+    const size_t n = heap_audit_report(entries, std::size(entries));
+    for (size_t i = 0; i < n; ++i) {
+        if (!entries[i].firmware) continue;
+        ESP_LOGW(TAG, "%s allocated %lu times (%lu bytes) after boot", entries[i].task,
+                 static_cast<unsigned long>(entries[i].count),
+                 static_cast<unsigned long>(entries[i].bytes));
+    }
+#endif
+}
+
+void telemetry_task(void * /*arg*/)
+{
+#if configUSE_TRACE_FACILITY
+    sample_tasks();  // run-time baseline for the first interval
+#endif
+    TickType_t wake = xTaskGetTickCount();
+    for (;;) {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(kIntervalS * 1000));
+        log_heap_audit();
+        if (!mqtt_is_connected()) continue;
+
+        const int64_t t0 = esp_timer_get_time();
+        const size_t len = write_json(s_json, sizeof(s_json));
+        if (len + 1 >= sizeof(s_json)) {
+            // Cut-off JSON would break every entity's template at once
+            ESP_LOGW(TAG, "Payload truncated at %u bytes, not published",
+                     static_cast<unsigned>(len));
+        } else {
+            mqtt_publish(s_topic, s_json);
+        }
+        s_cost_us = esp_timer_get_time() - t0;
+    }
+}
+
+} // namespace
+
+void telemetry_start(const Sen55 *sensor)
+{
+    s_sensor = sensor;
+    std::snprintf(s_topic, sizeof(s_topic), "aqm/%s/telemetry", device_id_get());
+    task_plan::Create<task_plan::kTelemetry>(telemetry_task, nullptr);
+    ESP_LOGI(TAG, "Publishing to %s every %lu s", s_topic,
+             static_cast<unsigned long>(kIntervalS));
+}
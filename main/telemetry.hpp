@@ -0,0 +1,12 @@
+#pragma once
+
+class Sen55;
+
+/// Start the telemetry task. Every CONFIG_AQM_TELEMETRY_INTERVAL_S it
+/// samples heap and PSRAM headroom, per-task CPU load and stack
+/// high-water marks, sensor bus errors and the MQTT outboxes, and
+/// publishes them as one JSON document to aqm/<device_id>/telemetry
+/// (skipped while MQTT is down). `sensor` may be null.
+///
+/// The entities reading it are kTelemetry in ha_discovery.cpp.
+void telemetry_start(const Sen55 *sensor);
@@ -0,0 +1,44 @@
+#include "time_sync.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_netif_sntp.h"
+
+namespace {
+
+const char *TAG = "time_sync";
+
+constexpr time_t kMinValidTime = 1'600'000'000;  // 2020-09: clock has been set
+
+// Set on the SNTP task, read from any
+std::atomic<bool> s_synced{false};
+
+void on_sync(struct timeval *tv)
+{
+    s_synced = true;
+    char buf[32];
+    const time_t t = tv->tv_sec;
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&t));
+    ESP_LOGI(TAG, "Clock set: %s", buf);
+}
+
+} // namespace
+
+void time_sync_init()
+{
+    setenv("TZ", CONFIG_AQM_TZ, 1);
+    tzset();
+
+    esp_sntp_config_t cfg = ESP_NETIF_SNTP_DEFAULT_CONFIG(CONFIG_AQM_SNTP_SERVER);
+    cfg.sync_cb = on_sync;
+    ESP_ERROR_CHECK(esp_netif_sntp_init(&cfg));
+}
+
+bool time_sync_valid()
+{
+    return s_synced || std::time(nullptr) >= kMinValidTime;
+}
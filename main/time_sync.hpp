@@ -0,0 +1,10 @@
+#pragma once
+
+/// Set the local time zone (CONFIG_AQM_TZ) and start SNTP against
+/// CONFIG_AQM_SNTP_SERVER. Call after wifi_init(); the first sync happens
+/// once there is an IP, then hourly (CONFIG_LWIP_SNTP_UPDATE_DELAY).
+void time_sync_init();
+
+/// True once the wall clock is set: synced this boot, or kept in the RTC
+/// across a soft reset.
+bool time_sync_valid();
@@ -1,10 +1,20 @@
 #include "ui.hpp"
+#include "glyph_cache.hpp"
+#include "sen55_metrics.hpp"
 
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
 #include "lvgl.h"
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <cmath>
 #include <cstdio>
-#include <string>
+#include <cstring>
+
+static const char* TAG = "ui";
 
 /* ── Design tokens ───────────────────────────────────────────────────── */
 
@@ -18,6 +28,8 @@ const auto kGood    = lv_color_hex(0x1B5E20);    // dark green
 const auto kMod     = lv_color_hex(0x7B6C00);    // dark yellow
 const auto kUsg     = lv_color_hex(0xBF360C);    // dark orange
 const auto kUnhlt   = lv_color_hex(0xB71C1C);    // dark red
+const auto kTrend   = lv_color_hex(0x89B4FA);    // chart line
+const auto kGrid    = lv_color_hex(0x45475A);    // chart division lines
 
 // Typography
 constexpr const lv_font_t* kFontXl = &lv_font_montserrat_48;
@@ -32,22 +44,40 @@ constexpr int32_t kRadius = 12;
 
 /* ── Card metadata ───────────────────────────────────────────────────── */
 
-struct CardMeta {
-    const char* name;
-    const char* unit;
+// Cards follow sen55_metrics::kMetrics; a History::Channel is a frame word
+static constexpr auto& kCards = sen55_metrics::kMetrics;
+static constexpr auto& kCardOfChannel = sen55_metrics::kMetricOfWord;
+static_assert(kCardOfChannel.size() == History::kChannelCount);
+
+/* ── Glyph sprites ───────────────────────────────────────────────────── */
+
+#if CONFIG_AQM_UI_GLYPH_CACHE
+static constexpr bool kGlyphCache = true;
+#else
+static constexpr bool kGlyphCache = false;
+#endif
+
+static constexpr std::string_view kValueCharset = "0123456789.-";
+static constexpr size_t kValueChars = 7;    // "-1234.5"
+
+/* ── Trend ranges ────────────────────────────────────────────────────── */
+
+struct RangeMeta {
+    const char* label;
+    History::Tier tier;   // rows the points are averaged from
+    uint32_t slot_s;      // seconds per point
 };
 
-static constexpr std::array<CardMeta, 8> kCards = {{
-    {"PM 1.0", "ug/m3"},
-    {"PM 2.5", "ug/m3"},
-    {"PM 4.0", "ug/m3"},
-    {"PM 10",  "ug/m3"},
-    {"Temp",   "\xC2\xB0""C"},
-    {"Humidity", "%RH"},
-    {"VOC",    "index"},
-    {"NOx",    "index"},
+static constexpr size_t kTrendPoints = 240;
+
+static constexpr std::array<RangeMeta, 2> kRanges = {{
+    {"last hour", History::Tier::kRaw, 3600 / kTrendPoints},
+    {"last 24 h", History::Tier::kMinute, 86400 / kTrendPoints},
 }};
 
+// Chart values are fixed-point tenths
+static constexpr float kTrendScale = 10.f;
+
 /* ── Shared styles ───────────────────────────────────────────────────── */
 
 static lv_style_t style_card;
@@ -62,7 +92,8 @@ static lv_style_t style_mod;
 static lv_style_t style_usg;
 static lv_style_t style_unhlt;
 
-static constexpr size_t kSeverityCount = 4;
+// sen55_metrics::Severity(): a level per band, then unhealthy
+static constexpr size_t kSeverityCount = sen55_metrics::kBandCount + 1;
 static lv_style_t* const kSeverityStyles[kSeverityCount] = {
     &style_good, &style_mod, &style_usg, &style_unhlt,
 };
@@ -112,57 +143,6 @@ static void InitStyles()
     lv_style_set_bg_color(&style_unhlt, tokens::kUnhlt);
 }
 
-/* ── Per-metric severity ─────────────────────────────────────────────── */
-
-// Returns severity level 0–3 (good / moderate / unhealthy-sensitive / unhealthy)
-static size_t MetricSeverity(size_t index, float v)
-{
-    switch (index) {
-    case 0: // PM 1.0 (µg/m³)
-        if (v <= 12.f)  return 0;
-        if (v <= 35.f)  return 1;
-        if (v <= 55.f)  return 2;
-        return 3;
-    case 1: // PM 2.5 (µg/m³, US EPA)
-        if (v <= 12.f)  return 0;
-        if (v <= 35.4f) return 1;
-        if (v <= 55.4f) return 2;
-        return 3;
-    case 2: // PM 4.0 (µg/m³)
-        if (v <= 25.f)  return 0;
-        if (v <= 50.f)  return 1;
-        if (v <= 75.f)  return 2;
-        return 3;
-    case 3: // PM 10 (µg/m³, US EPA)
-        if (v <= 54.f)  return 0;
-        if (v <= 154.f) return 1;
-        if (v <= 254.f) return 2;
-        return 3;
-    case 4: // Temperature (°C) — comfort range
-        if (v >= 18.f && v <= 24.f) return 0;
-        if (v >= 15.f && v <= 28.f) return 1;
-        if (v >= 10.f && v <= 32.f) return 2;
-        return 3;
-    case 5: // Humidity (%RH) — comfort range
-        if (v >= 30.f && v <= 60.f) return 0;
-        if (v >= 20.f && v <= 70.f) return 1;
-        if (v >= 10.f && v <= 80.f) return 2;
-        return 3;
-    case 6: // VOC index (Sensirion 1–500)
-        if (v <= 150.f) return 0;
-        if (v <= 250.f) return 1;
-        if (v <= 400.f) return 2;
-        return 3;
-    case 7: // NOx index (Sensirion 1–500)
-        if (v <= 20.f)  return 0;
-        if (v <= 150.f) return 1;
-        if (v <= 250.f) return 2;
-        return 3;
-    default:
-        return 0;
-    }
-}
-
 /* ── Grid layout ─────────────────────────────────────────────────────── */
 
 static constexpr int32_t kColDsc[] = {
@@ -181,17 +161,268 @@ static constexpr int32_t kRowDsc[] = {
 /* ── Ui::Impl ────────────────────────────────────────────────────────── */
 
 struct Ui::Impl {
-    static constexpr size_t kCardCount = 8;
+    static constexpr size_t kCardCount = sen55_metrics::kMetricCount;
+
+    static constexpr size_t kNoSeverity = kSeverityCount;
+    static constexpr size_t kMaxText = 16;
 
     struct Card {
         lv_obj_t* container{};
-        lv_obj_t* value_label{};
+        GlyphText value;
+        uint32_t value_bits{~0u};       // last value seen, as bits (NaN-safe)
+        char text[kMaxText]{"--"};      // as last rendered
+        size_t severity{kNoSeverity};   // index into kSeverityStyles
     };
 
     std::array<Card, kCardCount> cards{};
-    lv_obj_t* status_label{};
+    GlyphText status;
+    char status_text[48]{};
+    lv_obj_t* cards_screen{};
+
+    // Trend screen: one series, shifted left a point at a time
+    const History* history{};
+    lv_obj_t* trend_screen{};
+    lv_obj_t* trend_title{};
+    lv_obj_t* chart{};
+    lv_chart_series_t* series{};
+    bool trend_active{};
+    History::Channel channel{};
+    const RangeMeta* range{&kRanges[0]};
+    uint32_t next_slot_end{};   // history time at which the next point is complete
+    int32_t y_min{};
+    int32_t y_max{};
+    std::array<float, kTrendPoints> fill_sum{};
+    std::array<uint16_t, kTrendPoints> fill_n{};
+    std::array<int32_t, kTrendPoints> trend_y{};   // the series' points, oldest first
+
+    // Display refresh timing, armed by a card or trend change
+    bool cards_changed{};
+    uint32_t cards_pending{};   // cards changed since the last refresh started
+    uint32_t cards_timing{};
+    bool chart_changed{};
+    bool timing_cards{};
+    bool timing_chart{};
+    int64_t refresh_start_us{};
+    UpdateStats update_stats{};
+    TrendStats trend_stats{};
+
+    void CountInvalidated(uint32_t px)
+    {
+        update_stats.last_invalidated_px += px;
+        update_stats.invalidated_px += px;
+    }
+
+    /** Bounds of `obj` as the area its change will redraw. */
+    void CountInvalidated(const lv_obj_t* obj)
+    {
+        lv_area_t area;
+        lv_obj_get_coords(obj, &area);
+        CountInvalidated(lv_area_get_size(&area));
+    }
+
+    void MakeTrendScreen()
+    {
+        trend_screen = lv_obj_create(nullptr);
+        lv_obj_set_style_bg_color(trend_screen, tokens::kBg, 0);
+        lv_obj_set_style_bg_opa(trend_screen, LV_OPA_COVER, 0);
+        lv_obj_set_style_pad_all(trend_screen, tokens::kPad, 0);
+        lv_obj_set_style_pad_row(trend_screen, tokens::kPad, 0);
+        lv_obj_set_flex_flow(trend_screen, LV_FLEX_FLOW_COLUMN);
+        lv_obj_clear_flag(trend_screen, LV_OBJ_FLAG_SCROLLABLE);
+
+        trend_title = lv_label_create(trend_screen);
+        lv_obj_add_style(trend_title, &style_title, 0);
+
+        chart = lv_chart_create(trend_screen);
+        lv_obj_set_size(chart, LV_PCT(100), 0);
+        lv_obj_set_flex_grow(chart, 1);
+        lv_obj_add_style(chart, &style_card, 0);
+        lv_chart_set_type(chart, LV_CHART_TYPE_LINE);
+        lv_chart_set_point_count(chart, kTrendPoints);
+        lv_chart_set_update_mode(chart, LV_CHART_UPDATE_MODE_SHIFT);
+        lv_chart_set_div_line_count(chart, 5, 7);
+        lv_obj_set_style_line_color(chart, tokens::kGrid, LV_PART_MAIN);
+        lv_obj_set_style_line_width(chart, 2, LV_PART_ITEMS);
+        lv_obj_set_style_size(chart, 0, 0, LV_PART_INDICATOR);  // no point markers
+        series = lv_chart_add_series(chart, tokens::kTrend, LV_CHART_AXIS_PRIMARY_Y);
+        trend_y.fill(LV_CHART_POINT_NONE);
+        lv_chart_set_ext_y_array(chart, series, trend_y.data());
+    }
+
+    static uint32_t Newest(const History::View& view)
+    {
+        const auto times = view.Times(History::Tier::kRaw);
+        return times.empty() ? 0 : times.back();
+    }
+
+    /** Mean of the rows of the current tier in [start, end), NaN if none. */
+    float SlotAverage(const History::View& view, uint32_t start, uint32_t end) const
+    {
+        const auto times = view.Times(range->tier);
+        const auto values = view.Values(range->tier, channel);
+        float sum = 0;
+        uint32_t n = 0;
+        for (size_t i = times.size(); i-- > 0 && times[i] >= start;) {
+            if (times[i] < end && !std::isnan(values[i])) {
+                sum += values[i];
+                ++n;
+            }
+        }
+        return n ? sum / n : NAN;
+    }
+
+    void SetRange(int32_t lo, int32_t hi)
+    {
+        // 10% headroom so a slow drift doesn't rescale on every point
+        const int32_t pad = std::max<int32_t>((hi - lo) / 10, 1);
+        y_min = lo - pad;
+        y_max = hi + pad;
+        lv_chart_set_range(chart, LV_CHART_AXIS_PRIMARY_Y, y_min, y_max);
+    }
+
+    void Append(float v)
+    {
+        int32_t y = LV_CHART_POINT_NONE;
+        if (!std::isnan(v)) {
+            y = static_cast<int32_t>(std::lround(v * kTrendScale));
+            if (y < y_min || y > y_max) {
+                SetRange(std::min(y, y_min), std::max(y, y_max));
+                ++trend_stats.range_changes;
+            }
+        }
+        lv_chart_set_next_value(chart, series, y);
+        chart_changed = true;
+    }
+
+    /**
+     * Averages every point of the range into fill_sum / fill_n in one pass
+     * over the tier; returns the end of the newest point. No LVGL calls:
+     * this is the part that needs the history view.
+     */
+    uint32_t Average(const History::View& view)
+    {
+        const uint32_t slot = range->slot_s;
+        const uint32_t end = Newest(view) / slot * slot;
+        const uint32_t span = slot * kTrendPoints;
+        const uint32_t start = end > span ? end - span : 0;
+
+        fill_sum.fill(0);
+        fill_n.fill(0);
+        const auto times = view.Times(range->tier);
+        const auto values = view.Values(range->tier, channel);
+        for (size_t i = 0; i < times.size(); ++i) {
+            if (times[i] < start || times[i] >= end || std::isnan(values[i])) continue;
+            const size_t k = (times[i] - start) / slot;
+            fill_sum[k] += values[i];
+            ++fill_n[k];
+        }
+        for (size_t k = 0; k < kTrendPoints; ++k) {
+            if (fill_n[k]) fill_sum[k] /= fill_n[k];
+        }
+        return end;
+    }
+
+    /** Replaces the whole series with Average()'s points and redraws once. */
+    void Load(uint32_t end)
+    {
+        int32_t lo = INT32_MAX;
+        int32_t hi = INT32_MIN;
+        for (size_t k = 0; k < kTrendPoints; ++k) {
+            // Points before the start of history stay empty
+            if (!fill_n[k]) {
+                trend_y[k] = LV_CHART_POINT_NONE;
+                continue;
+            }
+            const auto y = static_cast<int32_t>(std::lround(fill_sum[k] * kTrendScale));
+            trend_y[k] = y;
+            lo = std::min(lo, y);
+            hi = std::max(hi, y);
+        }
+        if (lo > hi) {
+            lo = 0;
+            hi = 100 * static_cast<int32_t>(kTrendScale);
+        }
+        SetRange(lo, hi);
+
+        // Oldest first from index 0; Append() shifts on from there
+        lv_chart_set_x_start_point(chart, series, 0);
+        lv_chart_refresh(chart);
+        chart_changed = true;
+        next_slot_end = end + range->slot_s;
+        ++trend_stats.fills;
+    }
+
+    static void OnRefresh(lv_event_t* e)
+    {
+        auto& self = *static_cast<Impl*>(lv_event_get_user_data(e));
+        const auto now = esp_timer_get_time();
+        if (lv_event_get_code(e) == LV_EVENT_REFR_START) {
+            self.timing_cards = self.cards_changed;
+            self.cards_timing = self.cards_pending;
+            self.cards_pending = 0;
+            self.timing_chart = self.chart_changed;
+            self.cards_changed = false;
+            self.chart_changed = false;
+            self.refresh_start_us = now;
+            return;
+        }
+        const int64_t took = now - self.refresh_start_us;
+
+        if (self.timing_cards) {
+            auto& st = self.update_stats;
+            st.last_refresh_us = took;
+            st.max_refresh_us = std::max(st.max_refresh_us, took);
+            st.refresh_us += took;
+            st.cards_redrawn += self.cards_timing;
+            ++st.refreshes;
+        }
+        if (self.timing_chart) {
+            auto& st = self.trend_stats;
+            st.last_refresh_us = took;
+            ++st.refreshes;
+            if (took > kTrendRefreshBudgetUs) {
+                ++st.over_budget;
+                if (took > st.max_refresh_us) {
+                    ESP_LOGW(TAG, "Trend refresh took %ld us (budget %ld us)",
+                             static_cast<long>(took),
+                             static_cast<long>(kTrendRefreshBudgetUs));
+                }
+            }
+            st.max_refresh_us = std::max(st.max_refresh_us, took);
+        }
+        self.timing_cards = self.timing_chart = false;
+    }
 
-    static Card MakeCard(lv_obj_t* parent, size_t index)
+    // Sprites of the big digits on the plain card and each severity colour,
+    // and of the status line's font; null when disabled.
+    std::unique_ptr<GlyphCache> value_glyphs;
+    std::unique_ptr<GlyphCache> status_glyphs;
+
+    /** Background of a card's value sprites: plain, or a severity colour. */
+    static size_t ValueBackground(size_t severity)
+    {
+        return severity == kNoSeverity ? 0 : severity + 1;
+    }
+
+    void MakeGlyphCaches()
+    {
+        const lv_color_t card_bgs[] = {
+            tokens::kSurface, tokens::kGood, tokens::kMod, tokens::kUsg, tokens::kUnhlt,
+        };
+        value_glyphs = std::make_unique<GlyphCache>(
+            tokens::kFontXl, tokens::kText, card_bgs, kValueCharset);
+
+        char printable[0x7F - 0x20];
+        for (size_t i = 0; i < sizeof(printable); ++i) {
+            printable[i] = static_cast<char>(0x20 + i);
+        }
+        const lv_color_t screen_bg[] = {tokens::kBg};
+        status_glyphs = std::make_unique<GlyphCache>(
+            tokens::kFontSm, tokens::kMuted, screen_bg,
+            std::string_view(printable, sizeof(printable)));
+    }
+
+    static Card MakeCard(lv_obj_t* parent, size_t index, const GlyphCache* glyphs)
     {
         Card c;
         const auto& meta = kCards[index];
@@ -204,15 +435,15 @@ struct Ui::Impl {
         lv_obj_clear_flag(c.container, LV_OBJ_FLAG_SCROLLABLE);
 
         auto* name = lv_label_create(c.container);
-        lv_label_set_text(name, meta.name);
+        lv_label_set_text(name, meta.label);
         lv_obj_add_style(name, &style_secondary, 0);
 
-        c.value_label = lv_label_create(c.container);
-        lv_label_set_text(c.value_label, "--");
-        lv_obj_add_style(c.value_label, &style_value, 0);
+        c.value.Create(c.container, glyphs, kValueChars);
+        lv_label_set_text(c.value.Label(), "--");
+        lv_obj_add_style(c.value.Label(), &style_value, 0);
 
         auto* unit = lv_label_create(c.container);
-        lv_label_set_text(unit, meta.unit);
+        lv_label_set_text(unit, meta.label_unit);
         lv_obj_add_style(unit, &style_secondary, 0);
 
         return c;
@@ -226,6 +457,7 @@ Ui::Ui() : impl_(std::make_unique<Impl>())
     InitStyles();
 
     auto* scr = lv_screen_active();
+    impl_->cards_screen = scr;
     lv_obj_set_style_bg_color(scr, tokens::kBg, 0);
     lv_obj_set_style_bg_opa(scr, LV_OPA_COVER, 0);
     lv_obj_set_style_pad_all(scr, tokens::kPad, 0);
@@ -245,53 +477,180 @@ Ui::Ui() : impl_(std::make_unique<Impl>())
         LV_GRID_ALIGN_CENTER, 0, 4,
         LV_GRID_ALIGN_CENTER, 0, 1);
 
+    if (kGlyphCache) {
+        impl_->MakeGlyphCaches();
+    }
+
     // Cards — placed directly on the grid, no intermediate row objects
     for (size_t i = 0; i < Impl::kCardCount; ++i) {
-        impl_->cards[i] = Impl::MakeCard(scr, i);
+        impl_->cards[i] = Impl::MakeCard(scr, i, impl_->value_glyphs.get());
         lv_obj_set_grid_cell(impl_->cards[i].container,
             LV_GRID_ALIGN_STRETCH, static_cast<int32_t>(i % 4), 1,
             LV_GRID_ALIGN_STRETCH, static_cast<int32_t>(1 + i / 4), 1);
     }
 
     // Status — spans all 4 columns
-    impl_->status_label = lv_label_create(scr);
-    lv_label_set_text(impl_->status_label, "Waiting for first reading...");
-    lv_obj_add_style(impl_->status_label, &style_status, 0);
-    lv_obj_set_grid_cell(impl_->status_label,
-        LV_GRID_ALIGN_CENTER, 0, 4,
-        LV_GRID_ALIGN_CENTER, 3, 1);
+    auto& status = impl_->status;
+    status.Create(scr, impl_->status_glyphs.get(), sizeof(impl_->status_text) - 1);
+    lv_label_set_text(status.Label(), "Waiting for first reading...");
+    lv_obj_add_style(status.Label(), &style_status, 0);
+    for (auto* obj : {status.Label(), status.Row()}) {
+        if (!obj) continue;
+        lv_obj_set_grid_cell(obj,
+            LV_GRID_ALIGN_CENTER, 0, 4,
+            LV_GRID_ALIGN_CENTER, 3, 1);
+    }
+
+    impl_->MakeTrendScreen();
+    auto* disp = lv_display_get_default();
+    lv_display_add_event_cb(disp, Impl::OnRefresh, LV_EVENT_REFR_START, impl_.get());
+    lv_display_add_event_cb(disp, Impl::OnRefresh, LV_EVENT_REFR_READY, impl_.get());
 }
 
 Ui::~Ui() = default;
 
 void Ui::UpdateMeasurements(const Sen55::Measurement& data)
 {
-    const std::array values = {
-        data.pm1_0, data.pm2_5, data.pm4_0, data.pm10,
-        data.temperature, data.humidity, data.voc_index, data.nox_index,
-    };
+    auto& st = impl_->update_stats;
+    st.last_invalidated_px = 0;
+    ++st.updates;
 
+    // Touch LVGL only for what differs from the last rendered state: a
+    // label whose text changed, a card whose severity band changed.
     for (size_t i = 0; i < Impl::kCardCount; ++i) {
-        auto text = (i >= 6)
-            ? std::to_string(static_cast<int>(values[i]))
-            : ([&] {
-                char buf[16];
-                std::snprintf(buf, sizeof(buf), "%.1f", values[i]);
-                return std::string(buf);
-            })();
-        lv_label_set_text(impl_->cards[i].value_label, text.c_str());
-
-        // Swap severity style (like toggling CSS classes)
-        for (auto* sev : kSeverityStyles) {
-            lv_obj_remove_style(impl_->cards[i].container, sev, 0);
+        auto& card = impl_->cards[i];
+        const auto& meta = kCards[i];
+        const float value = data.*meta.member;
+        const auto bits = std::bit_cast<uint32_t>(value);
+        if (bits == card.value_bits) continue;
+        card.value_bits = bits;
+
+        char text[Impl::kMaxText];
+        sen55_metrics::FormatValue(text, sizeof(text), meta, value);
+        const bool text_changed = std::strcmp(text, card.text) != 0;
+        const auto level = sen55_metrics::Severity(meta, value);
+        const bool level_changed = level != card.severity;
+        if (!text_changed && !level_changed) continue;
+
+        if (level_changed) {
+            if (card.severity != Impl::kNoSeverity) {
+                lv_obj_remove_style(card.container, kSeverityStyles[card.severity], 0);
+            }
+            lv_obj_add_style(card.container, kSeverityStyles[level], 0);
+            card.severity = level;
+            impl_->CountInvalidated(card.container);
+            ++st.styles_changed;
         }
-        auto level = MetricSeverity(i, values[i]);
-        lv_obj_add_style(impl_->cards[i].container,
-                         kSeverityStyles[level], 0);
+        if (text_changed) {
+            std::memcpy(card.text, text, sizeof(text));
+            ++st.labels_changed;
+        }
+        // Sprites carry the card colour, so a new band redraws them too
+        if (card.value.SetText(card.text, Impl::ValueBackground(level)) && !level_changed) {
+            impl_->CountInvalidated(card.value.ChangedPx());
+        }
+        ++impl_->cards_pending;
     }
+    impl_->cards_changed |= st.last_invalidated_px != 0;
 }
 
 void Ui::SetStatus(std::string_view text)
 {
-    lv_label_set_text(impl_->status_label, std::string(text).c_str());
+    auto& d = *impl_;
+    const size_t len = std::min(text.size(), sizeof(d.status_text) - 1);
+    if (text.substr(0, len) == std::string_view(d.status_text)) return;
+
+    std::memcpy(d.status_text, text.data(), len);
+    d.status_text[len] = '\0';
+    if (d.status.SetText(d.status_text, 0)) {
+        d.CountInvalidated(d.status.ChangedPx());
+        d.cards_changed = true;
+    }
+}
+
+Ui::UpdateStats Ui::GetUpdateStats() const
+{
+    return impl_->update_stats;
+}
+
+bool Ui::UsesGlyphCache() const
+{
+    return impl_->value_glyphs != nullptr;
+}
+
+void Ui::SetHistory(const History* history)
+{
+    impl_->history = history;
+}
+
+void Ui::ShowCards()
+{
+    impl_->trend_active = false;
+    lv_screen_load(impl_->cards_screen);
+}
+
+void Ui::ShowTrend(History::Channel channel, TrendRange range)
+{
+    auto& d = *impl_;
+    if (!d.history) return;
+
+    d.channel = channel;
+    d.range = &kRanges[static_cast<size_t>(range)];
+    d.trend_active = true;
+
+    const auto& meta = kCards[kCardOfChannel[static_cast<size_t>(channel)]];
+    char title[64];
+    std::snprintf(title, sizeof(title), "%s - %s (%s)", meta.label, d.range->label,
+                  meta.label_unit);
+    lv_label_set_text(d.trend_title, title);
+
+    uint32_t end;
+    {
+        const auto view = d.history->Read();
+        end = d.Average(view);
+    }
+    d.Load(end);
+    lv_screen_load(d.trend_screen);
+}
+
+void Ui::UpdateTrend()
+{
+    auto& d = *impl_;
+    if (!d.trend_active || !d.history) return;
+
+    // Points are averaged under the history lock and drawn after it is
+    // released, so LVGL never holds up the history task
+    const uint32_t slot = d.range->slot_s;
+    bool reload = false;
+    uint32_t end = 0;
+    size_t n = 0;
+    {
+        const auto view = d.history->Read();
+        const uint32_t newest = Impl::Newest(view);
+        if (newest < d.next_slot_end) return;
+
+        // After a long gap, reloading is cheaper than appending every slot
+        reload = newest - d.next_slot_end >= slot * kTrendPoints;
+        if (reload) {
+            end = d.Average(view);
+        } else {
+            for (uint32_t e = d.next_slot_end; newest >= e; e += slot) {
+                d.fill_sum[n++] = d.SlotAverage(view, e - slot, e);
+            }
+        }
+    }
+    if (reload) {
+        d.Load(end);
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        d.Append(d.fill_sum[i]);
+        d.next_slot_end += slot;
+        ++d.trend_stats.points;
+    }
+}
+
+Ui::TrendStats Ui::GetTrendStats() const
+{
+    return impl_->trend_stats;
 }
@@ -1,12 +1,48 @@
 #pragma once
 
+#include "history.hpp"
 #include "sen55.hpp"
 
+#include <cstdint>
 #include <memory>
 #include <string_view>
 
 class Ui {
 public:
+    enum class TrendRange { kHour, kDay };
+
+    /**
+     * Longest a display refresh that includes a trend update may take:
+     * under one LVGL refresh period (33 ms), so a new point never costs
+     * the 800x480 panel a frame. Refreshes over budget are counted and
+     * logged.
+     */
+    static constexpr int64_t kTrendRefreshBudgetUs = 30'000;
+
+    /** What UpdateMeasurements()/SetStatus() changed, and what it cost to draw. */
+    struct UpdateStats {
+        uint32_t updates;
+        uint32_t labels_changed;       // value labels whose text differed
+        uint32_t styles_changed;       // cards that moved to another severity band
+        uint64_t invalidated_px;       // bounds of changed objects, cumulative
+        uint32_t last_invalidated_px;  // ... for the latest update
+        uint32_t refreshes;            // display refreshes that drew a card change
+        uint32_t cards_redrawn;        // changed cards drawn by those refreshes
+        int64_t refresh_us;            // cumulative; refresh_us / cards_redrawn per card
+        int64_t last_refresh_us;
+        int64_t max_refresh_us;
+    };
+
+    struct TrendStats {
+        uint32_t fills;            // full series loads (screen entry, long gaps)
+        uint32_t points;           // points appended incrementally
+        uint32_t range_changes;    // y-axis widened
+        uint32_t refreshes;        // display refreshes that drew a trend change
+        uint32_t over_budget;      // ... of which took over kTrendRefreshBudgetUs
+        int64_t last_refresh_us;
+        int64_t max_refresh_us;
+    };
+
     Ui();
     ~Ui();
 
@@ -15,8 +51,26 @@ public:
     Ui(Ui&&) = delete;
     Ui& operator=(Ui&&) = delete;
 
+    /** Redraws only the labels and card colours that changed. Never allocates. */
     void UpdateMeasurements(const Sen55::Measurement& data);
     void SetStatus(std::string_view text);
+    UpdateStats GetUpdateStats() const;
+
+    /** Whether values and status are drawn from pre-rendered glyph sprites. */
+    bool UsesGlyphCache() const;
+
+    /** Source for the trend screen. Must outlive the Ui. */
+    void SetHistory(const History* history);
+
+    void ShowCards();
+
+    /** Switches to a chart of one metric over the last hour or day. */
+    void ShowTrend(History::Channel channel, TrendRange range);
+
+    /** Appends any points completed since the last call. Call per reading. */
+    void UpdateTrend();
+
+    TrendStats GetTrendStats() const;
 
 private:
     struct Impl;
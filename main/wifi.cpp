@@ -1,15 +1,20 @@
 #include "wifi.hpp"
+#include "boot_profile.hpp"
 #include "credentials.h"
 
 #include <cstring>
 #include <algorithm>
 
+#include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
 #include "esp_netif.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "nvs.h"
 #include "nvs_flash.h"
 
 namespace {
@@ -19,41 +24,229 @@ const char *TAG = "wifi";
 constexpr int CONNECTED_BIT = BIT0;
 constexpr int FAIL_BIT      = BIT1;
 
+constexpr const char *kNvsNamespace = "wifi";
+constexpr const char *kNvsKeyAp = "ap";
+constexpr const char *kNvsKeyIp = "ip";
+
+/// Last AP joined, so the next connect can skip the all-channel scan.
+struct ApHint {
+    uint8_t bssid[6];
+    uint8_t channel;
+};
+
+/// Last DHCP lease, reused as a static address when enabled.
+struct IpHint {
+    esp_netif_ip_info_t ip;
+    esp_ip4_addr_t dns;
+};
+
 EventGroupHandle_t s_events{};
+StaticEventGroup_t s_events_buf{};
+esp_netif_t *s_netif{};
+esp_timer_handle_t s_retry_timer{};
+wifi_config_t s_config{};
 bool s_connected{false};
 int  s_retry_count{0};
 
-// Backoff: immediate, 1s, 5s, 10s, 30s cap
+ApHint s_ap_hint{};
+bool s_have_ap_hint{false};
+bool s_using_ap_hint{false};   // current attempt targets the cached AP
+bool s_using_ip_hint{false};   // DHCP client stopped, cached address set
+
+int64_t s_attempt_start_us{};  // start of the current outage, or boot
+wifi_stats_t s_stats{};
+
+/* ── NVS hint cache ─────────────────────────────────────────────────── */
+
+template <typename T>
+bool load_hint(const char *key, T *out)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(kNvsNamespace, NVS_READONLY, &nvs) != ESP_OK) return false;
+    size_t len = sizeof(T);
+    const bool ok = nvs_get_blob(nvs, key, out, &len) == ESP_OK && len == sizeof(T);
+    nvs_close(nvs);
+    return ok;
+}
+
+/// Writes only when the value differs from what is stored (flash wear).
+template <typename T>
+void save_hint(const char *key, const T &value)
+{
+    T stored{};
+    if (load_hint(key, &stored) && std::memcmp(&stored, &value, sizeof(T)) == 0) return;
+
+    nvs_handle_t nvs;
+    if (nvs_open(kNvsNamespace, NVS_READWRITE, &nvs) != ESP_OK) return;
+    if (nvs_set_blob(nvs, key, &value, sizeof(T)) == ESP_OK) {
+        nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+}
+
+void erase_hint(const char *key)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(kNvsNamespace, NVS_READWRITE, &nvs) != ESP_OK) return;
+    if (nvs_erase_key(nvs, key) == ESP_OK) {
+        nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+}
+
+/// Points the STA config at the cached AP (channel + BSSID), or back at a
+/// full scan by SSID.
+void apply_ap_hint(bool use)
+{
+    s_using_ap_hint = use && s_have_ap_hint;
+    s_config.sta.bssid_set = s_using_ap_hint;
+    s_config.sta.channel = s_using_ap_hint ? s_ap_hint.channel : 0;
+    if (s_using_ap_hint) {
+        std::memcpy(s_config.sta.bssid, s_ap_hint.bssid, sizeof(s_ap_hint.bssid));
+    }
+    esp_wifi_set_config(WIFI_IF_STA, &s_config);
+}
+
+void apply_ip_hint()
+{
+#if CONFIG_AQM_WIFI_CACHE_IP
+    IpHint hint{};
+    if (!load_hint(kNvsKeyIp, &hint) || hint.ip.ip.addr == 0) return;
+
+    esp_netif_dhcpc_stop(s_netif);
+    if (esp_netif_set_ip_info(s_netif, &hint.ip) != ESP_OK) {
+        esp_netif_dhcpc_start(s_netif);
+        return;
+    }
+    esp_netif_dns_info_t dns{};
+    dns.ip.type = ESP_IPADDR_TYPE_V4;
+    dns.ip.u_addr.ip4 = hint.dns;
+    esp_netif_set_dns_info(s_netif, ESP_NETIF_DNS_MAIN, &dns);
+    s_using_ip_hint = true;
+    ESP_LOGI(TAG, "Using cached address " IPSTR, IP2STR(&hint.ip.ip));
+#endif
+}
+
+/// Back to DHCP after the cached address failed to get us online.
+void drop_ip_hint()
+{
+    if (!s_using_ip_hint) return;
+    s_using_ip_hint = false;
+    esp_netif_dhcpc_start(s_netif);
+    erase_hint(kNvsKeyIp);
+    ESP_LOGW(TAG, "Cached address dropped, back to DHCP");
+}
+
+/* ── Reconnect scheduler ────────────────────────────────────────────── */
+
+// Exponential backoff from 500 ms up to the configured cap, first retry
+// immediate. Each delay is drawn from [d/2, d] so a fleet that lost the
+// same AP doesn't retry in lockstep.
 int retry_delay_ms()
 {
-    constexpr int delays[] = {0, 1000, 5000, 10000, 30000};
-    constexpr int n = sizeof(delays) / sizeof(delays[0]);
-    int idx = std::min(s_retry_count, n - 1);
-    return delays[idx];
+    if (s_retry_count == 0) return 0;
+    const int shift = std::min(s_retry_count - 1, 16);
+    const int d = std::min(500 << shift, CONFIG_AQM_WIFI_BACKOFF_MAX_MS);
+    return d / 2 + static_cast<int>(esp_random() % (d / 2 + 1));
+}
+
+void connect_now()
+{
+    ++s_stats.attempts;
+    esp_wifi_connect();
+}
+
+void on_retry_timer(void * /*arg*/)
+{
+    connect_now();
 }
 
+/// Runs in the event loop task: decides the next attempt and returns at
+/// once; the retry itself is fired from an esp_timer.
+void schedule_reconnect(unsigned reason, bool was_connected)
+{
+    // Lost a working link: straight back to the AP we were on
+    if (was_connected && s_have_ap_hint) {
+        ESP_LOGW(TAG, "Disconnected (reason %u) — rejoining cached AP", reason);
+        apply_ap_hint(true);
+        connect_now();
+        return;
+    }
+    // A failed attempt at the cached AP falls back to a full scan, and
+    // the cached address to DHCP, before backing off.
+    if (s_using_ap_hint) {
+        ESP_LOGW(TAG, "Cached AP failed (reason %u), full scan next", reason);
+        apply_ap_hint(false);
+        drop_ip_hint();
+        connect_now();
+        return;
+    }
+
+    const int delay = retry_delay_ms();
+    s_retry_count++;
+    ESP_LOGW(TAG, "Disconnected (reason %u) — reconnecting in %d ms (attempt %d)",
+             reason, delay, s_retry_count);
+    esp_timer_stop(s_retry_timer);  // at most one retry pending
+    if (delay == 0) {
+        connect_now();
+    } else {
+        esp_timer_start_once(s_retry_timer, static_cast<uint64_t>(delay) * 1000);
+    }
+}
+
+/* ── Events ─────────────────────────────────────────────────────────── */
+
 void event_handler(void * /*arg*/, esp_event_base_t base,
                    int32_t id, void *data)
 {
     if (base == WIFI_EVENT && id == WIFI_EVENT_STA_START) {
-        esp_wifi_connect();
+        connect_now();
+    } else if (base == WIFI_EVENT && id == WIFI_EVENT_STA_CONNECTED) {
+        auto *event = static_cast<wifi_event_sta_connected_t *>(data);
+        std::memcpy(s_ap_hint.bssid, event->bssid, sizeof(s_ap_hint.bssid));
+        s_ap_hint.channel = event->channel;
     } else if (base == WIFI_EVENT && id == WIFI_EVENT_STA_DISCONNECTED) {
-        s_connected = false;
-        int delay = retry_delay_ms();
-        s_retry_count++;
-        ESP_LOGW(TAG, "Disconnected — reconnecting in %d ms (attempt %d)",
-                 delay, s_retry_count);
-        if (delay > 0) {
-            vTaskDelay(pdMS_TO_TICKS(delay));
+        auto *event = static_cast<wifi_event_sta_disconnected_t *>(data);
+        const bool was_connected = s_connected;
+        if (was_connected) {
+            s_connected = false;
+            ++s_stats.disconnects;
+            s_attempt_start_us = esp_timer_get_time();
         }
-        esp_wifi_connect();
+        schedule_reconnect(event->reason, was_connected);
         xEventGroupSetBits(s_events, FAIL_BIT);
     } else if (base == IP_EVENT && id == IP_EVENT_STA_GOT_IP) {
         auto *event = static_cast<ip_event_got_ip_t *>(data);
-        ESP_LOGI(TAG, "Connected — IP: " IPSTR, IP2STR(&event->ip_info.ip));
+        const int64_t took = esp_timer_get_time() - s_attempt_start_us;
+        s_stats.last_time_to_ip_us = took;
+        if (s_stats.connects == 0) {
+            s_stats.boot_time_to_ip_us = took;
+            boot_profile_mark(BootPhase::kWifiIp);
+        }
+        ++s_stats.connects;
+        if (s_using_ap_hint) ++s_stats.fast_connects;
+        ESP_LOGI(TAG, "Connected — IP: " IPSTR " in %lld ms (%s, %s)",
+                 IP2STR(&event->ip_info.ip), static_cast<long long>(took / 1000),
+                 s_using_ap_hint ? "cached AP" : "scan",
+                 s_using_ip_hint ? "cached IP" : "DHCP");
+
         s_connected = true;
         s_retry_count = 0;
         xEventGroupSetBits(s_events, CONNECTED_BIT);
+
+#if CONFIG_AQM_WIFI_FAST_RECONNECT
+        // Used from the next disconnect; changing the config now would
+        // drop the link.
+        save_hint(kNvsKeyAp, s_ap_hint);
+        s_have_ap_hint = true;
+#endif
+#if CONFIG_AQM_WIFI_CACHE_IP
+        if (!s_using_ip_hint) {
+            esp_netif_dns_info_t dns{};
+            esp_netif_get_dns_info(s_netif, ESP_NETIF_DNS_MAIN, &dns);
+            save_hint(kNvsKeyIp, IpHint{event->ip_info, dns.ip.u_addr.ip4});
+        }
+#endif
     }
 }
 
@@ -61,6 +254,8 @@ void event_handler(void * /*arg*/, esp_event_base_t base,
 
 esp_err_t wifi_init()
 {
+    s_attempt_start_us = esp_timer_get_time();
+
     // NVS (required by WiFi)
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES ||
@@ -70,11 +265,20 @@ esp_err_t wifi_init()
     }
     ESP_ERROR_CHECK(ret);
 
-    s_events = xEventGroupCreate();
+    s_events = xEventGroupCreateStatic(&s_events_buf);
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = on_retry_timer,
+        .arg = nullptr,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "wifi_retry",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_retry_timer));
 
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
+    s_netif = esp_netif_create_default_wifi_sta();
 
     wifi_init_config_t init_cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&init_cfg));
@@ -84,15 +288,24 @@ esp_err_t wifi_init()
     ESP_ERROR_CHECK(esp_event_handler_instance_register(
         IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, nullptr, nullptr));
 
-    wifi_config_t wifi_cfg{};
-    std::strncpy(reinterpret_cast<char *>(wifi_cfg.sta.ssid),
-                 WIFI_SSID, sizeof(wifi_cfg.sta.ssid));
-    std::strncpy(reinterpret_cast<char *>(wifi_cfg.sta.password),
-                 WIFI_PASS, sizeof(wifi_cfg.sta.password));
-    wifi_cfg.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+    std::strncpy(reinterpret_cast<char *>(s_config.sta.ssid),
+                 WIFI_SSID, sizeof(s_config.sta.ssid));
+    std::strncpy(reinterpret_cast<char *>(s_config.sta.password),
+                 WIFI_PASS, sizeof(s_config.sta.password));
+    s_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
 
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_cfg));
+#if CONFIG_AQM_WIFI_FAST_RECONNECT
+    s_have_ap_hint = load_hint(kNvsKeyAp, &s_ap_hint);
+#endif
+    apply_ap_hint(true);
+    if (s_using_ap_hint) {
+        apply_ip_hint();
+        ESP_LOGI(TAG, "Cached AP %02x:%02x:%02x:%02x:%02x:%02x on channel %u",
+                 s_ap_hint.bssid[0], s_ap_hint.bssid[1], s_ap_hint.bssid[2],
+                 s_ap_hint.bssid[3], s_ap_hint.bssid[4], s_ap_hint.bssid[5],
+                 s_ap_hint.channel);
+    }
     ESP_ERROR_CHECK(esp_wifi_start());
 
     ESP_LOGI(TAG, "Connecting to %s ...", WIFI_SSID);
@@ -113,3 +326,8 @@ bool wifi_is_connected()
 {
     return s_connected;
 }
+
+wifi_stats_t wifi_get_stats()
+{
+    return s_stats;
+}
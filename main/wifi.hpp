@@ -2,8 +2,23 @@
 
 #include "esp_err.h"
 
+#include <cstdint>
+
+/// Connection health since boot.
+struct wifi_stats_t {
+    uint32_t attempts;            // esp_wifi_connect() calls
+    uint32_t connects;            // got an IP
+    uint32_t fast_connects;       // ... joining the cached AP without a scan
+    uint32_t disconnects;         // lost an established link
+    int64_t boot_time_to_ip_us;   // wifi_init() to the first IP
+    int64_t last_time_to_ip_us;   // start of the latest outage (or boot) to IP
+};
+
 /// Initialise NVS, netif, event loop, WiFi STA and start connection.
-/// Auto-reconnects on disconnect with backoff.
+/// Auto-reconnects on disconnect with jittered backoff, scheduled on a
+/// timer so the event loop never blocks. The last AP's channel and BSSID
+/// (and optionally the DHCP lease) are cached in NVS so boot and reconnect
+/// skip the scan (and DHCP).
 esp_err_t wifi_init();
 
 /// Block until connected or timeout. Returns true if connected.
@@ -11,3 +26,5 @@ bool wifi_wait_connected(int timeout_ms = 15000);
 
 /// True if WiFi STA currently has an IP.
 bool wifi_is_connected();
+
+wifi_stats_t wifi_get_stats();